@@ -104,7 +104,9 @@ Basic_Settings::Basic_Settings()
 #else
   compression_method(File_Blocks_Index< Uint31_Index >::ZLIB_COMPRESSION),
 #endif
-  map_compression_method(File_Blocks_Index< Uint31_Index >::NO_COMPRESSION)
+  map_compression_method(File_Blocks_Index< Uint31_Index >::NO_COMPRESSION),
+  max_write_threads(1),
+  build_parent_index(false)
 {}
 
 Basic_Settings& basic_settings()
@@ -143,6 +145,15 @@ Osm_Base_Settings::Osm_Base_Settings()
   RELATION_KEYS(new OSM_File_Properties< Uint32_Index >
       ("relation_keys", 512*1024, 0)),
 
+  NODE_PARENT_WAYS(new OSM_File_Properties< Node::Id_Type >
+      ("node_parent_ways", 512*1024, 0)),
+  NODE_PARENT_RELATIONS(new OSM_File_Properties< Node::Id_Type >
+      ("node_parent_relations", 512*1024, 0)),
+  WAY_PARENT_RELATIONS(new OSM_File_Properties< Way::Id_Type >
+      ("way_parent_relations", 512*1024, 0)),
+  RELATION_PARENT_RELATIONS(new OSM_File_Properties< Relation::Id_Type >
+      ("relation_parent_relations", 512*1024, 0)),
+
   shared_name(basic_settings().shared_name_base + "_osm_base"),
   max_num_processes(20),
   purge_timeout(900),
@@ -156,6 +167,13 @@ const Osm_Base_Settings& osm_base_settings()
   return obj;
 }
 
+bool has_parent_index(const std::string& db_dir)
+{
+  const File_Properties& file_prop = *osm_base_settings().NODE_PARENT_WAYS;
+  return file_exists(db_dir + file_prop.get_file_name_trunk()
+      + file_prop.get_data_suffix() + file_prop.get_index_suffix());
+}
+
 //-----------------------------------------------------------------------------
 
 Area_Settings::Area_Settings()
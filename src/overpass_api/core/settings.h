@@ -42,6 +42,12 @@ struct Basic_Settings
   uint32 compression_method;
   uint32 map_compression_method;
 
+  // The number of threads that write the files of an update concurrently
+  uint32 max_write_threads;
+
+  // Whether a database built from scratch gets the index from members to their parents
+  bool build_parent_index;
+
   Basic_Settings();
 };
 
@@ -62,6 +68,12 @@ struct Osm_Base_Settings
   File_Properties* RELATION_TAGS_GLOBAL;
   File_Properties* RELATION_KEYS;
 
+  // The optional index from the ids of members to the ids of their parents
+  File_Properties* NODE_PARENT_WAYS;
+  File_Properties* NODE_PARENT_RELATIONS;
+  File_Properties* WAY_PARENT_RELATIONS;
+  File_Properties* RELATION_PARENT_RELATIONS;
+
   std::string shared_name;
   uint max_num_processes;
   uint purge_timeout;
@@ -146,6 +158,9 @@ const Area_Settings& area_settings();
 const Meta_Settings& meta_settings();
 const Attic_Settings& attic_settings();
 
+// Whether the database in db_dir has the index from members to their parents
+bool has_parent_index(const std::string& db_dir);
+
 void show_mem_status();
 
 
@@ -0,0 +1,243 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "type_relation.h"
+#include "type_way.h"
+
+#include <iostream>
+#include <vector>
+
+
+void check(bool condition, const std::string& what)
+{
+  if (condition)
+    std::cout<<"OK"<<'\n';
+  else
+    std::cout<<"failed: "<<what<<'\n';
+}
+
+
+bool equal_ways(const Way_Skeleton& lhs, const Way_Skeleton& rhs)
+{
+  return lhs.id == rhs.id && lhs.nds == rhs.nds && lhs.geometry == rhs.geometry;
+}
+
+
+bool equal_relations(const Relation_Skeleton& lhs, const Relation_Skeleton& rhs)
+{
+  return lhs.id == rhs.id && lhs.members == rhs.members
+      && lhs.node_idxs == rhs.node_idxs && lhs.way_idxs == rhs.way_idxs;
+}
+
+
+void check_way_view(const Way_Skeleton& skel, void* data)
+{
+  Way_Skeleton_View view(data);
+  bool same = (view.id() == skel.id.val() && view.nds_size() == skel.nds.size()
+      && view.geometry_size() == skel.geometry.size());
+  Way_Skeleton_View::Nd_Reader reader = view.nds();
+  for (std::vector< Node::Id_Type >::size_type i = 0; same && i < skel.nds.size(); ++i)
+    same = (reader.next() == skel.nds[i]);
+  check(same, "view");
+}
+
+
+// Writes the skeleton in the compact format and reads it back
+void round_trip_compact(const Way_Skeleton& skel)
+{
+  std::vector< uint8 > buf(skel.size_of() + 16, 0xcc);
+  skel.to_data(&buf[0]);
+  check(Way_Skeleton_Format::is_compact(&buf[0]), "is_compact");
+  check(Way_Skeleton::size_of(&buf[0]) == skel.size_of(), "size_of");
+  check(buf[skel.size_of()] == 0xcc, "written size");
+  check(equal_ways(Way_Skeleton(&buf[0]), skel), "decoded way");
+  check_way_view(skel, &buf[0]);
+}
+
+
+// Builds the legacy representation by hand and reads it
+void read_legacy(const Way_Skeleton& skel)
+{
+  std::vector< uint8 > buf(8 + 8*skel.nds.size() + 8*skel.geometry.size());
+  *(uint32*)&buf[0] = skel.id.val();
+  *(uint16*)&buf[4] = skel.nds.size();
+  *(uint16*)&buf[6] = skel.geometry.size();
+  uint8* pos = &buf[8];
+  for (std::vector< Node::Id_Type >::const_iterator it = skel.nds.begin(); it != skel.nds.end(); ++it)
+  {
+    *(uint64*)pos = it->val();
+    pos += 8;
+  }
+  for (std::vector< Quad_Coord >::const_iterator it = skel.geometry.begin(); it != skel.geometry.end(); ++it)
+  {
+    *(uint32*)pos = it->ll_upper;
+    *(uint32*)(pos + 4) = it->ll_lower;
+    pos += 8;
+  }
+
+  check(!Way_Skeleton_Format::is_compact(&buf[0]), "is_compact");
+  check(Way_Skeleton::size_of(&buf[0]) == buf.size(), "size_of");
+  Way_Skeleton decoded(&buf[0]);
+  check(equal_ways(decoded, skel), "decoded way");
+  check_way_view(skel, &buf[0]);
+  round_trip_compact(decoded);
+}
+
+
+void round_trip_compact(const Relation_Skeleton& skel)
+{
+  std::vector< uint8 > buf(skel.size_of() + 16, 0xcc);
+  skel.to_data(&buf[0]);
+  check(Relation_Skeleton_Format::is_compact(&buf[0]), "is_compact");
+  check(Relation_Skeleton::size_of(&buf[0]) == skel.size_of(), "size_of");
+  check(buf[skel.size_of()] == 0xcc, "written size");
+  check(equal_relations(Relation_Skeleton(&buf[0]), skel), "decoded relation");
+}
+
+
+void read_legacy(const Relation_Skeleton& skel)
+{
+  std::vector< uint8 > buf(16 + 12*skel.members.size() + 4*skel.node_idxs.size() + 4*skel.way_idxs.size());
+  *(uint32*)&buf[0] = skel.id.val();
+  *(uint32*)&buf[4] = skel.members.size();
+  *(uint32*)&buf[8] = skel.node_idxs.size();
+  *(uint32*)&buf[12] = skel.way_idxs.size();
+  uint8* pos = &buf[16];
+  for (std::vector< Relation_Entry >::const_iterator it = skel.members.begin(); it != skel.members.end(); ++it)
+  {
+    *(uint64*)pos = it->ref.val();
+    *(uint32*)(pos + 8) = (it->role & 0xffffff) | (it->type<<24);
+    pos += 12;
+  }
+  for (std::vector< Uint31_Index >::const_iterator it = skel.node_idxs.begin(); it != skel.node_idxs.end(); ++it)
+  {
+    *(uint32*)pos = it->val();
+    pos += 4;
+  }
+  for (std::vector< Uint31_Index >::const_iterator it = skel.way_idxs.begin(); it != skel.way_idxs.end(); ++it)
+  {
+    *(uint32*)pos = it->val();
+    pos += 4;
+  }
+
+  check(!Relation_Skeleton_Format::is_compact(&buf[0]), "is_compact");
+  check(Relation_Skeleton::size_of(&buf[0]) == buf.size(), "size_of");
+  Relation_Skeleton decoded(&buf[0]);
+  check(equal_relations(decoded, skel), "decoded relation");
+  round_trip_compact(decoded);
+}
+
+
+Relation_Entry make_entry(uint64 ref, uint32 type, uint32 role)
+{
+  Relation_Entry result;
+  result.ref = ref;
+  result.type = type;
+  result.role = role;
+  return result;
+}
+
+
+int main(int argc, char* args[])
+{
+  if (argc < 2)
+  {
+    std::cout<<"Usage: "<<args[0]<<" test_to_execute\n";
+    return 0;
+  }
+  std::string test_to_execute = args[1];
+
+  if (test_to_execute.empty() || test_to_execute == "1")
+  {
+    std::cout<<"Empty way:\n";
+    Way_Skeleton skel(Way::Id_Type(17u));
+    round_trip_compact(skel);
+    read_legacy(skel);
+  }
+
+  if (test_to_execute.empty() || test_to_execute == "2")
+  {
+    std::cout<<"Way with ascending and descending node ids:\n";
+    Way_Skeleton skel(Way::Id_Type(496u));
+    skel.nds.push_back(1000000000ull);
+    skel.nds.push_back(1000000001ull);
+    // A negative zigzag delta
+    skel.nds.push_back(5ull);
+    skel.nds.push_back(1ull);
+    skel.nds.push_back(0xffffffffffull);
+    // Closed way: a large negative delta back to the first node
+    skel.nds.push_back(1000000000ull);
+    round_trip_compact(skel);
+    read_legacy(skel);
+  }
+
+  if (test_to_execute.empty() || test_to_execute == "3")
+  {
+    std::cout<<"Way with geometry:\n";
+    Way_Skeleton skel(Way::Id_Type(0xfffffffeu));
+    skel.nds.push_back(3ull);
+    skel.nds.push_back(2ull);
+    skel.nds.push_back(1ull);
+    skel.geometry.push_back(Quad_Coord(0x80000000u, 0x12345678u));
+    // Negative deltas in both halves
+    skel.geometry.push_back(Quad_Coord(0x7fffffffu, 0u));
+    skel.geometry.push_back(Quad_Coord(0xffffffffu, 0xffffffffu));
+    round_trip_compact(skel);
+    read_legacy(skel);
+  }
+
+  if (test_to_execute.empty() || test_to_execute == "4")
+  {
+    std::cout<<"Size of a copy after a change:\n";
+    Way_Skeleton skel(Way::Id_Type(1u));
+    skel.nds.push_back(1ull);
+    uint32 size = skel.size_of();
+    Way_Skeleton copy(skel);
+    copy.nds.push_back(0xffffffffffull);
+    check(copy.size_of() > size, "size_of of the changed copy");
+    round_trip_compact(copy);
+  }
+
+  if (test_to_execute.empty() || test_to_execute == "5")
+  {
+    std::cout<<"Empty relation:\n";
+    Relation_Skeleton skel(Relation::Id_Type(8u));
+    round_trip_compact(skel);
+    read_legacy(skel);
+  }
+
+  if (test_to_execute.empty() || test_to_execute == "6")
+  {
+    std::cout<<"Relation with members and indices:\n";
+    Relation_Skeleton skel(Relation::Id_Type(0xfffffffeu));
+    skel.members.push_back(make_entry(1000000000ull, Relation_Entry::WAY, 0));
+    // A negative zigzag delta
+    skel.members.push_back(make_entry(7ull, Relation_Entry::NODE, 1));
+    skel.members.push_back(make_entry(0xffffffffffull, Relation_Entry::RELATION, 0xffffff));
+    skel.members.push_back(make_entry(7ull, Relation_Entry::NODE, 300));
+    skel.node_idxs.push_back(0x7fffffffu);
+    skel.node_idxs.push_back(0u);
+    skel.way_idxs.push_back(0x80000010u);
+    skel.way_idxs.push_back(0x10u);
+    skel.way_idxs.push_back(0x80000020u);
+    round_trip_compact(skel);
+    read_legacy(skel);
+  }
+
+  return 0;
+}
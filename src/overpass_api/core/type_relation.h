@@ -21,6 +21,7 @@
 
 #include "basic_types.h"
 #include "index_computations.h"
+#include "varint.h"
 
 #include <cstring>
 #include <map>
@@ -100,6 +101,104 @@ struct Relation_Equal_Id {
 struct Relation_Delta;
 
 
+/* Relation_Skeleton has two on-disk formats that can be mixed within a file:
+ *
+ * The legacy format stores the id, the uint32 numbers of members, node indexes, and way indexes,
+ * then each member as uint64 ref and uint32 role with the type in its upper byte,
+ * and then the node indexes and way indexes as uint32.
+ *
+ * The compact format stores COMPACT_MARK instead of the number of members. It is followed
+ * by the numbers of node indexes and way indexes, the uint32 size of the payload in bytes,
+ * and the payload. The payload starts with the number of members as varint. Then follow for each
+ * member the difference to the previous ref as zigzag varint and role and type as one varint,
+ * and then the differences of consecutive node indexes and way indexes as zigzag varints.
+ * The writer always uses the compact format. */
+namespace Relation_Skeleton_Format
+{
+  const uint32 COMPACT_MARK = 0xffffffff;
+
+  inline bool is_compact(const void* data) { return *((const uint32*)data + 1) == COMPACT_MARK; }
+  inline uint32 node_idxs_size(const void* data) { return *((const uint32*)data + 2); }
+  inline uint32 way_idxs_size(const void* data) { return *((const uint32*)data + 3); }
+
+  inline uint32 members_size(const void* data)
+  {
+    if (!is_compact(data))
+      return *((const uint32*)data + 1);
+    const uint8* pos = (const uint8*)data + 20;
+    return read_varint(pos);
+  }
+
+  // Points to the first member
+  inline const uint8* payload(const void* data)
+  {
+    if (!is_compact(data))
+      return (const uint8*)data + 16;
+    const uint8* pos = (const uint8*)data + 20;
+    read_varint(pos);
+    return pos;
+  }
+
+  inline uint64 role_and_type(const Relation_Entry& entry)
+  {
+    return ((uint64)(entry.role & 0xffffff)<<8) | (entry.type & 0xff);
+  }
+}
+
+
+/* Reads a Relation_Skeleton in place from its on-disk representation.
+ * It neither copies nor allocates, hence it is cheap for objects that are not kept. */
+class Relation_Skeleton_View
+{
+public:
+  // Reads the members in their order
+  class Member_Reader
+  {
+  public:
+    Member_Reader(const uint8* pos_, bool compact_) : pos(pos_), compact(compact_), last_ref(0) {}
+
+    Relation_Entry next()
+    {
+      Relation_Entry result;
+      if (!compact)
+      {
+        result.ref = *(const uint64*)pos;
+        result.role = *(const uint32*)(pos + 8) & 0xffffff;
+        result.type = *(pos + 11);
+        pos += 12;
+        return result;
+      }
+      last_ref += zigzag_decode(read_varint(pos));
+      result.ref = last_ref;
+      uint64 role_and_type = read_varint(pos);
+      result.role = role_and_type>>8;
+      result.type = role_and_type & 0xff;
+      return result;
+    }
+
+    // Points behind the last member read
+    const uint8* position() const { return pos; }
+
+  private:
+    const uint8* pos;
+    bool compact;
+    uint64 last_ref;
+  };
+
+  Relation_Skeleton_View(const void* data_) : data(data_) {}
+
+  Relation::Id_Type id() const { return *(const uint32*)data; }
+  uint32 members_size() const { return Relation_Skeleton_Format::members_size(data); }
+  uint32 node_idxs_size() const { return Relation_Skeleton_Format::node_idxs_size(data); }
+  uint32 way_idxs_size() const { return Relation_Skeleton_Format::way_idxs_size(data); }
+  Member_Reader members() const
+  { return Member_Reader(Relation_Skeleton_Format::payload(data), Relation_Skeleton_Format::is_compact(data)); }
+
+private:
+  const void* data;
+};
+
+
 struct Relation_Skeleton
 {
   typedef Relation::Id_Type Id_Type;
@@ -116,21 +215,41 @@ struct Relation_Skeleton
 
   Relation_Skeleton(void* data) : id(*(Id_Type*)data)
   {
-    members.resize(*((uint32*)data + 1));
-    node_idxs.resize(*((uint32*)data + 2), 0u);
-    way_idxs.resize(*((uint32*)data + 3), 0u);
-    for (uint i(0); i < *((uint32*)data + 1); ++i)
+    members.resize(Relation_Skeleton_Format::members_size(data));
+    node_idxs.resize(Relation_Skeleton_Format::node_idxs_size(data), 0u);
+    way_idxs.resize(Relation_Skeleton_Format::way_idxs_size(data), 0u);
+    bool compact = Relation_Skeleton_Format::is_compact(data);
+    const uint8* pos = Relation_Skeleton_Format::payload(data);
+
+    Relation_Skeleton_View::Member_Reader reader(pos, compact);
+    for (std::vector< Relation_Entry >::size_type i = 0; i < members.size(); ++i)
+      members[i] = reader.next();
+    pos = reader.position();
+
+    if (compact)
+    {
+      uint32 last = 0;
+      for (std::vector< Uint31_Index >::size_type i = 0; i < node_idxs.size(); ++i)
+      {
+        last += zigzag_decode(read_varint(pos));
+        node_idxs[i] = last;
+      }
+      last = 0;
+      for (std::vector< Uint31_Index >::size_type i = 0; i < way_idxs.size(); ++i)
+      {
+        last += zigzag_decode(read_varint(pos));
+        way_idxs[i] = last;
+      }
+    }
+    else
     {
-      members[i].ref = *(uint64*)((uint32*)data + 4 + 3*i);
-      members[i].role = *((uint32*)data + 6 + 3*i) & 0xffffff;
-      members[i].type = *((uint8*)data + 27 + 12*i);
+      const uint32* start_ptr = (const uint32*)pos;
+      for (uint i = 0; i < node_idxs.size(); ++i)
+        node_idxs[i] = *(start_ptr + i);
+      start_ptr += node_idxs.size();
+      for (uint i = 0; i < way_idxs.size(); ++i)
+        way_idxs[i] = *(start_ptr + i);
     }
-    uint32* start_ptr = (uint32*)data + 4 + 3*members.size();
-    for (uint i = 0; i < node_idxs.size(); ++i)
-      node_idxs[i] = *(start_ptr + i);
-    start_ptr = (uint32*)data + 4 + 3*members.size() + node_idxs.size();
-    for (uint i = 0; i < way_idxs.size(); ++i)
-      way_idxs[i] = *(start_ptr + i);
   }
 
   Relation_Skeleton(const Relation& rel)
@@ -143,11 +262,13 @@ struct Relation_Skeleton
 
   uint32 size_of() const
   {
-    return 16 + 12*members.size() + 4*node_idxs.size() + 4*way_idxs.size();
+    return 20 + payload_size();
   }
 
   static uint32 size_of(void* data)
   {
+    if (Relation_Skeleton_Format::is_compact(data))
+      return 20 + *((uint32*)data + 4);
     return 16 + 12 * *((uint32*)data + 1) + 4* *((uint32*)data + 2) + 4* *((uint32*)data + 3);
   }
 
@@ -159,21 +280,31 @@ struct Relation_Skeleton
   void to_data(void* data) const
   {
     *(Id_Type*)data = id.val();
-    *((uint32*)data + 1) = members.size();
+    *((uint32*)data + 1) = Relation_Skeleton_Format::COMPACT_MARK;
     *((uint32*)data + 2) = node_idxs.size();
     *((uint32*)data + 3) = way_idxs.size();
-    for (uint i = 0; i < members.size(); ++i)
+    *((uint32*)data + 4) = payload_size();
+    uint8* pos = (uint8*)data + 20;
+    write_varint(pos, members.size());
+    uint64 last_ref = 0;
+    for (std::vector< Relation_Entry >::const_iterator it = members.begin(); it != members.end(); ++it)
+    {
+      write_varint(pos, zigzag_encode(it->ref.val() - last_ref));
+      write_varint(pos, Relation_Skeleton_Format::role_and_type(*it));
+      last_ref = it->ref.val();
+    }
+    uint32 last = 0;
+    for (std::vector< Uint31_Index >::const_iterator it = node_idxs.begin(); it != node_idxs.end(); ++it)
     {
-      *(uint64*)((uint32*)data + 4 + 3*i) = members[i].ref.val();
-      *((uint32*)data + 6 + 3*i) = members[i].role & 0xffffff;
-      *((uint8*)data + 27 + 12*i) = members[i].type;
+      write_varint(pos, zigzag_encode((int64)it->val() - last));
+      last = it->val();
+    }
+    last = 0;
+    for (std::vector< Uint31_Index >::const_iterator it = way_idxs.begin(); it != way_idxs.end(); ++it)
+    {
+      write_varint(pos, zigzag_encode((int64)it->val() - last));
+      last = it->val();
     }
-    Uint31_Index* start_ptr = (Uint31_Index*)data + 4 + 3*members.size();
-    for (uint i = 0; i < node_idxs.size(); ++i)
-      *(start_ptr + i) = node_idxs[i];
-    start_ptr = (Uint31_Index*)data + 4 + 3*members.size() + node_idxs.size();
-    for (uint i = 0; i < way_idxs.size(); ++i)
-      *(start_ptr + i) = way_idxs[i];
   }
 
   bool operator<(const Relation_Skeleton& a) const
@@ -185,6 +316,43 @@ struct Relation_Skeleton
   {
     return this->id == a.id;
   }
+
+private:
+  // Block_Backend asks several times per object for its size while it packs blocks.
+  // Hence the size is computed once. The members and indices must not change after size_of().
+  Encoded_Size_Cache cached_payload_size;
+
+  uint32 payload_size() const
+  {
+    if (cached_payload_size.value == 0)
+      cached_payload_size.value = compute_payload_size();
+    return cached_payload_size.value;
+  }
+
+  uint32 compute_payload_size() const
+  {
+    uint32 result = varint_size(members.size());
+    uint64 last_ref = 0;
+    for (std::vector< Relation_Entry >::const_iterator it = members.begin(); it != members.end(); ++it)
+    {
+      result += varint_size(zigzag_encode(it->ref.val() - last_ref));
+      result += varint_size(Relation_Skeleton_Format::role_and_type(*it));
+      last_ref = it->ref.val();
+    }
+    uint32 last = 0;
+    for (std::vector< Uint31_Index >::const_iterator it = node_idxs.begin(); it != node_idxs.end(); ++it)
+    {
+      result += varint_size(zigzag_encode((int64)it->val() - last));
+      last = it->val();
+    }
+    last = 0;
+    for (std::vector< Uint31_Index >::const_iterator it = way_idxs.begin(); it != way_idxs.end(); ++it)
+    {
+      result += varint_size(zigzag_encode((int64)it->val() - last));
+      last = it->val();
+    }
+    return result;
+  }
 };
 
 
@@ -25,6 +25,7 @@
 #include <vector>
 
 #include "basic_types.h"
+#include "../../template_db/types.h"
 
 
 struct Unsupported_Error
@@ -115,6 +116,29 @@ struct Tag_Index_Local
 };
 
 
+/* Avoids decoding the key and value into strings while Block_Backend searches for the requested indices */
+template< >
+struct Index_Data_Comparator< Tag_Index_Local >
+{
+  static int compare(void* data, const Tag_Index_Local& rhs)
+  {
+    uint32 index = (*((uint32*)data + 1))<<8;
+    if ((index & 0x7fffffff) != (rhs.index & 0x7fffffff))
+      return ((index & 0x7fffffff) < (rhs.index & 0x7fffffff) ? -1 : 1);
+    if (index != rhs.index)
+      return (index < rhs.index ? -1 : 1);
+    int result = compare_string_data((int8*)data + 7, *(uint16*)data, rhs.key);
+    if (result != 0)
+      return result;
+    return compare_string_data((int8*)data + 7 + *(uint16*)data, *((uint16*)data + 1), rhs.value);
+  }
+
+  static bool less(void* data, const Tag_Index_Local& rhs) { return compare(data, rhs) < 0; }
+  static bool greater(void* data, const Tag_Index_Local& rhs) { return compare(data, rhs) > 0; }
+  static bool equal(void* data, const Tag_Index_Local& rhs) { return compare(data, rhs) == 0; }
+};
+
+
 inline const std::string& void_tag_value()
 {
   static std::string void_value = " ";
@@ -279,6 +303,23 @@ struct Tag_Index_Global
 };
 
 
+template< >
+struct Index_Data_Comparator< Tag_Index_Global >
+{
+  static int compare(void* data, const Tag_Index_Global& rhs)
+  {
+    int result = compare_string_data((int8*)data + 4, *(uint16*)data, rhs.key);
+    if (result != 0)
+      return result;
+    return compare_string_data((int8*)data + 4 + *(uint16*)data, *((uint16*)data + 1), rhs.value);
+  }
+
+  static bool less(void* data, const Tag_Index_Global& rhs) { return compare(data, rhs) < 0; }
+  static bool greater(void* data, const Tag_Index_Global& rhs) { return compare(data, rhs) > 0; }
+  static bool equal(void* data, const Tag_Index_Global& rhs) { return compare(data, rhs) == 0; }
+};
+
+
 template< typename Id_Type_ >
 struct Tag_Object_Global
 {
@@ -22,6 +22,7 @@
 #include "basic_types.h"
 #include "index_computations.h"
 #include "type_node.h"
+#include "varint.h"
 
 #include <cstring>
 #include <map>
@@ -83,6 +84,85 @@ struct Way_Equal_Id {
 struct Way_Delta;
 
 
+/* Way_Skeleton has two on-disk formats that can be mixed within a file:
+ *
+ * The legacy format stores the id, the uint16 number of node ids, the uint16 number of
+ * coordinates, and then each node id as uint64 and each coordinate as two uint32.
+ *
+ * The compact format stores COMPACT_MARK instead of the number of node ids. It is followed
+ * by the uint16 number of coordinates, the uint32 size of the payload in bytes, and the payload.
+ * The payload starts with the number of node ids as varint, followed by the differences
+ * of consecutive node ids and of consecutive coordinate halves as zigzag varints.
+ * The writer always uses the compact format. No legacy way has as many nodes as COMPACT_MARK. */
+namespace Way_Skeleton_Format
+{
+  const uint16 COMPACT_MARK = 0xffff;
+
+  inline bool is_compact(const void* data) { return *((const uint16*)data + 2) == COMPACT_MARK; }
+  inline uint16 geometry_size(const void* data) { return *((const uint16*)data + 3); }
+
+  inline uint32 nds_size(const void* data)
+  {
+    if (!is_compact(data))
+      return *((const uint16*)data + 2);
+    const uint8* pos = (const uint8*)data + 12;
+    return read_varint(pos);
+  }
+
+  // Points to the first node id
+  inline const uint8* payload(const void* data)
+  {
+    if (!is_compact(data))
+      return (const uint8*)data + 8;
+    const uint8* pos = (const uint8*)data + 12;
+    read_varint(pos);
+    return pos;
+  }
+}
+
+
+/* Reads a Way_Skeleton in place from its on-disk representation.
+ * It neither copies nor allocates, hence it is cheap for objects that are not kept. */
+class Way_Skeleton_View
+{
+public:
+  // Reads the node ids in their order
+  class Nd_Reader
+  {
+  public:
+    Nd_Reader(const uint8* pos_, bool compact_) : pos(pos_), compact(compact_), last(0) {}
+
+    Node::Id_Type next()
+    {
+      if (!compact)
+      {
+        last = *(const uint64*)pos;
+        pos += 8;
+      }
+      else
+        last += zigzag_decode(read_varint(pos));
+      return last;
+    }
+
+  private:
+    const uint8* pos;
+    bool compact;
+    uint64 last;
+  };
+
+  Way_Skeleton_View(const void* data_) : data(data_) {}
+
+  Way::Id_Type id() const { return *(const uint32*)data; }
+  uint32 nds_size() const { return Way_Skeleton_Format::nds_size(data); }
+  uint16 geometry_size() const { return Way_Skeleton_Format::geometry_size(data); }
+  Nd_Reader nds() const
+  { return Nd_Reader(Way_Skeleton_Format::payload(data), Way_Skeleton_Format::is_compact(data)); }
+
+private:
+  const void* data;
+};
+
+
 struct Way_Skeleton
 {
   typedef Way::Id_Type Id_Type;
@@ -98,13 +178,33 @@ struct Way_Skeleton
 
   Way_Skeleton(void* data) : id(*(Id_Type*)data)
   {
-    nds.reserve(*((uint16*)data + 2));
-    for (int i(0); i < *((uint16*)data + 2); ++i)
-      nds.push_back(*(uint64*)((uint16*)data + 4 + 4*i));
-    uint16* start_ptr = (uint16*)data + 4 + 4*nds.size();
-    geometry.reserve(*((uint16*)data + 3));
-    for (int i(0); i < *((uint16*)data + 3); ++i)
-      geometry.push_back(Quad_Coord(*(uint32*)(start_ptr + 4*i), *(uint32*)(start_ptr + 4*i + 2)));
+    nds.resize(Way_Skeleton_Format::nds_size(data));
+    geometry.resize(Way_Skeleton_Format::geometry_size(data));
+    const uint8* pos = Way_Skeleton_Format::payload(data);
+    if (Way_Skeleton_Format::is_compact(data))
+    {
+      uint64 last = 0;
+      for (std::vector< Node::Id_Type >::size_type i = 0; i < nds.size(); ++i)
+      {
+        last += zigzag_decode(read_varint(pos));
+        nds[i] = last;
+      }
+      Quad_Coord last_coord;
+      for (std::vector< Quad_Coord >::size_type i = 0; i < geometry.size(); ++i)
+      {
+        last_coord.ll_upper += zigzag_decode(read_varint(pos));
+        last_coord.ll_lower += zigzag_decode(read_varint(pos));
+        geometry[i] = last_coord;
+      }
+    }
+    else
+    {
+      for (std::vector< Node::Id_Type >::size_type i = 0; i < nds.size(); ++i)
+        nds[i] = *(const uint64*)(pos + 8*i);
+      pos += 8*nds.size();
+      for (std::vector< Quad_Coord >::size_type i = 0; i < geometry.size(); ++i)
+        geometry[i] = Quad_Coord(*(const uint32*)(pos + 8*i), *(const uint32*)(pos + 8*i + 4));
+    }
   }
 
   Way_Skeleton(const Way& way)
@@ -115,11 +215,13 @@ struct Way_Skeleton
 
   uint32 size_of() const
   {
-    return 8 + 8*nds.size() + 8*geometry.size();
+    return 12 + payload_size();
   }
 
   static uint32 size_of(void* data)
   {
+    if (Way_Skeleton_Format::is_compact(data))
+      return 12 + *((uint32*)data + 2);
     return (8 + 8 * *((uint16*)data + 2) + 8 * *((uint16*)data + 3));
   }
 
@@ -131,15 +233,23 @@ struct Way_Skeleton
   void to_data(void* data) const
   {
     *(Id_Type*)data = id.val();
-    *((uint16*)data + 2) = nds.size();
+    *((uint16*)data + 2) = Way_Skeleton_Format::COMPACT_MARK;
     *((uint16*)data + 3) = geometry.size();
-    for (uint i(0); i < nds.size(); ++i)
-      *(uint64*)((uint16*)data + 4 + 4*i) = nds[i].val();
-    uint16* start_ptr = (uint16*)data + 4 + 4*nds.size();
-    for (uint i(0); i < geometry.size(); ++i)
+    *((uint32*)data + 2) = payload_size();
+    uint8* pos = (uint8*)data + 12;
+    write_varint(pos, nds.size());
+    uint64 last = 0;
+    for (std::vector< Node::Id_Type >::const_iterator it = nds.begin(); it != nds.end(); ++it)
+    {
+      write_varint(pos, zigzag_encode(it->val() - last));
+      last = it->val();
+    }
+    Quad_Coord last_coord;
+    for (std::vector< Quad_Coord >::const_iterator it = geometry.begin(); it != geometry.end(); ++it)
     {
-      *(uint32*)(start_ptr + 4*i) = geometry[i].ll_upper;
-      *(uint32*)(start_ptr + 4*i + 2) = geometry[i].ll_lower;
+      write_varint(pos, zigzag_encode((int64)it->ll_upper - last_coord.ll_upper));
+      write_varint(pos, zigzag_encode((int64)it->ll_lower - last_coord.ll_lower));
+      last_coord = *it;
     }
   }
 
@@ -152,6 +262,37 @@ struct Way_Skeleton
   {
     return this->id == a.id;
   }
+
+private:
+  // Block_Backend asks several times per object for its size while it packs blocks.
+  // Hence the size is computed once. nds and geometry must not change after size_of().
+  Encoded_Size_Cache cached_payload_size;
+
+  uint32 payload_size() const
+  {
+    if (cached_payload_size.value == 0)
+      cached_payload_size.value = compute_payload_size();
+    return cached_payload_size.value;
+  }
+
+  uint32 compute_payload_size() const
+  {
+    uint32 result = varint_size(nds.size());
+    uint64 last = 0;
+    for (std::vector< Node::Id_Type >::const_iterator it = nds.begin(); it != nds.end(); ++it)
+    {
+      result += varint_size(zigzag_encode(it->val() - last));
+      last = it->val();
+    }
+    Quad_Coord last_coord;
+    for (std::vector< Quad_Coord >::const_iterator it = geometry.begin(); it != geometry.end(); ++it)
+    {
+      result += varint_size(zigzag_encode((int64)it->ll_upper - last_coord.ll_upper));
+      result += varint_size(zigzag_encode((int64)it->ll_lower - last_coord.ll_lower));
+      last_coord = *it;
+    }
+    return result;
+  }
 };
 
 
@@ -0,0 +1,94 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DE__OSM3S___OVERPASS_API__CORE__VARINT_H
+#define DE__OSM3S___OVERPASS_API__CORE__VARINT_H
+
+#include "../../template_db/types.h"
+
+
+/* Little endian base 128 varints as used by the compact skeleton formats.
+ * Signed differences are zigzag encoded first, so that small negative values stay short. */
+
+
+inline uint64 zigzag_encode(int64 value)
+{
+  return ((uint64)value<<1) ^ (uint64)(value>>63);
+}
+
+
+inline int64 zigzag_decode(uint64 value)
+{
+  return (int64)(value>>1) ^ -(int64)(value & 1);
+}
+
+
+inline uint32 varint_size(uint64 value)
+{
+  uint32 result = 1;
+  while (value >= 0x80)
+  {
+    value >>= 7;
+    ++result;
+  }
+  return result;
+}
+
+
+inline void write_varint(uint8*& pos, uint64 value)
+{
+  while (value >= 0x80)
+  {
+    *pos = (uint8)(value | 0x80);
+    ++pos;
+    value >>= 7;
+  }
+  *pos = (uint8)value;
+  ++pos;
+}
+
+
+inline uint64 read_varint(const uint8*& pos)
+{
+  uint64 result = *pos & 0x7f;
+  int shift = 7;
+  while (*pos & 0x80)
+  {
+    ++pos;
+    result |= (uint64)(*pos & 0x7f)<<shift;
+    shift += 7;
+  }
+  ++pos;
+  return result;
+}
+
+
+/* Holds the once computed encoded size of an object. A copy starts empty,
+ * because the copy may be changed before it is written. */
+struct Encoded_Size_Cache
+{
+  Encoded_Size_Cache() : value(0) {}
+  Encoded_Size_Cache(const Encoded_Size_Cache&) : value(0) {}
+  Encoded_Size_Cache& operator=(const Encoded_Size_Cache&) { value = 0; return *this; }
+
+  // Zero means not yet computed
+  mutable uint32 value;
+};
+
+
+#endif
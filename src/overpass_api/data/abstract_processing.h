@@ -140,6 +140,48 @@ inline bool has_a_child_with_id
 }
 
 
+inline bool has_a_child_with_id
+    (const Relation_Skeleton_View& relation, const std::vector< Uint64 >& ids, uint32 type)
+{
+  Relation_Skeleton_View::Member_Reader reader = relation.members();
+  for (uint32 i = 0; i < relation.members_size(); ++i)
+  {
+    Relation_Entry entry = reader.next();
+    if (entry.type == type && binary_search(ids.begin(), ids.end(), entry.ref))
+      return true;
+  }
+  return false;
+}
+
+
+inline bool has_a_child_with_id_and_role
+    (const Relation_Skeleton_View& relation, const std::vector< Uint64 >& ids, uint32 type, uint32 role_id)
+{
+  Relation_Skeleton_View::Member_Reader reader = relation.members();
+  for (uint32 i = 0; i < relation.members_size(); ++i)
+  {
+    Relation_Entry entry = reader.next();
+    if (entry.type == type && entry.role == role_id &&
+        binary_search(ids.begin(), ids.end(), entry.ref))
+      return true;
+  }
+  return false;
+}
+
+
+inline bool has_a_child_with_id
+    (const Way_Skeleton_View& way, const std::vector< Node::Id_Type >& ids)
+{
+  Way_Skeleton_View::Nd_Reader reader = way.nds();
+  for (uint32 i = 0; i < way.nds_size(); ++i)
+  {
+    if (binary_search(ids.begin(), ids.end(), reader.next()))
+      return true;
+  }
+  return false;
+}
+
+
 class Get_Parent_Rels_Predicate
 {
 public:
@@ -148,9 +190,9 @@ public:
   bool match(const Relation_Skeleton& obj) const
   { return has_a_child_with_id(obj, ids, child_type); }
   bool match(const Handle< Relation_Skeleton >& h) const
-  { return has_a_child_with_id(h.object(), ids, child_type); }
+  { return has_a_child_with_id(h.view< Relation_Skeleton_View >(), ids, child_type); }
   bool match(const Handle< Attic< Relation_Skeleton > >& h) const
-  { return has_a_child_with_id(h.object(), ids, child_type); }
+  { return has_a_child_with_id(h.view< Relation_Skeleton_View >(), ids, child_type); }
 
 private:
   const std::vector< Uint64 >& ids;
@@ -166,9 +208,9 @@ public:
   bool match(const Relation_Skeleton& obj) const
   { return has_a_child_with_id_and_role(obj, ids, child_type, role_id); }
   bool match(const Handle< Relation_Skeleton >& h) const
-  { return has_a_child_with_id_and_role(h.object(), ids, child_type, role_id); }
+  { return has_a_child_with_id_and_role(h.view< Relation_Skeleton_View >(), ids, child_type, role_id); }
   bool match(const Handle< Attic< Relation_Skeleton > >& h) const
-  { return has_a_child_with_id_and_role(h.object(), ids, child_type, role_id); }
+  { return has_a_child_with_id_and_role(h.view< Relation_Skeleton_View >(), ids, child_type, role_id); }
 
 private:
   const std::vector< Uint64 >& ids;
@@ -183,8 +225,10 @@ public:
   Get_Parent_Ways_Predicate(const std::vector< Node::Id_Type >& ids_)
     : ids(ids_) {}
   bool match(const Way_Skeleton& obj) const { return has_a_child_with_id(obj, ids); }
-  bool match(const Handle< Way_Skeleton >& h) const { return has_a_child_with_id(h.object(), ids); }
-  bool match(const Handle< Attic< Way_Skeleton > >& h) const { return has_a_child_with_id(h.object(), ids); }
+  bool match(const Handle< Way_Skeleton >& h) const
+  { return has_a_child_with_id(h.view< Way_Skeleton_View >(), ids); }
+  bool match(const Handle< Attic< Way_Skeleton > >& h) const
+  { return has_a_child_with_id(h.view< Way_Skeleton_View >(), ids); }
 
 private:
   const std::vector< Node::Id_Type >& ids;
@@ -316,7 +316,7 @@ void collect_items_discrete(const Statement* stmt, Resource_Manager& rman,
         rman.health_check(*stmt, 0, eval_map(result));
     }
     if (predicate.match(it.handle()))
-      result[it.index()].push_back(it.object());
+      it.handle().push_back_to(result[it.index()]);
   }
 }
 
@@ -334,7 +334,7 @@ void collect_items_discrete(Transaction& transaction,
       it(db.discrete_begin(req.begin(), req.end())); !(it == db.discrete_end()); ++it)
   {
     if (predicate.match(it.handle()))
-      result[it.index()].push_back(it.object());
+      it.handle().push_back_to(result[it.index()]);
   }
 }
 
@@ -373,6 +373,37 @@ void collect_items_discrete_by_timestamp(const Statement* stmt, Resource_Manager
 }
 
 
+/* Health check for Block_Backend::read_ranges_parallel. A timeout on a worker thread
+ * only stops its shard. The caller reports it after the shards have been merged. */
+template < class Index, class Object >
+struct Collect_Items_Health_Check
+{
+  Collect_Items_Health_Check(const Statement* stmt_, Resource_Manager& rman_)
+      : stmt(stmt_), rman(&rman_), owner(pthread_self()) {}
+
+  bool operator()(const std::map< Index, std::vector< Object > >& partial_result) const
+  {
+    if (!stmt)
+      return true;
+    try
+    {
+      rman->health_check(*stmt, 0, eval_map(partial_result));
+    }
+    catch (const Resource_Error& e)
+    {
+      if (pthread_equal(pthread_self(), owner))
+        throw;
+      return false;
+    }
+    return true;
+  }
+
+  const Statement* stmt;
+  Resource_Manager* rman;
+  pthread_t owner;
+};
+
+
 template < class Index, class Object, class Container, class Predicate >
 void collect_items_range(const Statement* stmt, Resource_Manager& rman,
 		   File_Properties& file_properties,
@@ -382,6 +413,14 @@ void collect_items_range(const Statement* stmt, Resource_Manager& rman,
   uint32 count = 0;
   Block_Backend< Index, Object, typename Container::const_iterator > db
       (rman.get_transaction()->data_index(&file_properties));
+  if (rman.get_max_parallel_threads() > 1)
+  {
+    db.read_ranges_parallel(req.begin(), req.end(), predicate,
+        Collect_Items_Health_Check< Index, Object >(stmt, rman), rman.get_max_parallel_threads(), result);
+    if (stmt)
+      rman.health_check(*stmt, 0, eval_map(result));
+    return;
+  }
   for (typename Block_Backend< Index, Object, typename Container
       ::const_iterator >::Range_Iterator
       it(db.range_begin(req.begin(), req.end()));
@@ -393,7 +432,7 @@ void collect_items_range(const Statement* stmt, Resource_Manager& rman,
       rman.health_check(*stmt, 0, eval_map(result));
     }
     if (predicate.match(it.handle()))
-      result[it.index()].push_back(it.object());
+      it.handle().push_back_to(result[it.index()]);
   }
 }
 
@@ -432,7 +471,7 @@ void collect_items_flat(const Statement& stmt, Resource_Manager& rman,
       rman.health_check(stmt, 0, eval_map(result));
     }
     if (predicate.match(it.handle()))
-      result[it.index()].push_back(it.object());
+      it.handle().push_back_to(result[it.index()]);
   }
 }
 
@@ -1345,7 +1345,8 @@ void collect_ways
 {
   std::vector< Uint64 > ids = extract_children_ids< Uint32_Index, Node_Skeleton, Uint64 >(nodes);
   rman.health_check(stmt);
-  std::set< Uint31_Index > req = extract_parent_indices(nodes);
+  std::set< Uint31_Index > req = extract_parent_indices(stmt, rman,
+      osm_base_settings().NODE_PARENT_WAYS, *osm_base_settings().WAYS, nodes);
   rman.health_check(stmt);
 
   collect_items_discrete(&stmt, rman, *osm_base_settings().WAYS, req,
@@ -1361,7 +1362,8 @@ void collect_ways
 {
   std::vector< Uint64 > children_ids = extract_children_ids< Uint32_Index, Node_Skeleton, Uint64 >(nodes);
   rman.health_check(stmt);
-  std::set< Uint31_Index > req = extract_parent_indices(nodes);
+  std::set< Uint31_Index > req = extract_parent_indices(stmt, rman,
+      osm_base_settings().NODE_PARENT_WAYS, *osm_base_settings().WAYS, nodes);
   rman.health_check(stmt);
 
   if (!invert_ids)
@@ -1018,6 +1018,44 @@ std::set< Uint31_Index > extract_parent_indices(const std::map< TIndex, std::vec
 }
 
 
+/* If the database has the index from members to their parents then this returns
+ * the indices of exactly those elements in parent_file that are parents of elems.
+ * Otherwise it returns all indices where a parent of elems may be. */
+template< class TIndex, class TObject >
+std::set< Uint31_Index > extract_parent_indices(const Statement& stmt, Resource_Manager& rman,
+    const File_Properties* parent_index_file, const File_Properties& parent_file,
+    const std::map< TIndex, std::vector< TObject > >& elems)
+{
+  if (!parent_index_file || !rman.has_parent_index())
+    return extract_parent_indices(elems);
+
+  std::set< typename TObject::Id_Type > children;
+  for (typename std::map< TIndex, std::vector< TObject > >::const_iterator
+      it(elems.begin()); it != elems.end(); ++it)
+  {
+    for (typename std::vector< TObject >::const_iterator it2(it->second.begin());
+        it2 != it->second.end(); ++it2)
+      children.insert(it2->id);
+  }
+
+  std::set< Uint32_Index > parent_ids;
+  Block_Backend< typename TObject::Id_Type, Uint32_Index > db
+      (rman.get_transaction()->data_index(parent_index_file));
+  for (typename Block_Backend< typename TObject::Id_Type, Uint32_Index >::Discrete_Iterator
+      it(db.discrete_begin(children.begin(), children.end())); !(it == db.discrete_end()); ++it)
+    parent_ids.insert(it.object());
+  rman.health_check(stmt);
+
+  std::set< Uint31_Index > req;
+  Random_File< Uint32_Index, Uint31_Index > random
+      (rman.get_transaction()->random_index(&parent_file));
+  for (std::set< Uint32_Index >::const_iterator it = parent_ids.begin(); it != parent_ids.end(); ++it)
+    req.insert(random.get(it->val()));
+
+  return req;
+}
+
+
 void collect_ways(const Statement& query, Resource_Manager& rman,
 		  const std::map< Uint31_Index, std::vector< Relation_Skeleton > >& rels,
 		  const std::set< std::pair< Uint31_Index, Uint31_Index > >& ranges,
@@ -114,6 +114,32 @@ Set Diff_Set::make_to_set() const
   return result;
 }
 
+std::set< uint32 > Diff_Set::user_ids() const
+{
+  std::set< uint32 > result;
+
+  for (std::vector< std::pair< Node_With_Context, Node_With_Context > >::const_iterator
+      it = different_nodes.begin(); it != different_nodes.end(); ++it)
+  {
+    result.insert(it->first.meta.user_id);
+    result.insert(it->second.meta.user_id);
+  }
+  for (std::vector< std::pair< Way_With_Context, Way_With_Context > >::const_iterator it = different_ways.begin();
+      it != different_ways.end(); ++it)
+  {
+    result.insert(it->first.meta.user_id);
+    result.insert(it->second.meta.user_id);
+  }
+  for (std::vector< std::pair< Relation_With_Context, Relation_With_Context > >::const_iterator
+      it = different_relations.begin(); it != different_relations.end(); ++it)
+  {
+    result.insert(it->first.meta.user_id);
+    result.insert(it->second.meta.user_id);
+  }
+
+  return result;
+}
+
 
 const std::pair< Quad_Coord, Quad_Coord* >* bound_variant(Double_Coords& double_coords, unsigned int mode)
 {
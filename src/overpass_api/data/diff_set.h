@@ -23,6 +23,7 @@
 #include "../core/datatypes.h"
 
 #include <map>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -137,6 +138,9 @@ struct Diff_Set
 
   Set make_from_set() const;
   Set make_to_set() const;
+
+  // The ids of the users in the metadata of both sides
+  std::set< uint32 > user_ids() const;
 };
 
 
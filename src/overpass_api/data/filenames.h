@@ -129,6 +129,23 @@ template< > inline File_Properties* attic_idx_list_properties< Relation_Skeleton
 
 
 
+template< typename Skeleton >
+File_Properties* parent_relations_file_properties()
+{
+  return 0;
+}
+
+template< > inline File_Properties* parent_relations_file_properties< Node_Skeleton >()
+{ return osm_base_settings().NODE_PARENT_RELATIONS; }
+
+template< > inline File_Properties* parent_relations_file_properties< Way_Skeleton >()
+{ return osm_base_settings().WAY_PARENT_RELATIONS; }
+
+template< > inline File_Properties* parent_relations_file_properties< Relation_Skeleton >()
+{ return osm_base_settings().RELATION_PARENT_RELATIONS; }
+
+
+
 template< typename Skeleton >
 File_Properties* attic_undeleted_file_properties()
 {
@@ -47,6 +47,28 @@ std::set< std::pair< Tag_Index_Global, Tag_Index_Global > > get_k_req(const std:
 }
 
 
+// Restricts the range to the values that start with the literal prefix of the regular expression
+std::set< std::pair< Tag_Index_Global, Tag_Index_Global > > get_kregv_req
+    (const std::string& key, const Regular_Expression& value)
+{
+  std::string upper = value.get_prefix();
+  while (!upper.empty() && (uint8)upper[upper.size()-1] == 0xff)
+    upper.resize(upper.size()-1);
+  if (upper.empty())
+    return get_k_req(key);
+  upper[upper.size()-1] = (char)((uint8)upper[upper.size()-1] + 1);
+
+  std::set< std::pair< Tag_Index_Global, Tag_Index_Global > > result;
+  std::pair< Tag_Index_Global, Tag_Index_Global > idx_pair;
+  idx_pair.first.key = key;
+  idx_pair.first.value = value.get_prefix();
+  idx_pair.second.key = key;
+  idx_pair.second.value = upper;
+  result.insert(idx_pair);
+  return result;
+}
+
+
 template< typename Skeleton >
 std::set< std::pair< Tag_Index_Global, Tag_Index_Global > > get_regk_req
     (Regular_Expression* key, Resource_Manager& rman, Statement& stmt)
@@ -195,7 +217,7 @@ std::map< Id_Type, std::pair< uint64, Uint31_Index > > collect_attic_kregv(
     Block_Backend< Tag_Index_Global, Attic< Tag_Object_Global< Id_Type > > >& attic_tags_db)
 {
   std::map< Id_Type, std::pair< uint64, Uint31_Index > > timestamp_per_id;
-  std::set< std::pair< Tag_Index_Global, Tag_Index_Global > > range_req = get_k_req(krit->first);
+  std::set< std::pair< Tag_Index_Global, Tag_Index_Global > > range_req = get_kregv_req(krit->first, *krit->second);
 
   for (typename Block_Backend< Tag_Index_Global, Tag_Object_Global< Id_Type > >::Range_Iterator
       it2(tags_db.range_begin
@@ -222,6 +244,8 @@ std::map< Id_Type, std::pair< uint64, Uint31_Index > > collect_attic_kregv(
     }
   }
 
+  // Any later change of the key counts, whatever the value
+  range_req = get_k_req(krit->first);
   for (typename Block_Backend< Tag_Index_Global, Attic< Tag_Object_Global< Id_Type > > >::Range_Iterator
       it2(attic_tags_db.range_begin(Default_Range_Iterator< Tag_Index_Global >(range_req.begin()),
           Default_Range_Iterator< Tag_Index_Global >(range_req.end())));
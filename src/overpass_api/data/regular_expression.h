@@ -38,7 +38,7 @@ struct Regular_Expression_Error
 class Regular_Expression
 {
   public:
-    enum Strategy { call_library, match_anything, match_nonempty };
+    enum Strategy { call_library, match_anything, match_nonempty, match_prefix };
 
     Regular_Expression(const std::string& regex, bool case_sensitive)
     {
@@ -46,6 +46,8 @@ class Regular_Expression
         strategy = match_anything;
       else if (regex == ".")
         strategy = match_nonempty;
+      else if (case_sensitive && literal_prefix(regex, prefix))
+        strategy = match_prefix;
       else
         strategy = call_library;
 
@@ -75,6 +77,8 @@ class Regular_Expression
         return true;
       else if (strategy == match_nonempty)
         return !line.empty();
+      else if (strategy == match_prefix)
+        return !line.compare(0, prefix.size(), prefix);
 //       if (is_cache_available && line == prev_line)
 //         return prev_result;
 
@@ -87,12 +91,56 @@ class Regular_Expression
       return (result);
     }
 
+    // All strings that match start with this prefix. It is empty if no such prefix is known.
+    const std::string& get_prefix() const { return prefix; }
+
   private:
     Regular_Expression(const Regular_Expression&);
     const Regular_Expression& operator=(const Regular_Expression&);
 
+    // Collects the literal characters after a leading ^ into prefix.
+    // Returns true if the regular expression consists of nothing else.
+    static bool literal_prefix(const std::string& regex, std::string& prefix)
+    {
+      static const std::string special = "\\.[]()*+?{}|^$";
+
+      prefix = "";
+      if (regex.empty() || regex[0] != '^' || regex.find('|') != std::string::npos)
+        return false;
+
+      std::string::size_type pos = 1;
+      while (pos < regex.size())
+      {
+        std::string literal;
+        if (regex[pos] == '\\' && pos+1 < regex.size() && special.find(regex[pos+1]) != std::string::npos)
+        {
+          literal = regex.substr(pos+1, 1);
+          pos += 2;
+        }
+        else if (special.find(regex[pos]) != std::string::npos)
+          return false;
+        else
+        {
+          // A quantifier applies to the whole UTF-8 character
+          std::string::size_type end = pos+1;
+          while (end < regex.size() && (regex[end] & 0xc0) == 0x80)
+            ++end;
+          literal = regex.substr(pos, end - pos);
+          pos = end;
+        }
+
+        if (pos < regex.size() && (regex[pos] == '*' || regex[pos] == '?' || regex[pos] == '{'))
+          return false;
+        prefix += literal;
+        if (pos < regex.size() && regex[pos] == '+')
+          return false;
+      }
+      return true;
+    }
+
     regex_t preg;
     Strategy strategy;
+    std::string prefix;
 //     mutable bool cache_available;
 //     mutable std::string prev_line;
 //     mutable bool prev_result;
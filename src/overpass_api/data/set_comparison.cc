@@ -30,7 +30,7 @@ Extra_Data_For_Diff::Extra_Data_For_Diff(
     Resource_Manager& rman, const Statement& stmt, const Set& to_print, unsigned int mode_,
     double south, double north, double west, double east)
     : mode(mode_), way_geometry_store(0), attic_way_geometry_store(0),
-    relation_geometry_store(0), attic_relation_geometry_store(0), roles(0), users(0)
+    relation_geometry_store(0), attic_relation_geometry_store(0), roles(0)
 {
   if (mode & (Output_Mode::GEOMETRY | Output_Mode::BOUNDS | Output_Mode::CENTER))
   {
@@ -53,15 +53,6 @@ Extra_Data_For_Diff::Extra_Data_For_Diff(
   }
 
   roles = &relation_member_roles(*rman.get_transaction());
-
-  if (mode & Output_Mode::META)
-    users = &rman.users();
-}
-
-
-const std::map< uint32, std::string >* Extra_Data_For_Diff::get_users() const
-{
-  return users;
 }
 
 
@@ -247,7 +238,7 @@ void Set_Comparison::tags_quadtile
         it2 != item_it->second.end(); ++it2)
     {
       print_item(extra_data, item_it->first.val(), *it2, tag_store.get(item_it->first, *it2),
-          meta_printer.get(item_it->first, it2->id), extra_data.users);
+          meta_printer.get(item_it->first, it2->id), 0);
     }
     ++item_it;
   }
@@ -273,7 +264,7 @@ void Set_Comparison::tags_quadtile_attic
         it2 != item_it->second.end(); ++it2)
     {
       print_item(extra_data, item_it->first.val(), *it2, tag_store.get(item_it->first, *it2),
-                 meta_printer.get(item_it->first, it2->id, it2->timestamp), extra_data.users);
+                 meta_printer.get(item_it->first, it2->id, it2->timestamp), 0);
     }
     ++item_it;
   }
@@ -302,7 +293,7 @@ void Set_Comparison::tags_quadtile
     {
       if (std::binary_search(id_list.begin(), id_list.end(), it2->id))
         print_item(extra_data, item_it->first.val(), *it2, tag_store.get(item_it->first, *it2),
-            meta_printer.get(item_it->first, it2->id), extra_data.users);
+            meta_printer.get(item_it->first, it2->id), 0);
     }
     ++item_it;
   }
@@ -338,7 +329,7 @@ void Set_Comparison::tags_quadtile_attic
         if (!meta)
           meta = current_meta_printer.get(item_it->first, it2->id, it2->timestamp);
         print_item(extra_data, item_it->first.val(), *it2, tag_store.get(item_it->first, *it2),
-                 meta, extra_data.users);
+                 meta, 0);
       }
     }
     ++item_it;
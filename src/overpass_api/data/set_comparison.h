@@ -34,6 +34,7 @@
 #include <vector>
 
 
+// The user names are resolved only when the Diff_Set is printed
 struct Extra_Data_For_Diff
 {
   Extra_Data_For_Diff(
@@ -41,15 +42,12 @@ struct Extra_Data_For_Diff
       double south, double north, double west, double east);
   ~Extra_Data_For_Diff();
 
-  const std::map< uint32, std::string >* get_users() const;
-
   unsigned int mode;
   Way_Bbox_Geometry_Store* way_geometry_store;
   Way_Bbox_Geometry_Store* attic_way_geometry_store;
   Relation_Geometry_Store* relation_geometry_store;
   Relation_Geometry_Store* attic_relation_geometry_store;
   const std::map< uint32, std::string >* roles;
-  const std::map< uint32, std::string >* users;
 };
 
 
@@ -20,23 +20,51 @@
 #define DE__OSM3S___OVERPASS_API__DATA__USER_DATA_CACHE_H
 
 
+#include <algorithm>
 #include <map>
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "../../template_db/block_backend.h"
+#include "../../template_db/file_blocks_index.h"
 #include "../../template_db/transaction.h"
 #include "../core/datatypes.h"
 #include "../core/settings.h"
 
+
+/* Resolves user ids to user names.
+ *
+ * The user data is indexed by the user id with the lowest eight bits cleared.
+ * Lookups of single users read only the blocks of the file that contain them
+ * and keep all users from these blocks. Hence a query never reads more
+ * than the whole file, and most queries read much less. */
 struct User_Data_Cache
 {
-  User_Data_Cache() : loaded(false) {}
+  User_Data_Cache() : loaded(false), blocks_known(false) {}
+
+  // Returns all users. Reads the whole file on first use.
   const std::map< uint32, std::string >& users(Transaction& transaction);
 
+  // Returns a map that contains at least the users from user_ids that exist.
+  const std::map< uint32, std::string >& users(
+      Transaction& transaction, const std::set< uint32 >& user_ids);
+
+  // Returns a map that contains at least the user user_id if it exists.
+  const std::map< uint32, std::string >& users(Transaction& transaction, uint32 user_id);
+
 private:
   std::map< uint32, std::string > users_;
   bool loaded;
+
+  // The distinct first indexes of the blocks, and whether the users from
+  // each block up to the next one are already in users_
+  std::vector< Uint32_Index > block_starts;
+  std::vector< bool > block_loaded;
+  bool blocks_known;
+
+  void load_blocks(Transaction& transaction, const std::set< uint32 >& user_ids);
 };
 
 
@@ -58,4 +86,66 @@ inline const std::map< uint32, std::string >& User_Data_Cache::users(
 }
 
 
+inline const std::map< uint32, std::string >& User_Data_Cache::users(
+    Transaction& transaction, const std::set< uint32 >& user_ids)
+{
+  if (!loaded)
+    load_blocks(transaction, user_ids);
+  return users_;
+}
+
+
+inline const std::map< uint32, std::string >& User_Data_Cache::users(
+    Transaction& transaction, uint32 user_id)
+{
+  if (!loaded && users_.find(user_id) == users_.end())
+  {
+    std::set< uint32 > user_ids;
+    user_ids.insert(user_id);
+    load_blocks(transaction, user_ids);
+  }
+  return users_;
+}
+
+
+inline void User_Data_Cache::load_blocks(Transaction& transaction, const std::set< uint32 >& user_ids)
+{
+  File_Blocks_Index< Uint32_Index >* index
+      = (File_Blocks_Index< Uint32_Index >*)transaction.data_index(meta_settings().USER_DATA);
+  if (!blocks_known)
+  {
+    const std::list< File_Block_Index_Entry< Uint32_Index > >& blocks = index->get_blocks();
+    for (std::list< File_Block_Index_Entry< Uint32_Index > >::const_iterator it = blocks.begin();
+        it != blocks.end(); ++it)
+    {
+      if (block_starts.empty() || block_starts.back() < it->index)
+        block_starts.push_back(it->index);
+    }
+    block_loaded.resize(block_starts.size(), false);
+    blocks_known = true;
+  }
+
+  std::set< std::pair< Uint32_Index, Uint32_Index > > req;
+  for (std::set< uint32 >::const_iterator it = user_ids.begin(); it != user_ids.end(); ++it)
+  {
+    std::vector< Uint32_Index >::size_type pos = std::upper_bound(
+        block_starts.begin(), block_starts.end(), Uint32_Index(*it & 0xffffff00)) - block_starts.begin();
+    if (pos == 0 || block_loaded[pos-1])
+      continue;
+    block_loaded[pos-1] = true;
+    req.insert(std::make_pair(block_starts[pos-1],
+        pos < block_starts.size() ? block_starts[pos] : Uint32_Index(0xffffffffu)));
+  }
+  if (req.empty())
+    return;
+
+  Block_Backend< Uint32_Index, User_Data > user_db(index);
+  for (Block_Backend< Uint32_Index, User_Data >::Range_Iterator
+      it = user_db.range_begin(Default_Range_Iterator< Uint32_Index >(req.begin()),
+          Default_Range_Iterator< Uint32_Index >(req.end()));
+      !(it == user_db.range_end()); ++it)
+    users_[it.object().id] = it.object().name;
+}
+
+
 #endif
@@ -24,6 +24,7 @@
 
 #include <algorithm>
 #include <cerrno>
+#include <cstdio>
 #include <cstdlib>
 #include <iomanip>
 #include <map>
@@ -52,6 +53,15 @@ std::string to_string(T t)
 }
 
 
+// Yields the same as the generic version, but avoids the costly setup of a stream
+inline std::string to_string(double t)
+{
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.14g", t);
+  return buf;
+}
+
+
 template < typename T >
 std::string fixed_to_string(T t, unsigned int precision)
 {
@@ -166,6 +166,7 @@ int main(int argc, char* argv[])
   uint64 max_allowed_space = 0;
   uint64 max_allowed_time_units = 0;
   int rate_limit = -1;
+  uint64 block_cache_size = 0;
 
   int argpos(1);
   while (argpos < argc)
@@ -202,6 +203,8 @@ int main(int argc, char* argv[])
       max_allowed_time_units = atoll(((std::string)argv[argpos]).substr(7).c_str());
     else if (!(strncmp(argv[argpos], "--rate-limit=", 13)))
       rate_limit = atoll(((std::string)argv[argpos]).substr(13).c_str());
+    else if (!(strncmp(argv[argpos], "--block-cache=", 14)))
+      block_cache_size = atoll(((std::string)argv[argpos]).substr(14).c_str());
     else
     {
       std::cout<<"Unknown argument: "<<argv[argpos]<<"\n\n"
@@ -220,7 +223,8 @@ int main(int argc, char* argv[])
       "  --query_token: Returns the pid of a running query for the same client IP.\n"
       "  --space=number: Set the memory limit for the total of all running processes to this value in bytes.\n"
       "  --time=number: Set the time unit  limit for the total of all running processes to this value in bytes.\n"
-      "  --rate-limit=number: Set the maximum allowed number of concurrent accesses from a single IP.\n";
+      "  --rate-limit=number: Set the maximum allowed number of concurrent accesses from a single IP.\n"
+      "  --block-cache=number: Share up to this many bytes of decompressed blocks between the reading processes.\n";
 
       return 0;
     }
@@ -385,6 +389,11 @@ int main(int argc, char* argv[])
     files_to_manage.push_back(osm_base_settings().RELATION_TAGS_LOCAL);
     files_to_manage.push_back(osm_base_settings().RELATION_TAGS_GLOBAL);
     files_to_manage.push_back(osm_base_settings().RELATION_KEYS);
+    // The index from members to their parents is optional. Absent files are skipped when copied.
+    files_to_manage.push_back(osm_base_settings().NODE_PARENT_WAYS);
+    files_to_manage.push_back(osm_base_settings().NODE_PARENT_RELATIONS);
+    files_to_manage.push_back(osm_base_settings().WAY_PARENT_RELATIONS);
+    files_to_manage.push_back(osm_base_settings().RELATION_PARENT_RELATIONS);
 
     std::vector< File_Properties* >* file_target = (meta || attic) ? &files_to_manage : &files_to_avoid;
 
@@ -467,9 +476,11 @@ int main(int argc, char* argv[])
 	 areas ? area_settings().purge_timeout : osm_base_settings().purge_timeout,
 	 max_allowed_space,
 	 max_allowed_time_units,
-	 files_to_manage, &disp_logger);
+	 files_to_manage, &disp_logger, areas ? "area_version" : "osm_base_version");
     if (rate_limit > -1)
       dispatcher.set_rate_limit(rate_limit);
+    if (block_cache_size > 0)
+      dispatcher.set_block_cache_size(block_cache_size);
     dispatcher.standby_loop(0);
   }
   catch (File_Error e)
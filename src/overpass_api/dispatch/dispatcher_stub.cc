@@ -118,65 +118,82 @@ Dispatcher_Stub::Dispatcher_Stub
       logger.annotated_log(out.str());
       throw;
     }
-    transaction = new Nonsynced_Transaction
-        (false, false, dispatcher_client->get_db_dir(), "");
+    // A commit may replace the index files while they are opened. Then they are opened again.
+    // Opening only maps the index files. Each is decoded when the query first needs it,
+    // and the mapping keeps the generation of the file that was opened here.
+    uint32 index_generation = 0;
+    do
+    {
+      delete transaction;
+      index_generation = dispatcher_client->begin_index_snapshot();
+      transaction = new Nonsynced_Transaction
+          (false, false, dispatcher_client->get_db_dir(), "");
+      transaction->set_block_cache(dispatcher_client->get_block_cache());
 
-    transaction->data_index(osm_base_settings().NODES);
-    transaction->random_index(osm_base_settings().NODES);
-    transaction->data_index(osm_base_settings().NODE_TAGS_LOCAL);
-    transaction->data_index(osm_base_settings().NODE_TAGS_GLOBAL);
-    transaction->data_index(osm_base_settings().NODE_KEYS);
-    transaction->data_index(osm_base_settings().WAYS);
-    transaction->random_index(osm_base_settings().WAYS);
-    transaction->data_index(osm_base_settings().WAY_TAGS_LOCAL);
-    transaction->data_index(osm_base_settings().WAY_TAGS_GLOBAL);
-    transaction->data_index(osm_base_settings().WAY_KEYS);
-    transaction->data_index(osm_base_settings().RELATIONS);
-    transaction->random_index(osm_base_settings().RELATIONS);
-    transaction->data_index(osm_base_settings().RELATION_ROLES);
-    transaction->data_index(osm_base_settings().RELATION_TAGS_LOCAL);
-    transaction->data_index(osm_base_settings().RELATION_TAGS_GLOBAL);
-    transaction->data_index(osm_base_settings().RELATION_KEYS);
+      transaction->data_index(osm_base_settings().NODES);
+      transaction->random_index(osm_base_settings().NODES);
+      transaction->data_index(osm_base_settings().NODE_TAGS_LOCAL);
+      transaction->data_index(osm_base_settings().NODE_TAGS_GLOBAL);
+      transaction->data_index(osm_base_settings().NODE_KEYS);
+      transaction->data_index(osm_base_settings().WAYS);
+      transaction->random_index(osm_base_settings().WAYS);
+      transaction->data_index(osm_base_settings().WAY_TAGS_LOCAL);
+      transaction->data_index(osm_base_settings().WAY_TAGS_GLOBAL);
+      transaction->data_index(osm_base_settings().WAY_KEYS);
+      transaction->data_index(osm_base_settings().RELATIONS);
+      transaction->random_index(osm_base_settings().RELATIONS);
+      transaction->data_index(osm_base_settings().RELATION_ROLES);
+      transaction->data_index(osm_base_settings().RELATION_TAGS_LOCAL);
+      transaction->data_index(osm_base_settings().RELATION_TAGS_GLOBAL);
+      transaction->data_index(osm_base_settings().RELATION_KEYS);
+      if (has_parent_index(dispatcher_client->get_db_dir()))
+      {
+        transaction->data_index(osm_base_settings().NODE_PARENT_WAYS);
+        transaction->data_index(osm_base_settings().NODE_PARENT_RELATIONS);
+        transaction->data_index(osm_base_settings().WAY_PARENT_RELATIONS);
+        transaction->data_index(osm_base_settings().RELATION_PARENT_RELATIONS);
+      }
 
-    if (meta == keep_meta || meta == keep_attic)
-    {
-      transaction->data_index(meta_settings().NODES_META);
-      transaction->data_index(meta_settings().WAYS_META);
-      transaction->data_index(meta_settings().RELATIONS_META);
-      transaction->data_index(meta_settings().USER_DATA);
-      transaction->data_index(meta_settings().USER_INDICES);
-    }
+      if (meta == keep_meta || meta == keep_attic)
+      {
+        transaction->data_index(meta_settings().NODES_META);
+        transaction->data_index(meta_settings().WAYS_META);
+        transaction->data_index(meta_settings().RELATIONS_META);
+        transaction->data_index(meta_settings().USER_DATA);
+        transaction->data_index(meta_settings().USER_INDICES);
+      }
 
-    if (meta == keep_attic)
-    {
-      transaction->data_index(attic_settings().NODES);
-      transaction->data_index(attic_settings().NODES_UNDELETED);
-      transaction->data_index(attic_settings().NODE_IDX_LIST);
-      transaction->data_index(attic_settings().NODE_TAGS_LOCAL);
-      transaction->data_index(attic_settings().NODE_TAGS_GLOBAL);
-      transaction->data_index(attic_settings().NODES_META);
-      transaction->data_index(attic_settings().NODE_CHANGELOG);
-      transaction->data_index(attic_settings().WAYS);
-      transaction->data_index(attic_settings().WAYS_UNDELETED);
-      transaction->data_index(attic_settings().WAY_IDX_LIST);
-      transaction->data_index(attic_settings().WAY_TAGS_LOCAL);
-      transaction->data_index(attic_settings().WAY_TAGS_GLOBAL);
-      transaction->data_index(attic_settings().WAYS_META);
-      transaction->data_index(attic_settings().WAY_CHANGELOG);
-      transaction->data_index(attic_settings().RELATIONS);
-      transaction->data_index(attic_settings().RELATIONS_UNDELETED);
-      transaction->data_index(attic_settings().RELATION_IDX_LIST);
-      transaction->data_index(attic_settings().RELATION_TAGS_LOCAL);
-      transaction->data_index(attic_settings().RELATION_TAGS_GLOBAL);
-      transaction->data_index(attic_settings().RELATIONS_META);
-      transaction->data_index(attic_settings().RELATION_CHANGELOG);
-    }
+      if (meta == keep_attic)
+      {
+        transaction->data_index(attic_settings().NODES);
+        transaction->data_index(attic_settings().NODES_UNDELETED);
+        transaction->data_index(attic_settings().NODE_IDX_LIST);
+        transaction->data_index(attic_settings().NODE_TAGS_LOCAL);
+        transaction->data_index(attic_settings().NODE_TAGS_GLOBAL);
+        transaction->data_index(attic_settings().NODES_META);
+        transaction->data_index(attic_settings().NODE_CHANGELOG);
+        transaction->data_index(attic_settings().WAYS);
+        transaction->data_index(attic_settings().WAYS_UNDELETED);
+        transaction->data_index(attic_settings().WAY_IDX_LIST);
+        transaction->data_index(attic_settings().WAY_TAGS_LOCAL);
+        transaction->data_index(attic_settings().WAY_TAGS_GLOBAL);
+        transaction->data_index(attic_settings().WAYS_META);
+        transaction->data_index(attic_settings().WAY_CHANGELOG);
+        transaction->data_index(attic_settings().RELATIONS);
+        transaction->data_index(attic_settings().RELATIONS_UNDELETED);
+        transaction->data_index(attic_settings().RELATION_IDX_LIST);
+        transaction->data_index(attic_settings().RELATION_TAGS_LOCAL);
+        transaction->data_index(attic_settings().RELATION_TAGS_GLOBAL);
+        transaction->data_index(attic_settings().RELATIONS_META);
+        transaction->data_index(attic_settings().RELATION_CHANGELOG);
+      }
 
-    {
+      // The version must belong to the same snapshot as the index files
       std::ifstream version((dispatcher_client->get_db_dir() + "osm_base_version").c_str());
       getline(version, timestamp);
       timestamp = de_escape(timestamp);
     }
+    while (!dispatcher_client->index_snapshot_valid(index_generation));
     try
     {
       logger.annotated_log("read_idx_finished() start");
@@ -212,14 +229,25 @@ Dispatcher_Stub::Dispatcher_Stub
 	  logger.annotated_log(out.str());
 	  throw;
 	}
-	area_transaction = new Nonsynced_Transaction
-            (false, false, area_dispatcher_client->get_db_dir(), "");
+	uint32 index_generation = 0;
+	do
 	{
+	  delete area_transaction;
+	  index_generation = area_dispatcher_client->begin_index_snapshot();
+	  area_transaction = new Nonsynced_Transaction
+              (false, false, area_dispatcher_client->get_db_dir(), "");
+	  area_transaction->set_block_cache(area_dispatcher_client->get_block_cache());
+	  area_transaction->data_index(area_settings().AREAS);
+	  area_transaction->data_index(area_settings().AREA_BLOCKS);
+	  area_transaction->data_index(area_settings().AREA_TAGS_LOCAL);
+	  area_transaction->data_index(area_settings().AREA_TAGS_GLOBAL);
+
 	  std::ifstream version((area_dispatcher_client->get_db_dir() +
 	      "area_version").c_str());
 	  getline(version, area_timestamp);
 	  area_timestamp = de_escape(area_timestamp);
 	}
+	while (!area_dispatcher_client->index_snapshot_valid(index_generation));
       }
       else if (area_level == 2)
       {
@@ -244,13 +272,12 @@ Dispatcher_Stub::Dispatcher_Stub
 	  area_version<<timestamp<<'\n';
 	  area_timestamp = de_escape(timestamp);
 	}
+	area_transaction->data_index(area_settings().AREAS);
+	area_transaction->data_index(area_settings().AREA_BLOCKS);
+	area_transaction->data_index(area_settings().AREA_TAGS_LOCAL);
+	area_transaction->data_index(area_settings().AREA_TAGS_GLOBAL);
       }
 
-      area_transaction->data_index(area_settings().AREAS);
-      area_transaction->data_index(area_settings().AREA_BLOCKS);
-      area_transaction->data_index(area_settings().AREA_TAGS_LOCAL);
-      area_transaction->data_index(area_settings().AREA_TAGS_GLOBAL);
-
       if (area_level == 1)
       {
 	try
@@ -358,9 +385,8 @@ Dispatcher_Stub::~Dispatcher_Stub()
       try
       {
         logger.annotated_log("write_commit() area start");
+        // The dispatcher publishes area_version.shadow together with the index files
         area_dispatcher_client->write_commit();
-        rename((area_dispatcher_client->get_db_dir() + "area_version.shadow").c_str(),
-	       (area_dispatcher_client->get_db_dir() + "area_version").c_str());
         logger.annotated_log("write_commit() area end");
       }
       catch (const File_Error& e)
@@ -0,0 +1,549 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "web_query_core.h"
+#include "../core/settings.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+
+/* A long-running replacement for cgi-bin/interpreter behind a local reverse proxy.
+ *
+ * The server speaks plain HTTP/1.1 on a unix domain socket or on a port of the loopback
+ * interface. Settings, statement factories and loaded libraries are initialized once in the
+ * server process. Each connection is served by a process forked from it, which answers one
+ * request exactly like the interpreter: it registers with the dispatcher and runs the query
+ * with its own Resource_Manager and resource limits. The number of concurrent requests is
+ * bounded by the number of workers; further connections wait in the listen queue.
+ *
+ * The client address for rate limiting is the address of the peer. Behind a proxy, the
+ * operator names the header that carries the client address and the proxies whose header is
+ * honoured. Requests without a usable IPv4 address are rejected: an empty address would
+ * exempt them from rate limiting. */
+
+
+namespace
+{
+  const uint32 MAX_HEADER_SIZE = 64*1024;
+  const uint64 MAX_BODY_SIZE = 16*1024*1024;
+
+
+  // Connections on the unix domain socket have this peer address
+  const std::string UNIX_PEER = "unix";
+
+
+  struct Client_Address_Policy
+  {
+    // In lower case. Empty if no header is honoured.
+    std::string header;
+    std::set< std::string > trusted_proxies;
+  };
+
+
+  struct Http_Request
+  {
+    std::string method;
+    std::string target;
+    // Header names are in lower case
+    std::map< std::string, std::string > headers;
+    std::string body;
+  };
+
+
+  std::string trimmed(const std::string& input)
+  {
+    std::string::size_type begin = input.find_first_not_of(" \t\r");
+    if (begin == std::string::npos)
+      return "";
+    return input.substr(begin, input.find_last_not_of(" \t\r") - begin + 1);
+  }
+
+
+  bool write_all(int fd, const char* data, uint64 size)
+  {
+    while (size > 0)
+    {
+      ssize_t written = write(fd, data, size);
+      if (written < 0 && errno == EINTR)
+        continue;
+      if (written <= 0)
+        return false;
+      data += written;
+      size -= written;
+    }
+    return true;
+  }
+
+
+  void send_error(int fd, const std::string& status)
+  {
+    std::string response = "HTTP/1.1 " + status + "\r\n"
+        "Content-Type: text/plain\r\n"
+        "Connection: close\r\n\r\n" + status + "\n";
+    write_all(fd, response.data(), response.size());
+  }
+
+
+  // Returns an empty string on success or the HTTP status to answer with
+  std::string read_request(int fd, Http_Request& request)
+  {
+    std::string input;
+    std::string::size_type header_end = std::string::npos;
+    char buf[64*1024];
+    while (header_end == std::string::npos)
+    {
+      if (input.size() > MAX_HEADER_SIZE)
+        return "431 Request Header Fields Too Large";
+      ssize_t size = read(fd, buf, sizeof(buf));
+      if (size < 0 && errno == EINTR)
+        continue;
+      if (size <= 0)
+        return "400 Bad Request";
+      input.append(buf, size);
+      header_end = input.find("\r\n\r\n");
+    }
+
+    std::istringstream head(input.substr(0, header_end));
+    std::string line;
+    getline(head, line);
+    std::istringstream request_line(line);
+    std::string version;
+    request_line>>request.method>>request.target>>version;
+    if (request.target.empty() || version.substr(0, 5) != "HTTP/")
+      return "400 Bad Request";
+
+    while (getline(head, line))
+    {
+      std::string::size_type colon = line.find(':');
+      if (colon == std::string::npos)
+        continue;
+      std::string name = trimmed(line.substr(0, colon));
+      for (std::string::iterator it = name.begin(); it != name.end(); ++it)
+        *it = tolower(*it);
+      request.headers[name] = trimmed(line.substr(colon + 1));
+    }
+
+    if (request.headers.find("transfer-encoding") != request.headers.end())
+      return "411 Length Required";
+
+    uint64 content_length = 0;
+    std::map< std::string, std::string >::const_iterator it = request.headers.find("content-length");
+    if (it != request.headers.end())
+      content_length = strtoull(it->second.c_str(), 0, 10);
+    if (content_length > MAX_BODY_SIZE)
+      return "413 Payload Too Large";
+
+    request.body = input.substr(header_end + 4);
+    while (request.body.size() < content_length)
+    {
+      ssize_t size = read(fd, buf, std::min((uint64)sizeof(buf), content_length - request.body.size()));
+      if (size < 0 && errno == EINTR)
+        continue;
+      if (size <= 0)
+        return "400 Bad Request";
+      request.body.append(buf, size);
+    }
+    request.body.resize(content_length);
+
+    return "";
+  }
+
+
+  /* Returns the address in canonical form or an empty string if it is not an IPv4 address.
+   * The address 0.0.0.0 is rejected as well, because it would become the client token 0. */
+  std::string canonical_ipv4_address(const std::string& input)
+  {
+    in_addr addr;
+    char result[INET_ADDRSTRLEN];
+    if (inet_pton(AF_INET, input.c_str(), &addr) == 1 && addr.s_addr != htonl(INADDR_ANY)
+        && inet_ntop(AF_INET, &addr, result, sizeof(result)))
+      return result;
+    return "";
+  }
+
+
+  /* A request from a trusted proxy must carry the client address in the configured header.
+   * Any other request is attributed to its peer. Returns an empty string if there is no
+   * usable address. */
+  std::string client_address(const Http_Request& request, const std::string& peer_addr,
+      const Client_Address_Policy& policy)
+  {
+    if (!policy.header.empty() && policy.trusted_proxies.count(peer_addr))
+    {
+      std::map< std::string, std::string >::const_iterator it = request.headers.find(policy.header);
+      return it == request.headers.end() ? "" : canonical_ipv4_address(it->second);
+    }
+    return canonical_ipv4_address(peer_addr);
+  }
+
+
+  // Provides the request in the form the interpreter expects it from a web server
+  void set_cgi_environment(const Http_Request& request, const std::string& client_addr)
+  {
+    std::string::size_type question_mark = request.target.find('?');
+    setenv("REQUEST_METHOD", request.method.c_str(), 1);
+    setenv("QUERY_STRING", question_mark == std::string::npos ? ""
+        : request.target.substr(question_mark + 1).c_str(), 1);
+    setenv("REMOTE_ADDR", client_addr.c_str(), 1);
+
+    for (std::map< std::string, std::string >::const_iterator it = request.headers.begin();
+        it != request.headers.end(); ++it)
+    {
+      std::string name = (it->first == "content-length" || it->first == "content-type" ? "" : "HTTP_")
+          + it->first;
+      for (std::string::iterator nit = name.begin(); nit != name.end(); ++nit)
+        *nit = (*nit == '-' ? '_' : toupper(*nit));
+      setenv(name.c_str(), it->second.c_str(), 1);
+    }
+  }
+
+
+  /* Turns the CGI response written to it into an HTTP/1.1 response on the connection:
+   * the header lines up to the first empty line get a status line, taken from the Status
+   * header if present, and CRLF line ends. The body is passed unchanged. */
+  class Http_Response_Streambuf : public std::streambuf
+  {
+  public:
+    explicit Http_Response_Streambuf(int fd_) : fd(fd_), in_header(true), buf(64*1024)
+    {
+      setp(&buf[0], &buf[0] + buf.size());
+    }
+
+    // Sends all pending output. A response without body still gets a complete header.
+    bool finish()
+    {
+      if (!flush_buffer())
+        return false;
+      if (in_header)
+        return send_header(header);
+      return true;
+    }
+
+  protected:
+    virtual int_type overflow(int_type c)
+    {
+      if (!flush_buffer())
+        return traits_type::eof();
+      if (!traits_type::eq_int_type(c, traits_type::eof()))
+      {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+      }
+      return traits_type::not_eof(c);
+    }
+
+    virtual int sync()
+    {
+      return flush_buffer() ? 0 : -1;
+    }
+
+  private:
+    int fd;
+    bool in_header;
+    std::string header;
+    std::vector< char > buf;
+
+    bool flush_buffer()
+    {
+      uint32 size = pptr() - pbase();
+      setp(&buf[0], &buf[0] + buf.size());
+      if (!in_header)
+        return write_all(fd, &buf[0], size);
+
+      header.append(&buf[0], size);
+      std::string::size_type header_end = header.find("\n\n");
+      if (header_end == std::string::npos)
+        return true;
+
+      std::string body = header.substr(header_end + 2);
+      if (!send_header(header.substr(0, header_end + 1)))
+        return false;
+      return write_all(fd, body.data(), body.size());
+    }
+
+    bool send_header(const std::string& cgi_header)
+    {
+      in_header = false;
+      std::string status = "200 OK";
+      std::string fields;
+
+      std::istringstream in(cgi_header);
+      std::string line;
+      while (getline(in, line))
+      {
+        if (line.empty())
+          continue;
+        if (line.size() > 7 && strncasecmp(line.c_str(), "Status:", 7) == 0)
+          status = trimmed(line.substr(7));
+        else
+          fields += line + "\r\n";
+      }
+
+      std::string response = "HTTP/1.1 " + status + "\r\n" + fields + "Connection: close\r\n\r\n";
+      return write_all(fd, response.data(), response.size());
+    }
+  };
+
+
+  int serve_connection(int fd, const std::string& peer_addr, const Client_Address_Policy& policy)
+  {
+    timeval timeout;
+    timeout.tv_sec = 60;
+    timeout.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    Http_Request request;
+    std::string error = read_request(fd, request);
+    if (!error.empty())
+    {
+      send_error(fd, error);
+      return 0;
+    }
+
+    std::string client_addr = client_address(request, peer_addr, policy);
+    if (client_addr.empty())
+    {
+      send_error(fd, "400 Bad Request");
+      return 0;
+    }
+    set_cgi_environment(request, client_addr);
+
+    std::istringstream body(request.body);
+    std::cin.rdbuf(body.rdbuf());
+    Http_Response_Streambuf response(fd);
+    std::streambuf* stdout_buf = std::cout.rdbuf(&response);
+
+    int result = process_web_query();
+
+    std::cout.flush();
+    response.finish();
+    std::cout.rdbuf(stdout_buf);
+    return result;
+  }
+
+
+  int open_unix_socket(const std::string& path)
+  {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+    {
+      std::cerr<<"query_server: socket path too long: "<<path<<'\n';
+      return -1;
+    }
+    strcpy(addr.sun_path, path.c_str());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+      return -1;
+    unlink(path.c_str());
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0)
+    {
+      close(fd);
+      return -1;
+    }
+    return fd;
+  }
+
+
+  int open_local_tcp_socket(uint16 port)
+  {
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+      return -1;
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0)
+    {
+      close(fd);
+      return -1;
+    }
+    return fd;
+  }
+
+
+  std::string peer_address(const sockaddr_storage& addr)
+  {
+    if (addr.ss_family == AF_UNIX)
+      return UNIX_PEER;
+    if (addr.ss_family == AF_INET)
+    {
+      char result[INET_ADDRSTRLEN];
+      if (inet_ntop(AF_INET, &((const sockaddr_in*)&addr)->sin_addr, result, sizeof(result)))
+        return result;
+    }
+    return "";
+  }
+}
+
+
+int main(int argc, char* argv[])
+{
+  // read command line arguments
+  std::string socket_path;
+  uint32 port = 0;
+  uint32 workers = sysconf(_SC_NPROCESSORS_ONLN);
+  Client_Address_Policy policy;
+
+  int argpos(1);
+  while (argpos < argc)
+  {
+    if (!(strncmp(argv[argpos], "--socket=", 9)))
+      socket_path = ((std::string)argv[argpos]).substr(9);
+    else if (!(strncmp(argv[argpos], "--port=", 7)))
+      port = atoll(((std::string)argv[argpos]).substr(7).c_str());
+    else if (!(strncmp(argv[argpos], "--workers=", 10)))
+      workers = atoll(((std::string)argv[argpos]).substr(10).c_str());
+    else if (!(strncmp(argv[argpos], "--client-address-header=", 24)))
+    {
+      policy.header = ((std::string)argv[argpos]).substr(24);
+      for (std::string::iterator it = policy.header.begin(); it != policy.header.end(); ++it)
+        *it = tolower(*it);
+    }
+    else if (!(strncmp(argv[argpos], "--trusted-proxy=", 16)))
+    {
+      std::string proxy = ((std::string)argv[argpos]).substr(16);
+      if (proxy != UNIX_PEER)
+        proxy = canonical_ipv4_address(proxy);
+      if (proxy.empty())
+      {
+        std::cout<<"Please specify an IPv4 address or \""<<UNIX_PEER<<"\" for --trusted-proxy.\n";
+        return 0;
+      }
+      policy.trusted_proxies.insert(proxy);
+    }
+    else
+    {
+      std::cout<<"Unknown argument: "<<argv[argpos]<<"\n\n"
+      "Accepted arguments are:\n"
+      "  --socket=$PATH: Listen on the unix domain socket $PATH.\n"
+      "  --port=$PORT: Listen on port $PORT of the loopback interface.\n"
+      "  --workers=$N: Answer at most $N requests at the same time.\n"
+      "    Defaults to the number of processors.\n"
+      "  --client-address-header=$NAME: Take the client address from the header $NAME,\n"
+      "    e.g. X-Real-IP, on connections from trusted proxies.\n"
+      "  --trusted-proxy=$ADDR: Trust the proxy with the IPv4 address $ADDR. May be repeated.\n"
+      "    Use \"unix\" to trust the peers on the unix domain socket.\n";
+      return 0;
+    }
+    ++argpos;
+  }
+
+  if ((socket_path.empty()) == (port == 0) || port > 65535)
+  {
+    std::cout<<"Please specify exactly one of --socket=$PATH or --port=$PORT.\n";
+    return 0;
+  }
+  if (policy.header.empty() != policy.trusted_proxies.empty())
+  {
+    std::cout<<"Please specify --client-address-header and --trusted-proxy together.\n";
+    return 0;
+  }
+  // The peers on a unix domain socket have no address of their own
+  if (!socket_path.empty() && !policy.trusted_proxies.count(UNIX_PEER))
+  {
+    std::cout<<"With --socket, please specify --client-address-header and --trusted-proxy=unix.\n";
+    return 0;
+  }
+  if (workers == 0)
+    workers = 1;
+
+  int listen_fd = socket_path.empty() ? open_local_tcp_socket(port) : open_unix_socket(socket_path);
+  if (listen_fd < 0 || listen(listen_fd, 128) < 0)
+  {
+    std::cerr<<"query_server: cannot listen: "<<strerror(errno)<<'\n';
+    return 1;
+  }
+
+  // A client that disconnects early must not kill the process before it has unregistered
+  // from the dispatcher.
+  signal(SIGPIPE, SIG_IGN);
+
+  // Warm up the settings such that the request processes inherit them
+  basic_settings();
+  osm_base_settings();
+  area_settings();
+  meta_settings();
+  attic_settings();
+
+  uint32 running = 0;
+  while (true)
+  {
+    // Finished request processes are collected before each new connection. At most
+    // workers of them can be left over while the server is idle.
+    while (running > 0 && waitpid(-1, 0, running >= workers ? 0 : WNOHANG) > 0)
+      --running;
+
+    sockaddr_storage addr;
+    socklen_t addr_len = sizeof(addr);
+    int fd = accept(listen_fd, (sockaddr*)&addr, &addr_len);
+    if (fd < 0)
+    {
+      if (errno != EINTR && errno != ECONNABORTED)
+        std::cerr<<"query_server: accept: "<<strerror(errno)<<'\n';
+      continue;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+      close(listen_fd);
+      int result = serve_connection(fd, peer_address(addr), policy);
+      close(fd);
+      exit(result);
+    }
+    else if (pid > 0)
+      ++running;
+    else
+    {
+      std::cerr<<"query_server: fork: "<<strerror(errno)<<'\n';
+      send_error(fd, "503 Service Unavailable");
+    }
+    close(fd);
+  }
+
+  return 0;
+}
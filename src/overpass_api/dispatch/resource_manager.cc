@@ -19,6 +19,7 @@
 #include "resource_manager.h"
 #include "../data/abstract_processing.h"
 #include "../data/utils.h"
+#include "../core/settings.h"
 #include "../statements/statement.h"
 
 #include <sstream>
@@ -404,7 +405,8 @@ Resource_Manager::Resource_Manager(
         area_transaction(0), area_updater_(0),
         watchdog(watchdog_), global_settings(global_settings_), global_settings_owned(false),
 	start_time(time(NULL)), last_ping_time(0), last_report_time(0),
-	max_allowed_time(0), max_allowed_space(0)
+	max_allowed_time(0), max_allowed_space(0), max_parallel_threads(1), main_thread(pthread_self()),
+	parent_index_present(::has_parent_index(transaction_.get_db_dir()))
 {
   if (!global_settings)
   {
@@ -423,7 +425,8 @@ Resource_Manager::Resource_Manager(
       area_transaction(&area_transaction_), area_updater_(area_updater__),
       watchdog(watchdog_), global_settings(&global_settings_), global_settings_owned(false),
       start_time(time(NULL)), last_ping_time(0), last_report_time(0),
-      max_allowed_time(0), max_allowed_space(0)
+      max_allowed_time(0), max_allowed_space(0), max_parallel_threads(1), main_thread(pthread_self()),
+      parent_index_present(::has_parent_index(transaction_.get_db_dir()))
 {
   runtime_stack.push_back(new Runtime_Stack_Frame());
 }
@@ -633,6 +636,22 @@ void Resource_Manager::health_check(const Statement& stmt, uint32 extra_time, ui
   if (max_allowed_time > 0)
     elapsed_time = time(NULL) - start_time + extra_time;
 
+  if (!pthread_equal(pthread_self(), main_thread))
+  {
+    // The main thread reports the error after it has collected its workers
+    if (elapsed_time > max_allowed_time)
+    {
+      Resource_Error error;
+      error.timed_out = true;
+      error.stmt_name = stmt.get_name();
+      error.line_number = stmt.get_line_number();
+      error.size = 0;
+      error.runtime = elapsed_time;
+      throw error;
+    }
+    return;
+  }
+
   if (elapsed_time >= last_ping_time + 5)
   {
     if (watchdog)
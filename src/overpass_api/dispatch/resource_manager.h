@@ -20,6 +20,7 @@
 #define DE__OSM3S___OVERPASS_API__DISPATCH__RESOURCE_MANAGER_H
 
 #include <ctime>
+#include <pthread.h>
 #include "../../template_db/transaction.h"
 #include "../core/datatypes.h"
 #include "../core/parsed_query.h"
@@ -157,6 +158,8 @@ public:
 
   void log_and_display_error(std::string message);
 
+  // May also be called from the worker threads of a statement. There it only enforces the
+  // timeout. Pings, progress reports and the space limit are left to the main thread.
   void health_check(const Statement& stmt, uint32 extra_time = 0, uint64 extra_space = 0);
 
   void set_limits(uint32 max_allowed_time_, uint64 max_allowed_space_)
@@ -165,9 +168,16 @@ public:
     max_allowed_space = max_allowed_space_;
   }
 
+  void set_max_parallel_threads(uint32 max_parallel_threads_) { max_parallel_threads = max_parallel_threads_; }
+  uint32 get_max_parallel_threads() const { return max_parallel_threads; }
+
   Transaction* get_transaction() { return transaction; }
   Transaction* get_area_transaction() { return area_transaction; }
 
+  // Whether the database has the index from members to their parents.
+  // It is checked once when the query starts.
+  bool has_parent_index() const { return parent_index_present; }
+
   uint64 get_desired_timestamp() const;
   Diff_Action::_ get_desired_action() const;
   uint64 get_diff_from_timestamp() const;
@@ -180,6 +190,10 @@ public:
   void switch_diff_show_to(const std::string& diff_set_name);
 
   const std::map< uint32, std::string >& users() { return user_data_cache.users(*transaction); }
+  const std::map< uint32, std::string >& users(const std::set< uint32 >& user_ids)
+  { return user_data_cache.users(*transaction, user_ids); }
+  const std::map< uint32, std::string >& users(uint32 user_id)
+  { return user_data_cache.users(*transaction, user_id); }
 
   void start_cpu_timer(uint index);
   void stop_cpu_timer(uint index);
@@ -201,6 +215,9 @@ private:
   uint32 last_report_time;
   uint32 max_allowed_time;
   uint64 max_allowed_space;
+  uint32 max_parallel_threads;
+  pthread_t main_thread;
+  bool parent_index_present;
 
   std::vector< clock_t > cpu_start_time;
   std::vector< uint64 > cpu_runtime;
@@ -0,0 +1,278 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "compressed_output.h"
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+
+namespace
+{
+  std::string trimmed_lower(const std::string& input)
+  {
+    std::string::size_type begin = input.find_first_not_of(" \t");
+    if (begin == std::string::npos)
+      return "";
+    std::string::size_type end = input.find_last_not_of(" \t");
+    std::string result = input.substr(begin, end - begin + 1);
+    for (std::string::iterator it = result.begin(); it != result.end(); ++it)
+      *it = tolower(*it);
+    return result;
+  }
+}
+
+
+void Response_Compression::negotiate(const char* accept_encoding)
+{
+  encoding = identity;
+  if (!accept_encoding || level <= 0)
+    return;
+
+  // An explicitly named encoding takes precedence over the wildcard
+  double gzip_q = -1;
+  double zstd_q = -1;
+  double wildcard_q = -1;
+
+  std::string header(accept_encoding);
+  std::string::size_type pos = 0;
+  while (pos < header.size())
+  {
+    std::string::size_type end = header.find(',', pos);
+    if (end == std::string::npos)
+      end = header.size();
+    std::string token = header.substr(pos, end - pos);
+    pos = end + 1;
+
+    std::string::size_type semicolon = token.find(';');
+    std::string name = trimmed_lower(token.substr(0, semicolon));
+    double q = 1.0;
+    if (semicolon != std::string::npos)
+    {
+      std::string param = trimmed_lower(token.substr(semicolon + 1));
+      if (param.substr(0, 2) == "q=")
+        q = strtod(param.c_str() + 2, 0);
+    }
+
+    if (name == "gzip" || name == "x-gzip")
+      gzip_q = q;
+    else if (name == "zstd")
+      zstd_q = q;
+    else if (name == "*")
+      wildcard_q = q;
+  }
+
+  if (gzip_q < 0)
+    gzip_q = wildcard_q;
+  if (zstd_q < 0)
+    zstd_q = wildcard_q;
+
+#ifdef HAVE_ZSTD
+  if (zstd_q > 0 && zstd_q >= gzip_q)
+    encoding = zstd;
+  else
+#endif
+  if (gzip_q > 0)
+    encoding = gzip;
+}
+
+
+void Response_Compression::read_settings_from_env()
+{
+  const char* level_c = getenv("OVERPASS_COMPRESSION_LEVEL");
+  if (level_c && *level_c)
+    level = atoi(level_c);
+  const char* flush_c = getenv("OVERPASS_COMPRESSION_FLUSH");
+  if (flush_c && *flush_c)
+    flush_interval = strtoul(flush_c, 0, 10);
+}
+
+
+const char* Response_Compression::encoding_name() const
+{
+  if (encoding == gzip)
+    return "gzip";
+  else if (encoding == zstd)
+    return "zstd";
+  return "identity";
+}
+
+
+Compressing_Streambuf::Compressing_Streambuf(std::streambuf* target_, const Response_Compression& settings)
+    : target(target_), encoding(settings.encoding), flush_interval(settings.flush_interval),
+    unflushed(0), finished(false), in_buf(64*1024), out_buf(64*1024), zstd_strm(0)
+{
+  if (encoding == Response_Compression::gzip)
+  {
+    zlib_strm.zalloc = Z_NULL;
+    zlib_strm.zfree = Z_NULL;
+    zlib_strm.opaque = Z_NULL;
+    // Adding 16 to the window bits selects the gzip format instead of the zlib format
+    int ret = deflateInit2(&zlib_strm, std::max(1, std::min(settings.level, 9)),
+        Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    if (ret == Z_MEM_ERROR)
+      throw std::bad_alloc();
+    else if (ret != Z_OK)
+      throw std::runtime_error("Compressing_Streambuf: deflateInit2 failed");
+  }
+#ifdef HAVE_ZSTD
+  else if (encoding == Response_Compression::zstd)
+  {
+    zstd_strm = ZSTD_createCStream();
+    if (!zstd_strm)
+      throw std::bad_alloc();
+    size_t ret = ZSTD_initCStream(zstd_strm, std::max(1, std::min(settings.level, ZSTD_maxCLevel())));
+    if (ZSTD_isError(ret))
+    {
+      ZSTD_freeCStream(zstd_strm);
+      throw std::runtime_error("Compressing_Streambuf: ZSTD_initCStream failed");
+    }
+  }
+#endif
+  else
+    throw std::runtime_error("Compressing_Streambuf: unsupported encoding");
+
+  setp(&in_buf[0], &in_buf[0] + in_buf.size());
+}
+
+
+Compressing_Streambuf::~Compressing_Streambuf()
+{
+  finish();
+
+  if (encoding == Response_Compression::gzip)
+    deflateEnd(&zlib_strm);
+#ifdef HAVE_ZSTD
+  else if (encoding == Response_Compression::zstd)
+    ZSTD_freeCStream(zstd_strm);
+#endif
+}
+
+
+void Compressing_Streambuf::finish()
+{
+  if (finished)
+    return;
+  compress(finish_stream);
+  finished = true;
+}
+
+
+Compressing_Streambuf::int_type Compressing_Streambuf::overflow(int_type c)
+{
+  if (finished)
+    setp(&in_buf[0], &in_buf[0] + in_buf.size());
+  else if (!compress(no_flush))
+    return traits_type::eof();
+
+  if (!traits_type::eq_int_type(c, traits_type::eof()))
+  {
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+  }
+  return traits_type::not_eof(c);
+}
+
+
+int Compressing_Streambuf::sync()
+{
+  if (finished)
+    return 0;
+  return compress(sync_flush) ? 0 : -1;
+}
+
+
+bool Compressing_Streambuf::write_out(uint32 size)
+{
+  return size == 0 || target->sputn(&out_buf[0], size) == (std::streamsize)size;
+}
+
+
+bool Compressing_Streambuf::compress(Flush_Mode mode)
+{
+  uint32 size = pptr() - pbase();
+  setp(&in_buf[0], &in_buf[0] + in_buf.size());
+
+  unflushed += size;
+  if (mode == no_flush && flush_interval > 0 && unflushed >= flush_interval)
+    mode = sync_flush;
+
+  if (encoding == Response_Compression::gzip)
+  {
+    zlib_strm.next_in = (Bytef*)&in_buf[0];
+    zlib_strm.avail_in = size;
+    int flush = (mode == finish_stream ? Z_FINISH : (mode == sync_flush ? Z_SYNC_FLUSH : Z_NO_FLUSH));
+    do
+    {
+      zlib_strm.next_out = (Bytef*)&out_buf[0];
+      zlib_strm.avail_out = out_buf.size();
+      if (deflate(&zlib_strm, flush) == Z_STREAM_ERROR)
+        return false;
+      if (!write_out(out_buf.size() - zlib_strm.avail_out))
+        return false;
+    }
+    while (zlib_strm.avail_out == 0);
+  }
+#ifdef HAVE_ZSTD
+  else if (encoding == Response_Compression::zstd)
+  {
+    ZSTD_inBuffer input = { &in_buf[0], size, 0 };
+    while (input.pos < input.size)
+    {
+      ZSTD_outBuffer output = { &out_buf[0], out_buf.size(), 0 };
+      if (ZSTD_isError(ZSTD_compressStream(zstd_strm, &output, &input)))
+        return false;
+      if (!write_out(output.pos))
+        return false;
+    }
+
+    if (mode != no_flush)
+    {
+      size_t remaining = 0;
+      do
+      {
+        ZSTD_outBuffer output = { &out_buf[0], out_buf.size(), 0 };
+        remaining = (mode == finish_stream ? ZSTD_endStream(zstd_strm, &output)
+            : ZSTD_flushStream(zstd_strm, &output));
+        if (ZSTD_isError(remaining))
+          return false;
+        if (!write_out(output.pos))
+          return false;
+      }
+      while (remaining > 0);
+    }
+  }
+#endif
+
+  if (mode != no_flush)
+  {
+    unflushed = 0;
+    target->pubsync();
+  }
+  return true;
+}
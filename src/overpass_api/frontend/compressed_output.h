@@ -0,0 +1,95 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DE__OSM3S___OVERPASS_API__FRONTEND__COMPRESSED_OUTPUT_H
+#define DE__OSM3S___OVERPASS_API__FRONTEND__COMPRESSED_OUTPUT_H
+
+#include "../../template_db/types.h"
+
+#include <streambuf>
+#include <vector>
+
+#include <zlib.h>
+
+
+// The stream type of zstd, used only if configured with --enable-zstd
+struct ZSTD_CCtx_s;
+
+
+/* How a response is compressed. A level of zero disables compression.
+ * Whenever flush_interval bytes of uncompressed output have accumulated, the compressed data
+ * so far is passed on such that the client can start to process the response early.
+ * A flush_interval of zero flushes only at the end of the response. */
+struct Response_Compression
+{
+  enum Encoding { identity, gzip, zstd };
+
+  Response_Compression() : encoding(identity), level(6), flush_interval(64*1024) {}
+
+  Encoding encoding;
+  int level;
+  uint32 flush_interval;
+
+  // Chooses the best supported encoding from the value of an Accept-Encoding header
+  void negotiate(const char* accept_encoding);
+  // Takes level and flush interval from the environment variables
+  // OVERPASS_COMPRESSION_LEVEL and OVERPASS_COMPRESSION_FLUSH if they are set
+  void read_settings_from_env();
+
+  // The value for the Content-Encoding header
+  const char* encoding_name() const;
+};
+
+
+/* Compresses everything written to it and passes the result to target.
+ * A sync() forces the compressed data so far to the target. */
+class Compressing_Streambuf : public std::streambuf
+{
+public:
+  Compressing_Streambuf(std::streambuf* target, const Response_Compression& settings);
+  virtual ~Compressing_Streambuf();
+
+  // Writes the end of the compressed stream. Later output is discarded.
+  void finish();
+
+protected:
+  virtual int_type overflow(int_type c);
+  virtual int sync();
+
+private:
+  enum Flush_Mode { no_flush, sync_flush, finish_stream };
+
+  std::streambuf* target;
+  Response_Compression::Encoding encoding;
+  uint32 flush_interval;
+  uint64 unflushed;
+  bool finished;
+  std::vector< char > in_buf;
+  std::vector< char > out_buf;
+  z_stream zlib_strm;
+  ZSTD_CCtx_s* zstd_strm;
+
+  bool compress(Flush_Mode mode);
+  bool write_out(uint32 size);
+
+  Compressing_Streambuf(const Compressing_Streambuf&);
+  Compressing_Streambuf& operator=(const Compressing_Streambuf&);
+};
+
+
+#endif
@@ -0,0 +1,265 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DE__OSM3S___OVERPASS_API__FRONTEND__OUTPUT_BUFFER_H
+#define DE__OSM3S___OVERPASS_API__FRONTEND__OUTPUT_BUFFER_H
+
+#include "../../template_db/types.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+
+// Select the formatting of a value written to an Output_Buffer,
+// e.g. out<<" lat=\""<<Fixed_Coord(lat)<<"\" v=\""<<Xml_Escaped(value)<<'\"'
+
+struct Fixed_Coord
+{
+  explicit Fixed_Coord(double value_) : value(value_) {}
+  double value;
+};
+
+
+struct Json_Escaped
+{
+  explicit Json_Escaped(const std::string& value_) : value(value_) {}
+  const std::string& value;
+};
+
+
+struct Xml_Escaped
+{
+  explicit Xml_Escaped(const std::string& value_) : value(value_) {}
+  const std::string& value;
+};
+
+
+/* Collects output in a fixed buffer and passes it to the stream buffer of out
+ * when it is full or destroyed. Numbers are formatted without the locale machinery
+ * of iostreams, and strings are escaped while they are copied.
+ *
+ * An Output_Buffer is meant to live for the output of one item. Everything written
+ * to out directly in the meantime would appear before the buffered content. */
+class Output_Buffer
+{
+  Output_Buffer(const Output_Buffer&);
+  Output_Buffer& operator=(const Output_Buffer&);
+
+public:
+  explicit Output_Buffer(std::ostream& out_) : out(&out_), pos(0) {}
+  ~Output_Buffer() { flush(); }
+
+  Output_Buffer& operator<<(const char* s) { write(s, strlen(s)); return *this; }
+  Output_Buffer& operator<<(const std::string& s) { write(s.data(), s.size()); return *this; }
+  Output_Buffer& operator<<(char c)
+  {
+    if (pos == SIZE)
+      flush();
+    buf[pos++] = c;
+    return *this;
+  }
+  Output_Buffer& operator<<(uint64 value);
+  Output_Buffer& operator<<(uint32 value) { return *this<<(uint64)value; }
+  Output_Buffer& operator<<(int64 value);
+  Output_Buffer& operator<<(int32 value) { return *this<<(int64)value; }
+  Output_Buffer& operator<<(const Fixed_Coord& coord) { write_coord(coord.value); return *this; }
+  Output_Buffer& operator<<(const Json_Escaped& s) { write_json_escaped(s.value); return *this; }
+  Output_Buffer& operator<<(const Xml_Escaped& s) { write_xml_escaped(s.value); return *this; }
+
+  // Writes value like std::fixed<<std::setprecision(7) does
+  void write_coord(double value);
+  // Escapes like escape_cstr()
+  void write_json_escaped(const std::string& s);
+  // Escapes like escape_xml()
+  void write_xml_escaped(const std::string& s);
+
+  void write(const char* s, uint32 size);
+  void flush();
+
+private:
+  static const uint32 SIZE = 4096;
+
+  std::ostream* out;
+  uint32 pos;
+  char buf[SIZE];
+
+  void write_fixed7(int64 value);
+};
+
+
+inline void Output_Buffer::write(const char* s, uint32 size)
+{
+  if (pos + size > SIZE)
+  {
+    flush();
+    if (size > SIZE)
+    {
+      out->rdbuf()->sputn(s, size);
+      return;
+    }
+  }
+  memcpy(buf + pos, s, size);
+  pos += size;
+}
+
+
+inline void Output_Buffer::flush()
+{
+  if (pos > 0)
+    out->rdbuf()->sputn(buf, pos);
+  pos = 0;
+}
+
+
+inline Output_Buffer& Output_Buffer::operator<<(uint64 value)
+{
+  char digits[20];
+  int i = 20;
+  do
+  {
+    digits[--i] = '0' + value % 10;
+    value /= 10;
+  }
+  while (value > 0);
+  write(digits + i, 20 - i);
+  return *this;
+}
+
+
+inline Output_Buffer& Output_Buffer::operator<<(int64 value)
+{
+  if (value < 0)
+  {
+    *this<<'-';
+    return *this<<(uint64)0 - (uint64)value;
+  }
+  return *this<<(uint64)value;
+}
+
+
+inline void Output_Buffer::write_fixed7(int64 value)
+{
+  uint64 abs_value = value;
+  if (value < 0)
+  {
+    *this<<'-';
+    abs_value = (uint64)0 - (uint64)value;
+  }
+  *this<<(abs_value / 10000000);
+
+  char digits[8];
+  digits[0] = '.';
+  uint32 fraction = abs_value % 10000000;
+  for (int i = 7; i > 0; --i)
+  {
+    digits[i] = '0' + fraction % 10;
+    fraction /= 10;
+  }
+  write(digits, 8);
+}
+
+
+inline void Output_Buffer::write_coord(double value)
+{
+  // Coordinates are multiples of 1e-7 up to rounding errors. The rare values near a tie,
+  // zero with its sign, or values out of range are left to snprintf to get the same digits.
+  double scaled = value * 10000000.;
+  if (scaled > -1e18 && scaled < 1e18)
+  {
+    double rounded = floor(scaled + 0.5);
+    if (fabs(scaled - rounded) < 0.4 && rounded != 0)
+    {
+      write_fixed7((int64)rounded);
+      return;
+    }
+  }
+
+  char digits[400];
+  int size = snprintf(digits, sizeof(digits), "%.7f", value);
+  if (size > 0)
+    write(digits, std::min(size, (int)sizeof(digits) - 1));
+}
+
+
+inline void Output_Buffer::write_json_escaped(const std::string& s)
+{
+  const char* begin = s.data();
+  const char* end = begin + s.size();
+  const char* run = begin;
+  for (const char* it = begin; it != end; ++it)
+  {
+    if (*it != '\"' && *it != '\\' && (unsigned char)*it >= 32)
+      continue;
+
+    write(run, it - run);
+    run = it + 1;
+    if (*it == '\"')
+      write("\\\"", 2);
+    else if (*it == '\\')
+      write("\\\\", 2);
+    else if (*it == '\n')
+      write("\\n", 2);
+    else if (*it == '\t')
+      write("\\t", 2);
+    else if (*it == '\r')
+      write("\\r", 2);
+    else
+      *this<<'?';
+  }
+  write(run, end - run);
+}
+
+
+inline void Output_Buffer::write_xml_escaped(const std::string& s)
+{
+  const char* begin = s.data();
+  const char* end = begin + s.size();
+  const char* run = begin;
+  for (const char* it = begin; it != end; ++it)
+  {
+    if (*it != '&' && *it != '\"' && *it != '<' && *it != '>' && (unsigned char)*it >= 32)
+      continue;
+
+    write(run, it - run);
+    run = it + 1;
+    if (*it == '&')
+      write("&amp;", 5);
+    else if (*it == '\"')
+      write("&quot;", 6);
+    else if (*it == '<')
+      write("&lt;", 4);
+    else if (*it == '>')
+      write("&gt;", 4);
+    else if (*it == '\n')
+      write("&#x0a;", 6);
+    else if (*it == '\t')
+      write("&#x09;", 6);
+    else if (*it == '\r')
+      write("&#x0d;", 6);
+    else
+      *this<<'?';
+  }
+  write(run, end - run);
+}
+
+
+#endif
@@ -170,7 +170,22 @@ void Web_Output::write_payload_header
       std::cout<<"Access-Control-Allow-Methods: GET, POST, OPTIONS\n"
             "Content-Length: 0\n";
     if (!output_handler || output_handler->write_http_headers())
+    {
+      // The body is compressed only if its headers are complete at this point
+      if (compression.encoding != Response_Compression::identity
+          && http_method != http_options && http_method != http_head)
+      {
+        compressor = new Compressing_Streambuf(std::cout.rdbuf(), compression);
+        std::cout<<"Content-Encoding: "<<compression.encoding_name()<<"\n"
+            "Vary: Accept-Encoding\n";
+      }
       std::cout<<'\n';
+      if (compressor)
+      {
+        std::cout.flush();
+        plain_buf = std::cout.rdbuf(compressor);
+      }
+    }
     if (http_method == http_options || http_method == http_head)
       return;
   }
@@ -276,6 +291,20 @@ void Web_Output::write_footer()
     output_handler->write_footer();
 
   header_written = final;
+  stop_compression();
+}
+
+
+void Web_Output::stop_compression()
+{
+  if (!compressor)
+    return;
+
+  compressor->finish();
+  std::cout.rdbuf(plain_buf);
+  std::cout.flush();
+  delete compressor;
+  compressor = 0;
 }
 
 
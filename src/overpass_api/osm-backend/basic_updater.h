@@ -20,11 +20,14 @@
 #define DE__OSM3S___OVERPASS_API__OSM_BACKEND__BASIC_UPDATER_H
 
 #include <algorithm>
+#include <iterator>
 #include <map>
 #include <set>
 #include <vector>
 
 #include "../../template_db/block_backend.h"
+#include "../../template_db/parallel_jobs.h"
+#include "../../template_db/random_file.h"
 #include "../../template_db/transaction.h"
 #include "../core/datatypes.h"
 #include "../core/settings.h"
@@ -517,6 +520,109 @@ void update_elements
 }
 
 
+template< typename Index, typename Object >
+struct Update_Elements_Job : public Parallel_Job
+{
+  Update_Elements_Job(const std::map< Index, std::set< Object > >* attic_objects_,
+      const std::map< Index, std::set< Object > >& new_objects_, File_Blocks_Index_Base* index_)
+      : attic_objects(attic_objects_ ? attic_objects_ : &no_objects), new_objects(&new_objects_),
+        index(index_) {}
+
+  virtual void run()
+  {
+    Block_Backend< Index, Object > db(index);
+    db.update(*attic_objects, *new_objects);
+  }
+
+private:
+  std::map< Index, std::set< Object > > no_objects;
+  const std::map< Index, std::set< Object > >* attic_objects;
+  const std::map< Index, std::set< Object > >* new_objects;
+  File_Blocks_Index_Base* index;
+};
+
+
+template< typename Id_Type >
+struct Update_Map_Positions_Job : public Parallel_Job
+{
+  Update_Map_Positions_Job(const std::vector< std::pair< Id_Type, Uint31_Index > >& new_idx_positions_,
+      Random_File_Index* index_)
+      : new_idx_positions(&new_idx_positions_), index(index_) {}
+
+  virtual void run()
+  {
+    Random_File< Id_Type, Uint31_Index > random(index);
+    for (typename std::vector< std::pair< Id_Type, Uint31_Index > >::const_iterator
+        it = new_idx_positions->begin(); it != new_idx_positions->end(); ++it)
+      random.put(it->first.val(), it->second);
+  }
+
+private:
+  const std::vector< std::pair< Id_Type, Uint31_Index > >* new_idx_positions;
+  Random_File_Index* index;
+};
+
+
+/* Collects the writes to different files of an update and runs them concurrently,
+ * because each file is written by its own Block_Backend or Random_File.
+ * The indexes are opened when a write is added, as the Transaction is not thread-safe.
+ * The changes are held by reference and must stay alive until run() has returned.
+ * Each file may be added at most once per run(). The only state that the jobs share is
+ * global_read_counter(), which is atomic. */
+class Parallel_Updates
+{
+public:
+  Parallel_Updates(Transaction& transaction_, uint max_threads_)
+      : transaction(&transaction_), max_threads(max_threads_) {}
+  ~Parallel_Updates() { clear(); }
+
+  template< typename Index, typename Object >
+  void update_elements
+      (const std::map< Index, std::set< Object > >& attic_objects,
+       const std::map< Index, std::set< Object > >& new_objects, const File_Properties& file_properties)
+  {
+    jobs.push_back(new Update_Elements_Job< Index, Object >(
+        &attic_objects, new_objects, transaction->data_index(&file_properties)));
+  }
+
+  template< typename Index, typename Object >
+  void insert_elements
+      (const std::map< Index, std::set< Object > >& new_objects, const File_Properties& file_properties)
+  {
+    jobs.push_back(new Update_Elements_Job< Index, Object >(
+        0, new_objects, transaction->data_index(&file_properties)));
+  }
+
+  template< typename Id_Type >
+  void update_map_positions
+      (const std::vector< std::pair< Id_Type, Uint31_Index > >& new_idx_positions,
+       const File_Properties& file_properties)
+  {
+    jobs.push_back(new Update_Map_Positions_Job< Id_Type >(
+        new_idx_positions, transaction->random_index(&file_properties)));
+  }
+
+  // Returns when all writes have finished. Errors are passed on as by run_parallel_jobs().
+  void run()
+  {
+    run_parallel_jobs(jobs, max_threads);
+    clear();
+  }
+
+private:
+  Transaction* transaction;
+  uint max_threads;
+  std::vector< Parallel_Job* > jobs;
+
+  void clear()
+  {
+    for (std::vector< Parallel_Job* >::const_iterator it = jobs.begin(); it != jobs.end(); ++it)
+      delete *it;
+    jobs.clear();
+  }
+};
+
+
 template< typename Id_Type >
 std::map< Id_Type, std::set< Uint31_Index > > get_existing_idx_lists
     (const std::vector< Id_Type >& ids,
@@ -741,6 +847,37 @@ void add_deleted_skeletons
 }
 
 
+/* Removes the objects that would be deleted and inserted again at the same index. */
+template< typename Index, typename Object >
+void cancel_out_equal_objects
+    (std::map< Index, std::set< Object > >& attic_objects, std::map< Index, std::set< Object > >& new_objects)
+{
+  typename std::map< Index, std::set< Object > >::iterator attic_it = attic_objects.begin();
+  while (attic_it != attic_objects.end())
+  {
+    typename std::map< Index, std::set< Object > >::iterator new_it = new_objects.find(attic_it->first);
+    if (new_it != new_objects.end())
+    {
+      std::vector< Object > common;
+      std::set_intersection(attic_it->second.begin(), attic_it->second.end(),
+          new_it->second.begin(), new_it->second.end(), std::back_inserter(common));
+      for (typename std::vector< Object >::const_iterator it = common.begin(); it != common.end(); ++it)
+      {
+        attic_it->second.erase(*it);
+        new_it->second.erase(*it);
+      }
+      if (new_it->second.empty())
+        new_objects.erase(new_it);
+    }
+
+    if (attic_it->second.empty())
+      attic_objects.erase(attic_it++);
+    else
+      ++attic_it;
+  }
+}
+
+
 template< typename Element_Skeleton >
 std::vector< typename Element_Skeleton::Id_Type > enhance_ids_to_update
     (const std::map< Uint31_Index, std::set< Element_Skeleton > >& implicitly_moved_skeletons,
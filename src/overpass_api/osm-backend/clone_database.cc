@@ -82,6 +82,42 @@ void clone_bin_file(const File_Properties& src_file_prop, const File_Properties&
 }
 
 
+/* Decodes and encodes every object instead of copying the blocks.
+ * This way the clone gets the current on-disk format of the objects. */
+template< class TIndex, class TObject >
+void clone_skeleton_file(const File_Properties& file_prop, Transaction& transaction,
+    std::string dest_db_dir, const Clone_Settings& clone_settings)
+{
+  try
+  {
+    File_Blocks_Index< TIndex > dest_idx(file_prop, true, false, dest_db_dir, "",
+        clone_settings.compression_method);
+    Block_Backend< TIndex, TObject > dest_db(&dest_idx);
+
+    Block_Backend< TIndex, TObject > src_db(transaction.data_index(&file_prop));
+    std::map< TIndex, std::set< TObject > > to_insert;
+    uint32 count = 0;
+    for (typename Block_Backend< TIndex, TObject >::Flat_Iterator it(src_db.flat_begin());
+        !(it == src_db.flat_end()); ++it)
+    {
+      // Write in batches, but never split the objects of an index
+      if (++count >= 1024*1024 && !(to_insert.rbegin()->first == it.index()))
+      {
+        dest_db.update(std::map< TIndex, std::set< TObject > >(), to_insert);
+        to_insert.clear();
+        count = 0;
+      }
+      to_insert[it.index()].insert(it.object());
+    }
+    dest_db.update(std::map< TIndex, std::set< TObject > >(), to_insert);
+  }
+  catch (File_Error e)
+  {
+    std::cout<<e.origin<<' '<<e.error_number<<' '<<strerror(e.error_number)<<' '<<e.filename<<'\n';
+  }
+}
+
+
 template< typename Key, typename TIndex >
 void clone_map_file(const File_Properties& file_prop, Transaction& transaction, std::string dest_db_dir, Clone_Settings clone_settings)
 {
@@ -93,9 +129,9 @@ void clone_map_file(const File_Properties& file_prop, Transaction& transaction,
     Random_File_Index dest_idx(file_prop, true, false, dest_db_dir, "", clone_settings.map_compression_method);
     Random_File< Key, TIndex > dest_file(&dest_idx);
 
-    for (std::vector< uint32 >::size_type i = 0; i < src_idx.get_blocks().size(); ++i)
+    for (uint32 i = 0; i < src_idx.entry_count(); ++i)
     {
-      if (src_idx.get_blocks()[i].pos != src_idx.npos)
+      if (src_idx.entry(i).pos != src_idx.npos)
       {
 	for (uint32 j = 0; j < src_idx.get_block_size()*src_idx.get_compression_factor()/TIndex::max_size_of(); ++j)
 	{
@@ -126,7 +162,7 @@ void clone_database(Transaction& transaction, const std::string& dest_db_dir, co
   clone_bin_file< Uint32_Index >(*osm_base_settings().NODE_KEYS, *osm_base_settings().NODE_KEYS,
 				 transaction, dest_db_dir, clone_settings);
 
-  clone_bin_file< Uint31_Index >(*osm_base_settings().WAYS, *osm_base_settings().WAYS,
+  clone_skeleton_file< Uint31_Index, Way_Skeleton >(*osm_base_settings().WAYS,
 				 transaction, dest_db_dir, clone_settings);
   clone_map_file< Way_Skeleton::Id_Type, Uint31_Index >(*osm_base_settings().WAYS, transaction, dest_db_dir, clone_settings);
   clone_bin_file< Tag_Index_Local >(*osm_base_settings().WAY_TAGS_LOCAL, *osm_base_settings().WAY_TAGS_LOCAL,
@@ -136,7 +172,7 @@ void clone_database(Transaction& transaction, const std::string& dest_db_dir, co
   clone_bin_file< Uint32_Index >(*osm_base_settings().WAY_KEYS, *osm_base_settings().WAY_KEYS,
 				 transaction, dest_db_dir, clone_settings);
 
-  clone_bin_file< Uint31_Index >(*osm_base_settings().RELATIONS, *osm_base_settings().RELATIONS,
+  clone_skeleton_file< Uint31_Index, Relation_Skeleton >(*osm_base_settings().RELATIONS,
 				 transaction, dest_db_dir, clone_settings);
   clone_map_file< Relation_Skeleton::Id_Type, Uint31_Index >(
       *osm_base_settings().RELATIONS, transaction, dest_db_dir, clone_settings);
@@ -151,6 +187,18 @@ void clone_database(Transaction& transaction, const std::string& dest_db_dir, co
   clone_bin_file< Uint32_Index >(*osm_base_settings().RELATION_KEYS, *osm_base_settings().RELATION_KEYS,
 				 transaction, dest_db_dir, clone_settings);
 
+  if (has_parent_index(transaction.get_db_dir()))
+  {
+    clone_bin_file< Node::Id_Type >(*osm_base_settings().NODE_PARENT_WAYS,
+        *osm_base_settings().NODE_PARENT_WAYS, transaction, dest_db_dir, clone_settings);
+    clone_bin_file< Node::Id_Type >(*osm_base_settings().NODE_PARENT_RELATIONS,
+        *osm_base_settings().NODE_PARENT_RELATIONS, transaction, dest_db_dir, clone_settings);
+    clone_bin_file< Way::Id_Type >(*osm_base_settings().WAY_PARENT_RELATIONS,
+        *osm_base_settings().WAY_PARENT_RELATIONS, transaction, dest_db_dir, clone_settings);
+    clone_bin_file< Relation::Id_Type >(*osm_base_settings().RELATION_PARENT_RELATIONS,
+        *osm_base_settings().RELATION_PARENT_RELATIONS, transaction, dest_db_dir, clone_settings);
+  }
+
   clone_bin_file< Uint31_Index >(*meta_settings().NODES_META, *meta_settings().NODES_META,
 				 transaction, dest_db_dir, clone_settings);
   clone_bin_file< Uint31_Index >(*meta_settings().WAYS_META, *meta_settings().WAYS_META,
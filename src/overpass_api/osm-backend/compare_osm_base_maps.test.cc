@@ -22,6 +22,7 @@
 #include <iostream>
 #include <list>
 #include <sstream>
+#include <vector>
 
 #include <stdio.h>
 #include <sys/types.h>
@@ -172,10 +173,43 @@ void dump_relations(std::string db_dir)
   clear_relations_to_map(id_to_idx, transaction);
 }
 
+template< typename TIndex >
+void dump_parent_index(const std::string& db_dir, const File_Properties& file_prop,
+    const std::string& child_type, const std::string& parent_type)
+{
+  Nonsynced_Transaction transaction(false, false, db_dir, "");
+  Block_Backend< TIndex, Uint32_Index > parents_db(transaction.data_index(&file_prop));
+  // The order of the parents of a single child depends on the update history
+  std::vector< std::pair< uint64, uint32 > > pairs;
+  for (typename Block_Backend< TIndex, Uint32_Index >::Flat_Iterator
+      it(parents_db.flat_begin()); !(it == parents_db.flat_end()); ++it)
+    pairs.push_back(std::make_pair(it.index().val(), it.object().val()));
+  std::sort(pairs.begin(), pairs.end());
+
+  for (std::vector< std::pair< uint64, uint32 > >::const_iterator it = pairs.begin(); it != pairs.end(); ++it)
+    std::cout<<child_type<<' '<<it->first<<" in "<<parent_type<<' '<<it->second<<'\n';
+  std::cout<<pairs.size()<<" "<<child_type<<"s in "<<parent_type<<"s.\n";
+}
+
+void dump_parent_indexes(const std::string& db_dir)
+{
+  if (!has_parent_index(db_dir))
+  {
+    std::cout<<"No index from members to their parents.\n";
+    return;
+  }
+  dump_parent_index< Node::Id_Type >(db_dir, *osm_base_settings().NODE_PARENT_WAYS, "Node", "way");
+  dump_parent_index< Node::Id_Type >(db_dir, *osm_base_settings().NODE_PARENT_RELATIONS, "Node", "relation");
+  dump_parent_index< Way::Id_Type >(db_dir, *osm_base_settings().WAY_PARENT_RELATIONS, "Way", "relation");
+  dump_parent_index< Relation::Id_Type >
+      (db_dir, *osm_base_settings().RELATION_PARENT_RELATIONS, "Relation", "relation");
+}
+
 int main(int argc, char* args[])
 {
   // read command line arguments
   std::string db_dir;
+  bool parent_index = false;
 
   int argpos(1);
   while (argpos < argc)
@@ -186,6 +220,8 @@ int main(int argc, char* args[])
       if ((db_dir.size() > 0) && (db_dir[db_dir.size()-1] != '/'))
 	db_dir += '/';
     }
+    else if (!(strcmp(args[argpos], "--parent-index")))
+      parent_index = true;
     ++argpos;
   }
 
@@ -219,5 +255,18 @@ int main(int argc, char* args[])
     <<e.error_number<<' '<<e.filename<<' '<<e.origin<<'\n';
   }
 
+  if (parent_index)
+  {
+    try
+    {
+      dump_parent_indexes(db_dir);
+    }
+    catch (File_Error e)
+    {
+      std::cerr<<"compare_osm_base_maps: File error caught: "
+      <<e.error_number<<' '<<e.filename<<' '<<e.origin<<'\n';
+    }
+  }
+
   return 0;
 }
@@ -241,13 +241,30 @@ Block_Backend_Collection< TIndex, TObject >::~Block_Backend_Collection()
     delete(*it);
 }
 
+template < typename TIndex, typename TObject >
+void flush_merged_items
+    (Transaction& into_transaction, const File_Properties& file_prop,
+     std::map< TIndex, std::set< TObject > >& db_to_insert, uint32& item_count)
+{
+  std::map< TIndex, std::set< TObject > > db_to_delete;
+  Block_Backend< TIndex, TObject > into_db
+      (into_transaction.data_index(&file_prop));
+  into_db.update(db_to_delete, db_to_insert);
+  db_to_insert.clear();
+  item_count = 0;
+}
+
 template < typename TIndex, typename TObject >
 void merge_files
     (Transaction_Collection& from_transaction, Transaction& into_transaction,
      const File_Properties& file_prop)
 {
+  // Flushes between indices let an append into an empty target rewrite at most the last block
+  // of the previous flush. A single dense index may still exceed the soft limit by far,
+  // hence the hard limit bounds the memory also in the middle of an index.
+  static const uint32 SOFT_FLUSH_LIMIT = 3*1024*1024;
+  static const uint32 HARD_FLUSH_LIMIT = 4*1024*1024;
   {
-    std::map< TIndex, std::set< TObject > > db_to_delete;
     std::map< TIndex, std::set< TObject > > db_to_insert;
 
     uint32 item_count = 0;
@@ -274,24 +291,18 @@ void merge_files
 	{
 	  db_to_insert[it->first.index()].insert(it->first.object());
 	  ++(it->first);
-
-	  if (++item_count > 4*1024*1024)
-	  {
-	    Block_Backend< TIndex, TObject > into_db
-	        (into_transaction.data_index(&file_prop));
-	    into_db.update(db_to_delete, db_to_insert);
-	    db_to_insert.clear();
-	    item_count = 0;
-	  }
+	  if (++item_count > HARD_FLUSH_LIMIT)
+	    flush_merged_items(into_transaction, file_prop, db_to_insert, item_count);
 	}
 	if (!(it->first == it->second))
 	  current_idxs.insert(it->first.index());
       }
+
+      if (item_count > SOFT_FLUSH_LIMIT)
+        flush_merged_items(into_transaction, file_prop, db_to_insert, item_count);
     }
 
-    Block_Backend< TIndex, TObject > into_db
-        (into_transaction.data_index(&file_prop));
-    into_db.update(db_to_delete, db_to_insert);
+    flush_merged_items(into_transaction, file_prop, db_to_insert, item_count);
   }
   from_transaction.remove_referred_files(file_prop);
 }
@@ -457,19 +457,22 @@ std::map< Timestamp, std::set< Change_Entry< Node_Skeleton::Id_Type > > > comput
 
 Node_Updater::Node_Updater(Transaction& transaction_, meta_modes meta_)
   : update_counter(0), transaction(&transaction_),
-    external_transaction(true), partial_possible(false), meta(meta_), keys(*osm_base_settings().NODE_KEYS)
+    external_transaction(true), partial_possible(false), bulk_load(false), meta(meta_),
+    keys(*osm_base_settings().NODE_KEYS)
 {}
 
 Node_Updater::Node_Updater(std::string db_dir_, meta_modes meta_)
   : update_counter(0), transaction(0),
     external_transaction(false), partial_possible(meta_ == only_data || meta_ == keep_meta),
-    db_dir(db_dir_), meta(meta_), keys(*osm_base_settings().NODE_KEYS)
+    bulk_load(false), db_dir(db_dir_), meta(meta_), keys(*osm_base_settings().NODE_KEYS)
 {
   partial_possible = !file_exists
       (db_dir +
        osm_base_settings().NODES->get_file_name_trunk() +
        osm_base_settings().NODES->get_data_suffix() +
        osm_base_settings().NODES->get_index_suffix());
+  // With attic data, the same element may appear in several versions across partial updates
+  bulk_load = partial_possible && meta != keep_attic;
 }
 
 
@@ -489,26 +492,30 @@ void Node_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu_sto
     deduplicate_data(new_data);
   std::vector< Node_Skeleton::Id_Type > ids_to_update_ = ids_to_update(new_data);
 
-  // Collect all data of existing id indexes
-  std::vector< std::pair< Node_Skeleton::Id_Type, Uint31_Index > > existing_map_positions
-      = get_existing_map_positions(ids_to_update_, *transaction, *osm_base_settings().NODES);
+  std::vector< std::pair< Node_Skeleton::Id_Type, Uint31_Index > > existing_map_positions;
+  std::map< Uint31_Index, std::set< Node_Skeleton > > existing_skeletons;
+  std::map< Uint31_Index, std::set< OSM_Element_Metadata_Skeleton< Node::Id_Type > > > existing_meta;
+  std::vector< Tag_Entry< Node_Skeleton::Id_Type > > existing_local_tags;
+  if (!bulk_load)
+  {
+    // Collect all data of existing id indexes
+    existing_map_positions
+        = get_existing_map_positions(ids_to_update_, *transaction, *osm_base_settings().NODES);
 
-  // Collect all data of existing skeletons
-  std::map< Uint31_Index, std::set< Node_Skeleton > > existing_skeletons
-      = get_existing_skeletons< Node_Skeleton >
-      (existing_map_positions, *transaction, *osm_base_settings().NODES);
+    // Collect all data of existing skeletons
+    existing_skeletons = get_existing_skeletons< Node_Skeleton >
+        (existing_map_positions, *transaction, *osm_base_settings().NODES);
 
-  // Collect all data of existing meta elements
-  std::map< Uint31_Index, std::set< OSM_Element_Metadata_Skeleton< Node::Id_Type > > > existing_meta
-      = (meta ? get_existing_meta< OSM_Element_Metadata_Skeleton< Node::Id_Type > >
-             (existing_map_positions, *transaction, *meta_settings().NODES_META) :
-         std::map< Uint31_Index, std::set< OSM_Element_Metadata_Skeleton< Node::Id_Type > > >());
+    // Collect all data of existing meta elements
+    if (meta)
+      existing_meta = get_existing_meta< OSM_Element_Metadata_Skeleton< Node::Id_Type > >
+          (existing_map_positions, *transaction, *meta_settings().NODES_META);
 
-  // Collect all data of existing tags
-  std::vector< Tag_Entry< Node_Skeleton::Id_Type > > existing_local_tags;
-  get_existing_tags< Node_Skeleton::Id_Type >
-      (existing_map_positions, *transaction->data_index(osm_base_settings().NODE_TAGS_LOCAL),
-       existing_local_tags);
+    // Collect all data of existing tags
+    get_existing_tags< Node_Skeleton::Id_Type >
+        (existing_map_positions, *transaction->data_index(osm_base_settings().NODE_TAGS_LOCAL),
+         existing_local_tags);
+  }
 
   // Compute which objects really have changed
   attic_skeletons.clear();
@@ -536,31 +543,37 @@ void Node_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu_sto
       = new_idx_positions(new_data);
   // TODO: old code
   std::map< uint32, std::vector< Node::Id_Type > > to_delete;
-  update_node_ids(to_delete, 0, new_map_positions);
+  if (!bulk_load)
+    update_node_ids(to_delete, 0, new_map_positions);
 
   callback->update_started();
   callback->prepare_delete_tags_finished();
 
   store_new_keys(new_data, keys, *transaction);
 
+  // All remaining changes go to distinct files, hence they are written concurrently
+  Parallel_Updates updates(*transaction, basic_settings().max_write_threads);
+
   // Update id indexes
-  update_map_positions(new_map_positions, *transaction, *osm_base_settings().NODES);
-  callback->update_ids_finished();
+  updates.update_map_positions(new_map_positions, *osm_base_settings().NODES);
 
   // Update skeletons
-  update_elements(attic_skeletons, new_skeletons, *transaction, *osm_base_settings().NODES);
-  callback->update_coords_finished();
+  updates.update_elements(attic_skeletons, new_skeletons, *osm_base_settings().NODES);
 
   // Update meta
   if (meta)
-    update_elements(attic_meta, new_meta, *transaction, *meta_settings().NODES_META);
+    updates.update_elements(attic_meta, new_meta, *meta_settings().NODES_META);
 
   // Update local tags
-  update_elements(attic_local_tags, new_local_tags, *transaction, *osm_base_settings().NODE_TAGS_LOCAL);
-  callback->tags_local_finished();
+  updates.update_elements(attic_local_tags, new_local_tags, *osm_base_settings().NODE_TAGS_LOCAL);
 
   // Update global tags
-  update_elements(attic_global_tags, new_global_tags, *transaction, *osm_base_settings().NODE_TAGS_GLOBAL);
+  updates.update_elements(attic_global_tags, new_global_tags, *osm_base_settings().NODE_TAGS_GLOBAL);
+
+  updates.run();
+  callback->update_ids_finished();
+  callback->update_coords_finished();
+  callback->tags_local_finished();
   callback->tags_global_finished();
 
   std::map< uint32, std::vector< uint32 > > idxs_by_id;
@@ -616,35 +629,28 @@ void Node_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu_sto
     copy_idxs_by_id(attic_meta, idxs_by_id);
 
     // Update id indexes
-    update_map_positions(new_attic_map_positions, *transaction, *attic_settings().NODES);
+    updates.update_map_positions(new_attic_map_positions, *attic_settings().NODES);
 
     // Update id index lists
-    update_elements(existing_idx_lists, new_attic_idx_lists,
-                    *transaction, *attic_settings().NODE_IDX_LIST);
+    updates.update_elements(existing_idx_lists, new_attic_idx_lists, *attic_settings().NODE_IDX_LIST);
 
     // Add attic elements
-    update_elements(std::map< Uint31_Index, std::set< Attic< Node_Skeleton > > >(), new_attic_skeletons,
-                    *transaction, *attic_settings().NODES);
+    updates.insert_elements(new_attic_skeletons, *attic_settings().NODES);
 
     // Add attic elements
-    update_elements(std::map< Uint31_Index, std::set< Attic< Node_Skeleton::Id_Type > > >(),
-                    new_undeleted, *transaction, *attic_settings().NODES_UNDELETED);
+    updates.insert_elements(new_undeleted, *attic_settings().NODES_UNDELETED);
 
     // Add attic meta
-    update_elements
-        (std::map< Uint31_Index, std::set< OSM_Element_Metadata_Skeleton< Node_Skeleton::Id_Type > > >(),
-         attic_meta, *transaction, *attic_settings().NODES_META);
+    updates.insert_elements(attic_meta, *attic_settings().NODES_META);
 
     // Update tags
-    update_elements(std::map< Tag_Index_Local, std::set< Attic < Node_Skeleton::Id_Type > > >(),
-                    new_attic_local_tags, *transaction, *attic_settings().NODE_TAGS_LOCAL);
-    update_elements(std::map< Tag_Index_Global,
-                    std::set< Attic < Tag_Object_Global< Node_Skeleton::Id_Type > > > >(),
-                    new_attic_global_tags, *transaction, *attic_settings().NODE_TAGS_GLOBAL);
+    updates.insert_elements(new_attic_local_tags, *attic_settings().NODE_TAGS_LOCAL);
+    updates.insert_elements(new_attic_global_tags, *attic_settings().NODE_TAGS_GLOBAL);
 
     // Write changelog
-    update_elements(std::map< Timestamp, std::set< Change_Entry< Node_Skeleton::Id_Type > > >(), changelog,
-                    *transaction, *attic_settings().NODE_CHANGELOG);
+    updates.insert_elements(changelog, *attic_settings().NODE_CHANGELOG);
+
+    updates.run();
   }
 
   if (meta != only_data)
@@ -674,30 +680,29 @@ void Node_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu_sto
   {
     callback->partial_started();
 
+    // Merge all pending partial files in a single pass. The data of this update is moved
+    // to a partial file as well, such that the final files are written only once.
+    std::string last(".0a");
+    last[2] += update_counter % 16;
+    rename_files(last);
+
     std::vector< std::string > froms;
-    for (uint i = 0; i < update_counter % 16; ++i)
+    for (uint i = 0; i <= update_counter % 16; ++i)
     {
       std::string from(".0a");
       from[2] += i;
       froms.push_back(from);
     }
-    merge_files(froms, "");
-
-    if (update_counter >= 256)
-      merge_files(std::vector< std::string >(1, ".2"), ".1");
-    if (update_counter >= 16)
+    for (uint i = 0; i < update_counter/16 % 16; ++i)
     {
-      std::vector< std::string > froms;
-      for (uint i = 0; i < update_counter/16 % 16; ++i)
-      {
-	std::string from(".1a");
-	from[2] += i;
-	froms.push_back(from);
-      }
-      merge_files(froms, ".1");
-
-      merge_files(std::vector< std::string >(1, ".1"), "");
+      std::string from(".1a");
+      from[2] += i;
+      froms.push_back(from);
     }
+    if (update_counter >= 256)
+      froms.push_back(".2");
+    merge_files(froms, "");
+
     update_counter = 0;
     callback->partial_finished();
   }
@@ -705,11 +710,7 @@ void Node_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu_sto
   {
     std::string to(".0a");
     to[2] += update_counter % 16;
-    rename_referred_file(db_dir, "", to, *osm_base_settings().NODES);
-    rename_referred_file(db_dir, "", to, *osm_base_settings().NODE_TAGS_LOCAL);
-    rename_referred_file(db_dir, "", to, *osm_base_settings().NODE_TAGS_GLOBAL);
-    if (meta)
-      rename_referred_file(db_dir, "", to, *meta_settings().NODES_META);
+    rename_files(to);
 
     ++update_counter;
     if (update_counter % 16 == 0)
@@ -776,6 +777,16 @@ void Node_Updater::update_node_ids
 }
 
 
+void Node_Updater::rename_files(const std::string& to)
+{
+  rename_referred_file(db_dir, "", to, *osm_base_settings().NODES);
+  rename_referred_file(db_dir, "", to, *osm_base_settings().NODE_TAGS_LOCAL);
+  rename_referred_file(db_dir, "", to, *osm_base_settings().NODE_TAGS_GLOBAL);
+  if (meta)
+    rename_referred_file(db_dir, "", to, *meta_settings().NODES_META);
+}
+
+
 void Node_Updater::merge_files(const std::vector< std::string >& froms, std::string into)
 {
   Transaction_Collection from_transactions(false, false, db_dir, froms);
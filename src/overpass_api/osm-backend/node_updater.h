@@ -93,6 +93,8 @@ private:
   Transaction* transaction;
   bool external_transaction;
   bool partial_possible;
+  // The database is built from scratch, hence no element can exist before it is written
+  bool bulk_load;
   static Node_Comparator_By_Id node_comparator_by_id;
   static Node_Equal_Id node_equal_id;
   std::string db_dir;
@@ -115,6 +117,7 @@ private:
   void update_node_ids(std::map< uint32, std::vector< Node::Id_Type > >& to_delete, bool record_minuscule_moves,
       const std::vector< std::pair< Node_Skeleton::Id_Type, Uint31_Index > >& new_idx_positions);
 
+  void rename_files(const std::string& to);
   void merge_files(const std::vector< std::string >& froms, std::string into);
 };
 
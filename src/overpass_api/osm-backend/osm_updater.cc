@@ -18,6 +18,7 @@
 
 #include "node_updater.h"
 #include "osm_updater.h"
+#include "pbf_reader.h"
 #include "relation_updater.h"
 #include "tags_updater.h"
 #include "way_updater.h"
@@ -39,6 +40,7 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <list>
 #include <sstream>
 
@@ -195,7 +197,7 @@ namespace
   }
 
 
-  inline void way_start(const char **attr)
+  inline void begin_ways()
   {
     if (state == IN_NODES)
     {
@@ -208,6 +210,12 @@ namespace
     }
     else if (state == 0)
       state = IN_WAYS;
+  }
+
+
+  inline void way_start(const char **attr)
+  {
+    begin_ways();
     if (meta)
       *meta = OSM_Element_Metadata();
 
@@ -279,7 +287,7 @@ namespace
   }
 
 
-  inline void relation_start(const char **attr)
+  inline void begin_relations()
   {
     if (state == IN_NODES)
     {
@@ -305,6 +313,12 @@ namespace
     }
     else if (state == 0)
       state = IN_RELATIONS;
+  }
+
+
+  inline void relation_start(const char **attr)
+  {
+    begin_relations();
     if (meta)
       *meta = OSM_Element_Metadata();
 
@@ -334,6 +348,64 @@ namespace
     }
     current_relation = Relation(id.val());
   }
+
+
+  // Feeds the elements of a PBF block through the same steps as the elements of an XML file
+  void process_block(const Pbf_Block& block)
+  {
+    for (std::vector< Pbf_Element< Node > >::const_iterator it = block.nodes.begin();
+        it != block.nodes.end(); ++it)
+    {
+      if (state == 0)
+        state = IN_NODES;
+      if (meta)
+        *meta = it->meta;
+      current_node = it->elem;
+      modify_mode = (it->visible ? 0 : DELETE);
+      osm_element_count += it->num_children;
+      node_end();
+      ++osm_element_count;
+    }
+
+    for (std::vector< Pbf_Element< Way > >::const_iterator it = block.ways.begin();
+        it != block.ways.end(); ++it)
+    {
+      begin_ways();
+      if (meta)
+        *meta = it->meta;
+      current_way = it->elem;
+      modify_mode = (it->visible ? 0 : DELETE);
+      osm_element_count += it->num_children;
+      way_end();
+      ++osm_element_count;
+    }
+
+    // The roles are stored as indices into the string table of the block
+    std::vector< uint32 > role_ids;
+    for (std::vector< Pbf_Element< Relation > >::const_iterator it = block.relations.begin();
+        it != block.relations.end(); ++it)
+    {
+      begin_relations();
+      if (meta)
+        *meta = it->meta;
+      current_relation = it->elem;
+      for (std::vector< Relation_Entry >::iterator mit = current_relation.members.begin();
+          mit != current_relation.members.end(); ++mit)
+      {
+        if (role_ids.empty())
+          role_ids.resize(block.strings.size(), std::numeric_limits< uint32 >::max());
+        if (role_ids[mit->role] == std::numeric_limits< uint32 >::max())
+          role_ids[mit->role] = relation_updater->get_role_id(block.strings[mit->role]);
+        mit->role = role_ids[mit->role];
+      }
+      modify_mode = (it->visible ? 0 : DELETE);
+      osm_element_count += it->num_children;
+      relation_end();
+      ++osm_element_count;
+    }
+
+    modify_mode = 0;
+  }
 }
 
 
@@ -483,6 +555,20 @@ void Osm_Updater::parse_file_completely(FILE* in)
   finish_updater();
 }
 
+void Osm_Updater::parse_pbf_completely(FILE* in, uint max_threads)
+{
+  callback->parser_started();
+  Pbf_Reader reader(in, max_threads);
+  std::vector< Pbf_Block > blocks;
+  while (reader.read_blocks(blocks))
+  {
+    for (std::vector< Pbf_Block >::const_iterator it = blocks.begin(); it != blocks.end(); ++it)
+      process_block(*it);
+  }
+
+  finish_updater();
+}
+
 void parse_nodes_only(FILE* in)
 {
   parse(in, node_start, node_end);
@@ -498,11 +584,22 @@ void parse_relations_only(FILE* in)
   parse(in, relation_start, relation_end);
 }
 
+// The index from members to their parents must cover all elements, hence it cannot be added later
+void assure_parent_index_complete(const std::string& db_dir)
+{
+  const File_Properties& ways = *osm_base_settings().WAYS;
+  if (basic_settings().build_parent_index && !has_parent_index(db_dir)
+      && file_exists(db_dir + ways.get_file_name_trunk() + ways.get_data_suffix() + ways.get_index_suffix()))
+    throw Context_Error("The index from members to their parents can only be built "
+        "together with the database in " + db_dir + ".");
+}
+
 Osm_Updater::Osm_Updater(Osm_Backend_Callback* callback_, const std::string& data_version_,
 			 meta_modes meta_, unsigned int flush_limit_)
   : dispatcher_client(0), meta(meta_)
 {
   dispatcher_client = new Dispatcher_Client(osm_base_settings().shared_name);
+  assure_parent_index_complete(dispatcher_client->get_db_dir());
   Logger logger(dispatcher_client->get_db_dir());
   logger.annotated_log("write_start() start version='" + data_version_ + '\'');
   dispatcher_client->write_start();
@@ -542,6 +639,7 @@ Osm_Updater::Osm_Updater
   if (file_present(db_dir + osm_base_settings().shared_name))
     throw Context_Error("File " + db_dir + osm_base_settings().shared_name + " present, "
         "which indicates a running dispatcher. Delete file if no dispatcher is running.");
+  assure_parent_index_complete(db_dir);
 
   {
     std::ofstream version((db_dir + "osm_base_version").c_str());
@@ -589,9 +687,8 @@ void Osm_Updater::flush()
       out<<' '<<*it;
     logger.annotated_log(out.str());
 
+    // The dispatcher publishes osm_base_version.shadow together with the index files
     dispatcher_client->write_commit();
-    rename((dispatcher_client->get_db_dir() + "osm_base_version.shadow").c_str(),
-	   (dispatcher_client->get_db_dir() + "osm_base_version").c_str());
 
     logger.annotated_log("write_commit() end");
     delete dispatcher_client;
@@ -41,6 +41,8 @@ class Osm_Updater
 
     void finish_updater();
     void parse_file_completely(FILE* in);
+    // Reads an OSM PBF file, decoding its blocks on up to max_threads threads
+    void parse_pbf_completely(FILE* in, uint max_threads);
 
   private:
     Nonsynced_Transaction* transaction;
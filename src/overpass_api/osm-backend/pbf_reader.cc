@@ -0,0 +1,688 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pbf_reader.h"
+#include "../../template_db/parallel_jobs.h"
+#include "../../template_db/types.h"
+#include "../../template_db/zlib_wrapper.h"
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+  const std::string PBF_INPUT = "PBF input";
+
+  const uint32 MAX_BLOB_HEADER_SIZE = 64*1024;
+  const uint32 MAX_BLOB_SIZE = 32*1024*1024;
+
+
+  /* A cursor over a protobuf message. next() reads the key of the next field,
+   * then exactly one of the reading methods or skip() must consume its value. */
+  struct Pbf_Message
+  {
+    Pbf_Message(const uint8* pos_, const uint8* end_) : pos(pos_), end(end_), key(0) {}
+
+    bool next()
+    {
+      if (pos >= end)
+        return false;
+      key = varint();
+      return true;
+    }
+
+    uint32 field() const { return key>>3; }
+    uint32 wire_type() const { return key & 0x7; }
+    bool at_end() const { return pos >= end; }
+
+    uint64 varint()
+    {
+      uint64 result = 0;
+      for (int shift = 0; shift < 64 && pos < end; shift += 7)
+      {
+        uint8 byte = *pos++;
+        result |= (uint64(byte & 0x7f)<<shift);
+        if (!(byte & 0x80))
+          return result;
+      }
+      throw File_Error(0, PBF_INPUT, "Pbf_Reader: truncated varint");
+    }
+
+    int64 svarint()
+    {
+      uint64 value = varint();
+      return (int64)(value>>1) ^ -(int64)(value & 1);
+    }
+
+    Pbf_Message bytes()
+    {
+      uint64 size = varint();
+      if (size > uint64(end - pos))
+        throw File_Error(0, PBF_INPUT, "Pbf_Reader: truncated field");
+      Pbf_Message result(pos, pos + size);
+      pos += size;
+      return result;
+    }
+
+    std::string string()
+    {
+      Pbf_Message value = bytes();
+      return std::string((const char*)value.pos, value.end - value.pos);
+    }
+
+    void skip()
+    {
+      uint32 size = 0;
+      if (wire_type() == 0)
+        varint();
+      else if (wire_type() == 2)
+        bytes();
+      else if (wire_type() == 1)
+        size = 8;
+      else if (wire_type() == 5)
+        size = 4;
+      else
+        throw File_Error(0, PBF_INPUT, "Pbf_Reader: unknown wire type");
+      if (size > uint64(end - pos))
+        throw File_Error(0, PBF_INPUT, "Pbf_Reader: truncated field");
+      pos += size;
+    }
+
+    const uint8* pos;
+    const uint8* end;
+    uint64 key;
+  };
+
+
+  // Packed repeated fields may also be sent unpacked, one value per field.
+  void read_varints(Pbf_Message& msg, std::vector< uint64 >& result)
+  {
+    if (msg.wire_type() == 2)
+    {
+      Pbf_Message values = msg.bytes();
+      while (!values.at_end())
+        result.push_back(values.varint());
+    }
+    else
+      result.push_back(msg.varint());
+  }
+
+
+  void read_svarints(Pbf_Message& msg, std::vector< int64 >& result)
+  {
+    if (msg.wire_type() == 2)
+    {
+      Pbf_Message values = msg.bytes();
+      while (!values.at_end())
+        result.push_back(values.svarint());
+    }
+    else
+      result.push_back(msg.svarint());
+  }
+
+
+  void unpack_blob(const std::string& blob, std::string& data)
+  {
+    Pbf_Message msg((const uint8*)blob.data(), (const uint8*)blob.data() + blob.size());
+    Pbf_Message zlib_data(0, 0);
+    bool is_zlib = false;
+    uint64 raw_size = 0;
+    while (msg.next())
+    {
+      if (msg.field() == 1)
+      {
+        data = msg.string();
+        return;
+      }
+      else if (msg.field() == 2)
+        raw_size = msg.varint();
+      else if (msg.field() == 3)
+      {
+        zlib_data = msg.bytes();
+        is_zlib = true;
+      }
+      else if (msg.field() >= 4 && msg.field() <= 7)
+        throw File_Error(0, PBF_INPUT, "Pbf_Reader: unsupported blob compression");
+      else
+        msg.skip();
+    }
+
+    if (!is_zlib || raw_size == 0 || raw_size > MAX_BLOB_SIZE)
+      throw File_Error(0, PBF_INPUT, "Pbf_Reader: invalid blob");
+    data.resize(raw_size);
+    try
+    {
+      Zlib_Inflate inflate;
+      if (inflate.decompress(zlib_data.pos, zlib_data.end - zlib_data.pos, &data[0], raw_size)
+          != (int)raw_size)
+        throw File_Error(0, PBF_INPUT, "Pbf_Reader: blob size mismatch");
+    }
+    catch (const Zlib_Inflate::Error& e)
+    {
+      throw File_Error(e.error_code, PBF_INPUT, "Pbf_Reader: zlib error");
+    }
+  }
+
+
+  void check_header_block(const std::string& data)
+  {
+    Pbf_Message msg((const uint8*)data.data(), (const uint8*)data.data() + data.size());
+    while (msg.next())
+    {
+      if (msg.field() == 4)
+      {
+        std::string feature = msg.string();
+        if (feature != "OsmSchema-V0.6" && feature != "DenseNodes" && feature != "HistoricalInformation")
+          throw File_Error(0, PBF_INPUT, "Pbf_Reader: unsupported required feature " + feature);
+      }
+      else
+        msg.skip();
+    }
+  }
+
+
+  class Primitive_Block_Decoder
+  {
+  public:
+    Primitive_Block_Decoder(Pbf_Block& block_)
+        : block(block_), granularity(100), lat_offset(0), lon_offset(0), date_granularity(1000) {}
+
+    void decode(const std::string& data);
+
+  private:
+    Pbf_Block& block;
+    int64 granularity;
+    int64 lat_offset;
+    int64 lon_offset;
+    int64 date_granularity;
+
+    void decode_group(Pbf_Message msg);
+    void decode_node(Pbf_Message msg);
+    void decode_dense_nodes(Pbf_Message msg);
+    void decode_way(Pbf_Message msg);
+    void decode_relation(Pbf_Message msg);
+    void decode_info(Pbf_Message msg, OSM_Element_Metadata& meta, bool& visible) const;
+
+    const std::string& string_at(uint64 idx) const
+    {
+      if (idx >= block.strings.size())
+        throw File_Error(0, PBF_INPUT, "Pbf_Reader: string index out of range");
+      return block.strings[idx];
+    }
+
+    void add_tags(const std::vector< uint64 >& keys, const std::vector< uint64 >& vals,
+        std::vector< std::pair< std::string, std::string > >& tags) const
+    {
+      if (keys.size() != vals.size())
+        throw File_Error(0, PBF_INPUT, "Pbf_Reader: keys and values differ in number");
+      for (std::vector< uint64 >::size_type i = 0; i < keys.size(); ++i)
+        tags.push_back(std::make_pair(string_at(keys[i]), string_at(vals[i])));
+    }
+
+    // Same range check as for the XML input
+    Node make_node(int64 id, int64 lat, int64 lon) const
+    {
+      double lat_ = (double)(lat_offset + granularity * lat) / 1e9;
+      double lon_ = (double)(lon_offset + granularity * lon) / 1e9;
+      if (lat_ >= -90. && lat_ <= 90. && lon_ >= -180. && lon_ <= 180.)
+        return Node(id, lat_, lon_);
+      return Node(id, 100., 200.);
+    }
+
+    uint64 timestamp(int64 value) const
+    {
+      time_t seconds = value * date_granularity / 1000;
+      struct tm utc;
+      if (!gmtime_r(&seconds, &utc))
+        return 0;
+      return Timestamp(utc.tm_year + 1900, utc.tm_mon + 1, utc.tm_mday,
+          utc.tm_hour, utc.tm_min, utc.tm_sec).timestamp;
+    }
+
+    static void clear_meta(OSM_Element_Metadata& meta)
+    {
+      meta.version = 0;
+      meta.timestamp = 0;
+      meta.changeset = 0;
+      meta.user_id = 0;
+      meta.user_name.clear();
+    }
+  };
+
+
+  void Primitive_Block_Decoder::decode(const std::string& data)
+  {
+    // The groups depend on the granularities which may follow them
+    std::vector< Pbf_Message > groups;
+    Pbf_Message msg((const uint8*)data.data(), (const uint8*)data.data() + data.size());
+    while (msg.next())
+    {
+      if (msg.field() == 1)
+      {
+        Pbf_Message string_table = msg.bytes();
+        while (string_table.next())
+        {
+          if (string_table.field() == 1)
+            block.strings.push_back(string_table.string());
+          else
+            string_table.skip();
+        }
+      }
+      else if (msg.field() == 2)
+        groups.push_back(msg.bytes());
+      else if (msg.field() == 17)
+        granularity = (int32)msg.varint();
+      else if (msg.field() == 18)
+        date_granularity = (int32)msg.varint();
+      else if (msg.field() == 19)
+        lat_offset = (int64)msg.varint();
+      else if (msg.field() == 20)
+        lon_offset = (int64)msg.varint();
+      else
+        msg.skip();
+    }
+
+    for (std::vector< Pbf_Message >::const_iterator it = groups.begin(); it != groups.end(); ++it)
+      decode_group(*it);
+  }
+
+
+  void Primitive_Block_Decoder::decode_group(Pbf_Message msg)
+  {
+    while (msg.next())
+    {
+      if (msg.field() == 1)
+        decode_node(msg.bytes());
+      else if (msg.field() == 2)
+        decode_dense_nodes(msg.bytes());
+      else if (msg.field() == 3)
+        decode_way(msg.bytes());
+      else if (msg.field() == 4)
+        decode_relation(msg.bytes());
+      else
+        msg.skip();
+    }
+  }
+
+
+  void Primitive_Block_Decoder::decode_info
+      (Pbf_Message msg, OSM_Element_Metadata& meta, bool& visible) const
+  {
+    while (msg.next())
+    {
+      if (msg.field() == 1)
+        meta.version = (int32)msg.varint();
+      else if (msg.field() == 2)
+        meta.timestamp = timestamp((int64)msg.varint());
+      else if (msg.field() == 3)
+        meta.changeset = (int64)msg.varint();
+      else if (msg.field() == 4)
+        meta.user_id = (int32)msg.varint();
+      else if (msg.field() == 5)
+        meta.user_name = string_at(msg.varint());
+      else if (msg.field() == 6)
+        visible = msg.varint();
+      else
+        msg.skip();
+    }
+  }
+
+
+  void Primitive_Block_Decoder::decode_node(Pbf_Message msg)
+  {
+    block.nodes.push_back(Pbf_Element< Node >());
+    Pbf_Element< Node >& node = block.nodes.back();
+    clear_meta(node.meta);
+
+    int64 id = 0;
+    int64 lat = 0;
+    int64 lon = 0;
+    std::vector< uint64 > keys;
+    std::vector< uint64 > vals;
+    while (msg.next())
+    {
+      if (msg.field() == 1)
+        id = msg.svarint();
+      else if (msg.field() == 2)
+        read_varints(msg, keys);
+      else if (msg.field() == 3)
+        read_varints(msg, vals);
+      else if (msg.field() == 4)
+        decode_info(msg.bytes(), node.meta, node.visible);
+      else if (msg.field() == 8)
+        lat = msg.svarint();
+      else if (msg.field() == 9)
+        lon = msg.svarint();
+      else
+        msg.skip();
+    }
+
+    node.elem = make_node(id, lat, lon);
+    add_tags(keys, vals, node.elem.tags);
+    node.num_children = node.elem.tags.size();
+  }
+
+
+  void Primitive_Block_Decoder::decode_dense_nodes(Pbf_Message msg)
+  {
+    std::vector< int64 > ids;
+    std::vector< int64 > lats;
+    std::vector< int64 > lons;
+    std::vector< uint64 > keys_vals;
+    std::vector< uint64 > versions;
+    std::vector< int64 > timestamps;
+    std::vector< int64 > changesets;
+    std::vector< int64 > uids;
+    std::vector< int64 > user_sids;
+    std::vector< uint64 > visibles;
+    while (msg.next())
+    {
+      if (msg.field() == 1)
+        read_svarints(msg, ids);
+      else if (msg.field() == 5)
+      {
+        Pbf_Message info = msg.bytes();
+        while (info.next())
+        {
+          if (info.field() == 1)
+            read_varints(info, versions);
+          else if (info.field() == 2)
+            read_svarints(info, timestamps);
+          else if (info.field() == 3)
+            read_svarints(info, changesets);
+          else if (info.field() == 4)
+            read_svarints(info, uids);
+          else if (info.field() == 5)
+            read_svarints(info, user_sids);
+          else if (info.field() == 6)
+            read_varints(info, visibles);
+          else
+            info.skip();
+        }
+      }
+      else if (msg.field() == 8)
+        read_svarints(msg, lats);
+      else if (msg.field() == 9)
+        read_svarints(msg, lons);
+      else if (msg.field() == 10)
+        read_varints(msg, keys_vals);
+      else
+        msg.skip();
+    }
+
+    if (lats.size() != ids.size() || lons.size() != ids.size()
+        || (!versions.empty() && versions.size() != ids.size())
+        || (!timestamps.empty() && timestamps.size() != ids.size())
+        || (!changesets.empty() && changesets.size() != ids.size())
+        || (!uids.empty() && uids.size() != ids.size())
+        || (!user_sids.empty() && user_sids.size() != ids.size())
+        || (!visibles.empty() && visibles.size() != ids.size()))
+      throw File_Error(0, PBF_INPUT, "Pbf_Reader: inconsistent dense nodes");
+
+    int64 id = 0;
+    int64 lat = 0;
+    int64 lon = 0;
+    int64 timestamp_ = 0;
+    int64 changeset = 0;
+    int64 uid = 0;
+    int64 user_sid = 0;
+    std::vector< uint64 >::size_type kv_pos = 0;
+    block.nodes.reserve(block.nodes.size() + ids.size());
+    for (std::vector< int64 >::size_type i = 0; i < ids.size(); ++i)
+    {
+      id += ids[i];
+      lat += lats[i];
+      lon += lons[i];
+
+      block.nodes.push_back(Pbf_Element< Node >());
+      Pbf_Element< Node >& node = block.nodes.back();
+      node.elem = make_node(id, lat, lon);
+
+      // The tags of all nodes are concatenated, each list terminated by a zero
+      while (kv_pos < keys_vals.size() && keys_vals[kv_pos] != 0)
+      {
+        if (kv_pos + 1 >= keys_vals.size())
+          throw File_Error(0, PBF_INPUT, "Pbf_Reader: inconsistent dense node tags");
+        node.elem.tags.push_back(std::make_pair(string_at(keys_vals[kv_pos]), string_at(keys_vals[kv_pos + 1])));
+        kv_pos += 2;
+      }
+      ++kv_pos;
+      node.num_children = node.elem.tags.size();
+
+      clear_meta(node.meta);
+      if (!versions.empty())
+        node.meta.version = (int32)versions[i];
+      if (!timestamps.empty())
+      {
+        timestamp_ += timestamps[i];
+        node.meta.timestamp = timestamp(timestamp_);
+      }
+      if (!changesets.empty())
+      {
+        changeset += changesets[i];
+        node.meta.changeset = changeset;
+      }
+      if (!uids.empty())
+      {
+        uid += uids[i];
+        node.meta.user_id = uid;
+      }
+      if (!user_sids.empty())
+      {
+        user_sid += user_sids[i];
+        node.meta.user_name = string_at(user_sid);
+      }
+      if (!visibles.empty())
+        node.visible = visibles[i];
+    }
+  }
+
+
+  void Primitive_Block_Decoder::decode_way(Pbf_Message msg)
+  {
+    block.ways.push_back(Pbf_Element< Way >());
+    Pbf_Element< Way >& way = block.ways.back();
+    clear_meta(way.meta);
+
+    std::vector< uint64 > keys;
+    std::vector< uint64 > vals;
+    std::vector< int64 > refs;
+    while (msg.next())
+    {
+      if (msg.field() == 1)
+        way.elem.id = (uint32)msg.varint();
+      else if (msg.field() == 2)
+        read_varints(msg, keys);
+      else if (msg.field() == 3)
+        read_varints(msg, vals);
+      else if (msg.field() == 4)
+        decode_info(msg.bytes(), way.meta, way.visible);
+      else if (msg.field() == 8)
+        read_svarints(msg, refs);
+      else
+        msg.skip();
+    }
+
+    add_tags(keys, vals, way.elem.tags);
+    way.elem.nds.reserve(refs.size());
+    int64 ref = 0;
+    for (std::vector< int64 >::const_iterator it = refs.begin(); it != refs.end(); ++it)
+    {
+      ref += *it;
+      way.elem.nds.push_back(Node::Id_Type(ref));
+    }
+    way.num_children = way.elem.tags.size() + way.elem.nds.size();
+  }
+
+
+  void Primitive_Block_Decoder::decode_relation(Pbf_Message msg)
+  {
+    block.relations.push_back(Pbf_Element< Relation >());
+    Pbf_Element< Relation >& relation = block.relations.back();
+    clear_meta(relation.meta);
+
+    std::vector< uint64 > keys;
+    std::vector< uint64 > vals;
+    std::vector< uint64 > roles;
+    std::vector< int64 > memids;
+    std::vector< uint64 > types;
+    while (msg.next())
+    {
+      if (msg.field() == 1)
+        relation.elem.id = (uint32)msg.varint();
+      else if (msg.field() == 2)
+        read_varints(msg, keys);
+      else if (msg.field() == 3)
+        read_varints(msg, vals);
+      else if (msg.field() == 4)
+        decode_info(msg.bytes(), relation.meta, relation.visible);
+      else if (msg.field() == 8)
+        read_varints(msg, roles);
+      else if (msg.field() == 9)
+        read_svarints(msg, memids);
+      else if (msg.field() == 10)
+        read_varints(msg, types);
+      else
+        msg.skip();
+    }
+
+    if (roles.size() != memids.size() || types.size() != memids.size())
+      throw File_Error(0, PBF_INPUT, "Pbf_Reader: inconsistent relation members");
+
+    add_tags(keys, vals, relation.elem.tags);
+    relation.elem.members.reserve(memids.size());
+    int64 ref = 0;
+    for (std::vector< int64 >::size_type i = 0; i < memids.size(); ++i)
+    {
+      ref += memids[i];
+      Relation_Entry entry;
+      entry.ref = ref;
+      if (types[i] > 2)
+        throw File_Error(0, PBF_INPUT, "Pbf_Reader: unknown member type");
+      entry.type = types[i] + 1;
+      if (roles[i] >= block.strings.size())
+        throw File_Error(0, PBF_INPUT, "Pbf_Reader: string index out of range");
+      entry.role = roles[i];
+      relation.elem.members.push_back(entry);
+    }
+    relation.num_children = relation.elem.tags.size() + relation.elem.members.size();
+  }
+
+
+  struct Pbf_Decode_Job : public Parallel_Job
+  {
+    Pbf_Decode_Job(const std::string& blob_, Pbf_Block& block_) : blob(&blob_), block(&block_) {}
+
+    virtual void run()
+    {
+      std::string data;
+      unpack_blob(*blob, data);
+      Primitive_Block_Decoder(*block).decode(data);
+    }
+
+    const std::string* blob;
+    Pbf_Block* block;
+  };
+}
+
+
+Pbf_Reader::Pbf_Reader(FILE* in_, uint max_threads_)
+    : in(in_), max_threads(max_threads_ > 0 ? max_threads_ : 1), header_seen(false) {}
+
+
+bool Pbf_Reader::read_blob(std::string& type, std::string& blob)
+{
+  uint8 size_buf[4];
+  size_t read_size = fread(size_buf, 1, 4, in);
+  if (read_size == 0 && feof(in))
+    return false;
+  if (read_size != 4)
+    throw File_Error(ferror(in) ? errno : 0, PBF_INPUT, "Pbf_Reader::read_blob::1");
+
+  uint32 header_size = (uint32(size_buf[0])<<24) | (uint32(size_buf[1])<<16)
+      | (uint32(size_buf[2])<<8) | uint32(size_buf[3]);
+  if (header_size == 0 || header_size > MAX_BLOB_HEADER_SIZE)
+    throw File_Error(0, PBF_INPUT, "Pbf_Reader::read_blob::2");
+  std::string header(header_size, 0);
+  if (fread(&header[0], 1, header_size, in) != header_size)
+    throw File_Error(ferror(in) ? errno : 0, PBF_INPUT, "Pbf_Reader::read_blob::3");
+
+  type.clear();
+  uint64 data_size = 0;
+  Pbf_Message msg((const uint8*)header.data(), (const uint8*)header.data() + header.size());
+  while (msg.next())
+  {
+    if (msg.field() == 1)
+      type = msg.string();
+    else if (msg.field() == 3)
+      data_size = msg.varint();
+    else
+      msg.skip();
+  }
+
+  if (data_size > MAX_BLOB_SIZE)
+    throw File_Error(0, PBF_INPUT, "Pbf_Reader::read_blob::4");
+  blob.resize(data_size);
+  if (data_size > 0 && fread(&blob[0], 1, data_size, in) != data_size)
+    throw File_Error(ferror(in) ? errno : 0, PBF_INPUT, "Pbf_Reader::read_blob::5");
+  return true;
+}
+
+
+bool Pbf_Reader::read_blocks(std::vector< Pbf_Block >& blocks)
+{
+  blocks.clear();
+
+  // Enough blobs to keep all threads busy, but not the whole file in memory
+  std::vector< std::string > blobs;
+  std::string type;
+  std::string blob;
+  while (blobs.size() < 2*max_threads && read_blob(type, blob))
+  {
+    if (type == "OSMHeader")
+    {
+      std::string data;
+      unpack_blob(blob, data);
+      check_header_block(data);
+      header_seen = true;
+    }
+    else if (type == "OSMData")
+    {
+      if (!header_seen)
+        throw File_Error(0, PBF_INPUT, "Pbf_Reader: data before header");
+      blobs.push_back(std::string());
+      blobs.back().swap(blob);
+    }
+    // Blobs of other types are skipped, as the file format demands
+  }
+
+  blocks.resize(blobs.size());
+  std::vector< Pbf_Decode_Job > decode_jobs;
+  decode_jobs.reserve(blobs.size());
+  std::vector< Parallel_Job* > jobs;
+  for (std::vector< std::string >::size_type i = 0; i < blobs.size(); ++i)
+  {
+    decode_jobs.push_back(Pbf_Decode_Job(blobs[i], blocks[i]));
+    jobs.push_back(&decode_jobs.back());
+  }
+  run_parallel_jobs(jobs, max_threads);
+
+  return !blocks.empty();
+}
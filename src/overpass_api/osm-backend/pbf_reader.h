@@ -0,0 +1,73 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DE__OSM3S___OVERPASS_API__OSM_BACKEND__PBF_READER_H
+#define DE__OSM3S___OVERPASS_API__OSM_BACKEND__PBF_READER_H
+
+#include "../core/datatypes.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+template< typename Object >
+struct Pbf_Element
+{
+  Pbf_Element() : visible(true), num_children(0) {}
+
+  Object elem;
+  OSM_Element_Metadata meta;
+  bool visible;
+  // The number of tags, node references, or members, to account for them in the flush limit
+  uint32 num_children;
+};
+
+
+/* The decoded content of one OSMData blob. The role of each relation member
+ * is the index of the role string in strings, to be mapped by the caller. */
+struct Pbf_Block
+{
+  std::vector< std::string > strings;
+  std::vector< Pbf_Element< Node > > nodes;
+  std::vector< Pbf_Element< Way > > ways;
+  std::vector< Pbf_Element< Relation > > relations;
+};
+
+
+/* Reads an OSM PBF file. The blobs are read sequentially and decoded
+ * on up to max_threads threads. Blobs may be raw or zlib compressed.
+ * Errors in the file are reported as File_Error with filename "PBF input". */
+class Pbf_Reader
+{
+public:
+  Pbf_Reader(FILE* in, uint max_threads);
+
+  // Fills blocks with the next batch of blocks in file order. Returns false at the end of the file.
+  bool read_blocks(std::vector< Pbf_Block >& blocks);
+
+private:
+  FILE* in;
+  uint max_threads;
+  bool header_seen;
+
+  bool read_blob(std::string& type, std::string& blob);
+};
+
+
+#endif
@@ -33,15 +33,16 @@
 
 Relation_Updater::Relation_Updater(Transaction& transaction_, meta_modes meta_)
   : update_counter(0), transaction(&transaction_),
-    external_transaction(true),
-    max_role_id(0), max_written_role_id(0), meta(meta_), keys(*osm_base_settings().RELATION_KEYS)
+    external_transaction(true), max_role_id(0), max_written_role_id(0),
+    parent_index(basic_settings().build_parent_index || has_parent_index(transaction_.get_db_dir())),
+    meta(meta_), keys(*osm_base_settings().RELATION_KEYS)
 {}
 
 Relation_Updater::Relation_Updater(std::string db_dir_, meta_modes meta_)
   : update_counter(0), transaction(0),
-    external_transaction(false),
-    max_role_id(0), max_written_role_id(0), db_dir(db_dir_), meta(meta_),
-    keys(*osm_base_settings().RELATION_KEYS)
+    external_transaction(false), max_role_id(0), max_written_role_id(0),
+    parent_index(basic_settings().build_parent_index || has_parent_index(db_dir_)),
+    db_dir(db_dir_), meta(meta_), keys(*osm_base_settings().RELATION_KEYS)
 {}
 
 
@@ -774,6 +775,28 @@ void add_intermediate_changelog_entries
 }
 
 
+template< typename Id_Type >
+std::map< Id_Type, std::set< Relation::Id_Type > > parent_relations_by_member
+    (const std::map< Uint31_Index, std::set< Relation_Skeleton > >& relations, uint32 member_type)
+{
+  std::map< Id_Type, std::set< Relation::Id_Type > > result;
+  for (std::map< Uint31_Index, std::set< Relation_Skeleton > >::const_iterator it = relations.begin();
+       it != relations.end(); ++it)
+  {
+    for (std::set< Relation_Skeleton >::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+    {
+      for (std::vector< Relation_Entry >::const_iterator it3 = it2->members.begin();
+           it3 != it2->members.end(); ++it3)
+      {
+        if (it3->type == member_type)
+          result[Id_Type(it3->ref.val())].insert(it2->id);
+      }
+    }
+  }
+  return result;
+}
+
+
 bool geometrically_equal(const Relation_Skeleton& a, const Relation_Skeleton& b)
 {
   return (a.members == b.members);
@@ -1176,24 +1199,59 @@ void Relation_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu
 
   store_new_keys(new_data, keys, *transaction);
 
+  // All remaining changes go to distinct files, hence they are written concurrently
+  Parallel_Updates updates(*transaction, basic_settings().max_write_threads);
+
   // Update id indexes
-  update_map_positions(new_positions, *transaction, *osm_base_settings().RELATIONS);
-  callback->update_ids_finished();
+  updates.update_map_positions(new_positions, *osm_base_settings().RELATIONS);
 
   // Update skeletons
-  update_elements(attic_skeletons, new_skeletons, *transaction, *osm_base_settings().RELATIONS);
-  callback->update_coords_finished();
+  updates.update_elements(attic_skeletons, new_skeletons, *osm_base_settings().RELATIONS);
 
   // Update meta
   if (meta)
-    update_elements(attic_meta, new_meta, *transaction, *meta_settings().RELATIONS_META);
+    updates.update_elements(attic_meta, new_meta, *meta_settings().RELATIONS_META);
 
   // Update local tags
-  update_elements(attic_local_tags, new_local_tags, *transaction, *osm_base_settings().RELATION_TAGS_LOCAL);
-  callback->tags_local_finished();
+  updates.update_elements(attic_local_tags, new_local_tags, *osm_base_settings().RELATION_TAGS_LOCAL);
 
   // Update global tags
-  update_elements(attic_global_tags, new_global_tags, *transaction, *osm_base_settings().RELATION_TAGS_GLOBAL);
+  updates.update_elements(attic_global_tags, new_global_tags, *osm_base_settings().RELATION_TAGS_GLOBAL);
+
+  // Update the parent relations of members. Moved relations keep their entries.
+  std::map< Node::Id_Type, std::set< Relation::Id_Type > > attic_node_parents;
+  std::map< Node::Id_Type, std::set< Relation::Id_Type > > new_node_parents;
+  std::map< Way::Id_Type, std::set< Relation::Id_Type > > attic_way_parents;
+  std::map< Way::Id_Type, std::set< Relation::Id_Type > > new_way_parents;
+  std::map< Relation::Id_Type, std::set< Relation::Id_Type > > attic_relation_parents;
+  std::map< Relation::Id_Type, std::set< Relation::Id_Type > > new_relation_parents;
+  if (parent_index)
+  {
+    attic_node_parents = parent_relations_by_member< Node::Id_Type >(attic_skeletons, Relation_Entry::NODE);
+    new_node_parents = parent_relations_by_member< Node::Id_Type >(new_skeletons, Relation_Entry::NODE);
+    cancel_out_equal_objects(attic_node_parents, new_node_parents);
+    updates.update_elements(attic_node_parents, new_node_parents,
+        *osm_base_settings().NODE_PARENT_RELATIONS);
+
+    attic_way_parents = parent_relations_by_member< Way::Id_Type >(attic_skeletons, Relation_Entry::WAY);
+    new_way_parents = parent_relations_by_member< Way::Id_Type >(new_skeletons, Relation_Entry::WAY);
+    cancel_out_equal_objects(attic_way_parents, new_way_parents);
+    updates.update_elements(attic_way_parents, new_way_parents,
+        *osm_base_settings().WAY_PARENT_RELATIONS);
+
+    attic_relation_parents = parent_relations_by_member< Relation::Id_Type >
+        (attic_skeletons, Relation_Entry::RELATION);
+    new_relation_parents = parent_relations_by_member< Relation::Id_Type >
+        (new_skeletons, Relation_Entry::RELATION);
+    cancel_out_equal_objects(attic_relation_parents, new_relation_parents);
+    updates.update_elements(attic_relation_parents, new_relation_parents,
+        *osm_base_settings().RELATION_PARENT_RELATIONS);
+  }
+
+  updates.run();
+  callback->update_ids_finished();
+  callback->update_coords_finished();
+  callback->tags_local_finished();
   callback->tags_global_finished();
 
   flush_roles();
@@ -1267,35 +1325,28 @@ void Relation_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu
     copy_idxs_by_id(new_attic_meta, idxs_by_id);
 
     // Update id indexes
-    update_map_positions(new_attic_map_positions, *transaction, *attic_settings().RELATIONS);
+    updates.update_map_positions(new_attic_map_positions, *attic_settings().RELATIONS);
 
     // Update id index lists
-    update_elements(existing_idx_lists, new_attic_idx_lists,
-                    *transaction, *attic_settings().RELATION_IDX_LIST);
+    updates.update_elements(existing_idx_lists, new_attic_idx_lists, *attic_settings().RELATION_IDX_LIST);
 
     // Add attic elements
-    update_elements(attic_skeletons_to_delete, new_attic_skeletons,
-                    *transaction, *attic_settings().RELATIONS);
+    updates.update_elements(attic_skeletons_to_delete, new_attic_skeletons, *attic_settings().RELATIONS);
 
     // Add attic elements
-    update_elements(std::map< Uint31_Index, std::set< Attic< Relation_Skeleton::Id_Type > > >(),
-                    new_undeleted, *transaction, *attic_settings().RELATIONS_UNDELETED);
+    updates.insert_elements(new_undeleted, *attic_settings().RELATIONS_UNDELETED);
 
     // Add attic meta
-    update_elements
-        (std::map< Uint31_Index, std::set< OSM_Element_Metadata_Skeleton< Relation_Skeleton::Id_Type > > >(),
-         new_attic_meta, *transaction, *attic_settings().RELATIONS_META);
+    updates.insert_elements(new_attic_meta, *attic_settings().RELATIONS_META);
 
     // Update tags
-    update_elements(std::map< Tag_Index_Local, std::set< Attic < Relation_Skeleton::Id_Type > > >(),
-                    new_attic_local_tags, *transaction, *attic_settings().RELATION_TAGS_LOCAL);
-    update_elements(std::map< Tag_Index_Global,
-                        std::set< Attic < Tag_Object_Global< Relation_Skeleton::Id_Type > > > >(),
-                    new_attic_global_tags, *transaction, *attic_settings().RELATION_TAGS_GLOBAL);
+    updates.insert_elements(new_attic_local_tags, *attic_settings().RELATION_TAGS_LOCAL);
+    updates.insert_elements(new_attic_global_tags, *attic_settings().RELATION_TAGS_GLOBAL);
 
     // Write changelog
-    update_elements(std::map< Timestamp, std::set< Change_Entry< Relation_Skeleton::Id_Type > > >(), changelog,
-                    *transaction, *attic_settings().RELATION_CHANGELOG);
+    updates.insert_elements(changelog, *attic_settings().RELATION_CHANGELOG);
+
+    updates.run();
 
     flush_roles();
   }
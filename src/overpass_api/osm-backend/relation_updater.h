@@ -91,6 +91,8 @@ private:
   uint32 max_role_id;
   uint32 max_written_role_id;
   std::vector< std::pair< Relation::Id_Type, Uint31_Index > > moved_relations;
+  // Whether the index from members to their parent relations is maintained
+  bool parent_index;
   std::string db_dir;
 
   Data_By_Id< Relation_Skeleton > new_data;
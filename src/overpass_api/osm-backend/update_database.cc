@@ -39,6 +39,10 @@ int main(int argc, char* argv[])
   meta_modes meta = only_data;
   bool abort = false;
   unsigned int flush_limit = 16*1024*1024;
+  bool pbf_input = false;
+  long read_threads = sysconf(_SC_NPROCESSORS_ONLN);
+  if (read_threads < 1)
+    read_threads = 1;
 
   int argpos(1);
   while (argpos < argc)
@@ -62,6 +66,22 @@ int main(int argc, char* argv[])
       if (flush_limit == 0)
         flush_limit = std::numeric_limits< unsigned int >::max();
     }
+    else if (!(strcmp(argv[argpos], "--pbf")))
+      pbf_input = true;
+    else if (!(strcmp(argv[argpos], "--parent-index")))
+      basic_settings().build_parent_index = true;
+    else if (!(strncmp(argv[argpos], "--read-threads=", 15)))
+    {
+      read_threads = atoi(std::string(argv[argpos]).substr(15).c_str());
+      if (read_threads < 1)
+        read_threads = 1;
+    }
+    else if (!(strncmp(argv[argpos], "--write-threads=", 16)))
+    {
+      basic_settings().max_write_threads = atoi(std::string(argv[argpos]).substr(16).c_str());
+      if (basic_settings().max_write_threads == 0)
+        basic_settings().max_write_threads = 1;
+    }
     else if (!(strncmp(argv[argpos], "--compression-method=", 21)))
     {
       if (std::string(argv[argpos]).substr(21) == "no")
@@ -113,10 +133,12 @@ int main(int argc, char* argv[])
   {
 #ifdef HAVE_LZ4
     std::cerr<<"Usage: "<<argv[0]<<" [--db-dir=DIR] [--version=VER] [--meta|--keep-attic] [--flush_size=FLUSH_SIZE]"
-        " [--compression-method=(no|gz|lz4)] [--map-compression-method=(no|gz|lz4)]\n";
+        " [--compression-method=(no|gz|lz4)] [--map-compression-method=(no|gz|lz4)]"
+        " [--write-threads=N] [--pbf [--read-threads=N]] [--parent-index]\n";
 #else
     std::cerr<<"Usage: "<<argv[0]<<" [--db-dir=DIR] [--version=VER] [--meta|--keep-attic] [--flush_size=FLUSH_SIZE]"
-        " [--compression-method=(no|gz)] [--map-compression-method=(no|gz)]\n";
+        " [--compression-method=(no|gz)] [--map-compression-method=(no|gz)]"
+        " [--write-threads=N] [--pbf [--read-threads=N]] [--parent-index]\n";
 #endif
     return 1;
   }
@@ -127,13 +149,19 @@ int main(int argc, char* argv[])
     {
       Osm_Updater osm_updater(get_verbatim_callback(), data_version, meta, flush_limit);
       //reading the main document
-      osm_updater.parse_file_completely(stdin);
+      if (pbf_input)
+        osm_updater.parse_pbf_completely(stdin, read_threads);
+      else
+        osm_updater.parse_file_completely(stdin);
     }
     else
     {
       Osm_Updater osm_updater(get_verbatim_callback(), db_dir, data_version, meta, flush_limit);
       //reading the main document
-      osm_updater.parse_file_completely(stdin);
+      if (pbf_input)
+        osm_updater.parse_pbf_completely(stdin, read_threads);
+      else
+        osm_updater.parse_file_completely(stdin);
     }
   }
   catch(Context_Error e)
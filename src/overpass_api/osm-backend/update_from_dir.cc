@@ -117,6 +117,12 @@ int main(int argc, char* argv[])
       if (flush_limit == 0)
         flush_limit = std::numeric_limits< unsigned int >::max();
     }
+    else if (!(strncmp(argv[argpos], "--write-threads=", 16)))
+    {
+      basic_settings().max_write_threads = atoi(std::string(argv[argpos]).substr(16).c_str());
+      if (basic_settings().max_write_threads == 0)
+        basic_settings().max_write_threads = 1;
+    }
     else
     {
       std::cerr<<"Unkown argument: "<<argv[argpos]<<'\n';
@@ -127,7 +133,8 @@ int main(int argc, char* argv[])
   if (abort)
   {
     std::cerr<<"Usage: "<<argv[0]<<" --osc-dir=DIR"
-          " [--db-dir=DIR] [--version=VER] [--meta|--keep-attic] [--flush-size=FLUSH_SIZE]\n";
+          " [--db-dir=DIR] [--version=VER] [--meta|--keep-attic] [--flush-size=FLUSH_SIZE]"
+          " [--write-threads=N]\n";
     return -1;
   }
 
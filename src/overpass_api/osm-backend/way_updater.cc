@@ -38,19 +38,41 @@
 
 Way_Updater::Way_Updater(Transaction& transaction_, meta_modes meta_)
   : update_counter(0), transaction(&transaction_),
-    external_transaction(true), partial_possible(false), meta(meta_), keys(*osm_base_settings().WAY_KEYS)
+    external_transaction(true), partial_possible(false), bulk_load(false),
+    parent_index(basic_settings().build_parent_index || has_parent_index(transaction_.get_db_dir())),
+    meta(meta_), keys(*osm_base_settings().WAY_KEYS)
 {}
 
 Way_Updater::Way_Updater(std::string db_dir_, meta_modes meta_)
   : update_counter(0), transaction(0),
-    external_transaction(false), partial_possible(true), db_dir(db_dir_), meta(meta_),
-    keys(*osm_base_settings().WAY_KEYS)
+    external_transaction(false), partial_possible(true), bulk_load(false),
+    parent_index(basic_settings().build_parent_index || has_parent_index(db_dir_)),
+    db_dir(db_dir_), meta(meta_), keys(*osm_base_settings().WAY_KEYS)
 {
   partial_possible = !file_exists
       (db_dir +
        osm_base_settings().WAYS->get_file_name_trunk() +
        osm_base_settings().WAYS->get_data_suffix() +
        osm_base_settings().WAYS->get_index_suffix());
+  // With attic data, the same element may appear in several versions across partial updates
+  bulk_load = partial_possible && meta != keep_attic;
+}
+
+
+std::map< Node::Id_Type, std::set< Way::Id_Type > > parent_ways_by_node
+    (const std::map< Uint31_Index, std::set< Way_Skeleton > >& ways)
+{
+  std::map< Node::Id_Type, std::set< Way::Id_Type > > result;
+  for (std::map< Uint31_Index, std::set< Way_Skeleton > >::const_iterator it = ways.begin();
+       it != ways.end(); ++it)
+  {
+    for (std::set< Way_Skeleton >::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+    {
+      for (std::vector< Node::Id_Type >::const_iterator it3 = it2->nds.begin(); it3 != it2->nds.end(); ++it3)
+        result[*it3].insert(it2->id);
+    }
+  }
+  return result;
 }
 
 
@@ -807,45 +829,49 @@ void Way_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu_stop
     deduplicate_data(new_data);
   std::vector< Way_Skeleton::Id_Type > ids_to_update_ = ids_to_update(new_data);
 
-  // Collect all data of existing id indexes
-  std::vector< std::pair< Way_Skeleton::Id_Type, Uint31_Index > > existing_map_positions
-      = get_existing_map_positions(ids_to_update_, *transaction, *osm_base_settings().WAYS);
-
-  // Collect all data of existing and explicitly changed skeletons
-  std::map< Uint31_Index, std::set< Way_Skeleton > > existing_skeletons
-      = get_existing_skeletons< Way_Skeleton >
-      (existing_map_positions, *transaction, *osm_base_settings().WAYS);
-
-  // Collect also all data of existing and implicitly changed skeletons
-  std::map< Uint31_Index, std::set< Way_Skeleton > > implicitly_moved_skeletons
-      = get_implicitly_moved_skeletons
-          (attic_node_skeletons, existing_skeletons, *transaction, *osm_base_settings().WAYS);
-
-  // Collect all data of existing meta elements
-  std::map< Uint31_Index, std::set< OSM_Element_Metadata_Skeleton< Way::Id_Type > > > existing_meta
-      = (meta ? get_existing_meta< OSM_Element_Metadata_Skeleton< Way::Id_Type > >
-             (existing_map_positions, *transaction, *meta_settings().WAYS_META) :
-         std::map< Uint31_Index, std::set< OSM_Element_Metadata_Skeleton< Way::Id_Type > > >());
-
-  // Collect all data of existing meta elements
-  std::vector< std::pair< Way_Skeleton::Id_Type, Uint31_Index > > implicitly_moved_positions
-      = make_id_idx_directory(implicitly_moved_skeletons);
-  std::map< Uint31_Index, std::set< OSM_Element_Metadata_Skeleton< Way::Id_Type > > > implicitly_moved_meta
-      = (meta ? get_existing_meta< OSM_Element_Metadata_Skeleton< Way::Id_Type > >
-             (implicitly_moved_positions, *transaction, *meta_settings().WAYS_META) :
-         std::map< Uint31_Index, std::set< OSM_Element_Metadata_Skeleton< Way::Id_Type > > >());
-
-  // Collect all data of existing tags
+  std::vector< std::pair< Way_Skeleton::Id_Type, Uint31_Index > > existing_map_positions;
+  std::map< Uint31_Index, std::set< Way_Skeleton > > existing_skeletons;
+  std::map< Uint31_Index, std::set< Way_Skeleton > > implicitly_moved_skeletons;
+  std::map< Uint31_Index, std::set< OSM_Element_Metadata_Skeleton< Way::Id_Type > > > existing_meta;
+  std::vector< std::pair< Way_Skeleton::Id_Type, Uint31_Index > > implicitly_moved_positions;
+  std::map< Uint31_Index, std::set< OSM_Element_Metadata_Skeleton< Way::Id_Type > > > implicitly_moved_meta;
   std::vector< Tag_Entry< Way_Skeleton::Id_Type > > existing_local_tags;
-  get_existing_tags< Way_Skeleton::Id_Type >
-      (existing_map_positions, *transaction->data_index(osm_base_settings().WAY_TAGS_LOCAL),
-       existing_local_tags);
-
-  // Collect all data of existing tags for moved ways
   std::vector< Tag_Entry< Way_Skeleton::Id_Type > > implicitly_moved_local_tags;
-  get_existing_tags< Way_Skeleton::Id_Type >
-      (implicitly_moved_positions, *transaction->data_index(osm_base_settings().WAY_TAGS_LOCAL),
-       implicitly_moved_local_tags);
+  if (!bulk_load)
+  {
+    // Collect all data of existing id indexes
+    existing_map_positions
+        = get_existing_map_positions(ids_to_update_, *transaction, *osm_base_settings().WAYS);
+
+    // Collect all data of existing and explicitly changed skeletons
+    existing_skeletons = get_existing_skeletons< Way_Skeleton >
+        (existing_map_positions, *transaction, *osm_base_settings().WAYS);
+
+    // Collect also all data of existing and implicitly changed skeletons
+    implicitly_moved_skeletons = get_implicitly_moved_skeletons
+        (attic_node_skeletons, existing_skeletons, *transaction, *osm_base_settings().WAYS);
+
+    // Collect all data of existing meta elements
+    if (meta)
+      existing_meta = get_existing_meta< OSM_Element_Metadata_Skeleton< Way::Id_Type > >
+          (existing_map_positions, *transaction, *meta_settings().WAYS_META);
+
+    // Collect all data of existing meta elements
+    implicitly_moved_positions = make_id_idx_directory(implicitly_moved_skeletons);
+    if (meta)
+      implicitly_moved_meta = get_existing_meta< OSM_Element_Metadata_Skeleton< Way::Id_Type > >
+          (implicitly_moved_positions, *transaction, *meta_settings().WAYS_META);
+
+    // Collect all data of existing tags
+    get_existing_tags< Way_Skeleton::Id_Type >
+        (existing_map_positions, *transaction->data_index(osm_base_settings().WAY_TAGS_LOCAL),
+         existing_local_tags);
+
+    // Collect all data of existing tags for moved ways
+    get_existing_tags< Way_Skeleton::Id_Type >
+        (implicitly_moved_positions, *transaction->data_index(osm_base_settings().WAY_TAGS_LOCAL),
+         implicitly_moved_local_tags);
+  }
 
   // Create a node directory id to idx:
   // Evaluate first the new_node_skeletons
@@ -900,24 +926,40 @@ void Way_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu_stop
 
   store_new_keys(new_data, keys, *transaction);
 
+  // All remaining changes go to distinct files, hence they are written concurrently
+  Parallel_Updates updates(*transaction, basic_settings().max_write_threads);
+
   // Update id indexes
-  update_map_positions(new_positions, *transaction, *osm_base_settings().WAYS);
-  callback->update_ids_finished();
+  updates.update_map_positions(new_positions, *osm_base_settings().WAYS);
 
   // Update skeletons
-  update_elements(attic_skeletons, new_skeletons, *transaction, *osm_base_settings().WAYS);
-  callback->update_coords_finished();
+  updates.update_elements(attic_skeletons, new_skeletons, *osm_base_settings().WAYS);
 
   // Update meta
   if (meta)
-    update_elements(attic_meta, new_meta, *transaction, *meta_settings().WAYS_META);
+    updates.update_elements(attic_meta, new_meta, *meta_settings().WAYS_META);
 
   // Update local tags
-  update_elements(attic_local_tags, new_local_tags, *transaction, *osm_base_settings().WAY_TAGS_LOCAL);
-  callback->tags_local_finished();
+  updates.update_elements(attic_local_tags, new_local_tags, *osm_base_settings().WAY_TAGS_LOCAL);
 
   // Update global tags
-  update_elements(attic_global_tags, new_global_tags, *transaction, *osm_base_settings().WAY_TAGS_GLOBAL);
+  updates.update_elements(attic_global_tags, new_global_tags, *osm_base_settings().WAY_TAGS_GLOBAL);
+
+  // Update the parent ways of nodes. Moved ways keep their entries.
+  std::map< Node::Id_Type, std::set< Way::Id_Type > > attic_parent_ways;
+  std::map< Node::Id_Type, std::set< Way::Id_Type > > new_parent_ways;
+  if (parent_index)
+  {
+    attic_parent_ways = parent_ways_by_node(attic_skeletons);
+    new_parent_ways = parent_ways_by_node(new_skeletons);
+    cancel_out_equal_objects(attic_parent_ways, new_parent_ways);
+    updates.update_elements(attic_parent_ways, new_parent_ways, *osm_base_settings().NODE_PARENT_WAYS);
+  }
+
+  updates.run();
+  callback->update_ids_finished();
+  callback->update_coords_finished();
+  callback->tags_local_finished();
   callback->tags_global_finished();
 
   std::map< uint32, std::vector< uint32 > > idxs_by_id;
@@ -986,35 +1028,28 @@ void Way_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu_stop
     copy_idxs_by_id(new_attic_meta, idxs_by_id);
 
     // Update id indexes
-    update_map_positions(new_attic_map_positions, *transaction, *attic_settings().WAYS);
+    updates.update_map_positions(new_attic_map_positions, *attic_settings().WAYS);
 
     // Update id index lists
-    update_elements(existing_idx_lists, new_attic_idx_lists,
-                    *transaction, *attic_settings().WAY_IDX_LIST);
+    updates.update_elements(existing_idx_lists, new_attic_idx_lists, *attic_settings().WAY_IDX_LIST);
 
     // Add attic elements
-    update_elements(attic_skeletons_to_delete, new_attic_skeletons,
-                    *transaction, *attic_settings().WAYS);
+    updates.update_elements(attic_skeletons_to_delete, new_attic_skeletons, *attic_settings().WAYS);
 
     // Add attic elements
-    update_elements(std::map< Uint31_Index, std::set< Attic< Way_Skeleton::Id_Type > > >(),
-                    new_undeleted, *transaction, *attic_settings().WAYS_UNDELETED);
+    updates.insert_elements(new_undeleted, *attic_settings().WAYS_UNDELETED);
 
     // Add attic meta
-    update_elements
-        (std::map< Uint31_Index, std::set< OSM_Element_Metadata_Skeleton< Way_Skeleton::Id_Type > > >(),
-         new_attic_meta, *transaction, *attic_settings().WAYS_META);
+    updates.insert_elements(new_attic_meta, *attic_settings().WAYS_META);
 
     // Update tags
-    update_elements(std::map< Tag_Index_Local, std::set< Attic < Way_Skeleton::Id_Type > > >(),
-                    new_attic_local_tags, *transaction, *attic_settings().WAY_TAGS_LOCAL);
-    update_elements(std::map< Tag_Index_Global,
-                        std::set< Attic < Tag_Object_Global< Way_Skeleton::Id_Type > > > >(),
-                    new_attic_global_tags, *transaction, *attic_settings().WAY_TAGS_GLOBAL);
+    updates.insert_elements(new_attic_local_tags, *attic_settings().WAY_TAGS_LOCAL);
+    updates.insert_elements(new_attic_global_tags, *attic_settings().WAY_TAGS_GLOBAL);
 
     // Write changelog
-    update_elements(std::map< Timestamp, std::set< Change_Entry< Way_Skeleton::Id_Type > > >(), changelog,
-                    *transaction, *attic_settings().WAY_CHANGELOG);
+    updates.insert_elements(changelog, *attic_settings().WAY_CHANGELOG);
+
+    updates.run();
   }
 
   if (meta != only_data)
@@ -1042,30 +1077,29 @@ void Way_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu_stop
   {
     callback->partial_started();
 
+    // Merge all pending partial files in a single pass. The data of this update is moved
+    // to a partial file as well, such that the final files are written only once.
+    std::string last(".0a");
+    last[2] += update_counter % 16;
+    rename_files(last);
+
     std::vector< std::string > froms;
-    for (uint i = 0; i < update_counter % 16; ++i)
+    for (uint i = 0; i <= update_counter % 16; ++i)
     {
       std::string from(".0a");
       from[2] += i;
       froms.push_back(from);
     }
-    merge_files(froms, "");
-
-    if (update_counter >= 256)
-      merge_files(std::vector< std::string >(1, ".2"), ".1");
-    if (update_counter >= 16)
+    for (uint i = 0; i < update_counter/16 % 16; ++i)
     {
-      std::vector< std::string > froms;
-      for (uint i = 0; i < update_counter/16 % 16; ++i)
-      {
-       std::string from(".1a");
-       from[2] += i;
-       froms.push_back(from);
-      }
-      merge_files(froms, ".1");
-
-      merge_files(std::vector< std::string >(1, ".1"), "");
+      std::string from(".1a");
+      from[2] += i;
+      froms.push_back(from);
     }
+    if (update_counter >= 256)
+      froms.push_back(".2");
+    merge_files(froms, "");
+
     update_counter = 0;
     callback->partial_finished();
   }
@@ -1073,11 +1107,7 @@ void Way_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu_stop
   {
     std::string to(".0a");
     to[2] += update_counter % 16;
-    rename_referred_file(db_dir, "", to, *osm_base_settings().WAYS);
-    rename_referred_file(db_dir, "", to, *osm_base_settings().WAY_TAGS_LOCAL);
-    rename_referred_file(db_dir, "", to, *osm_base_settings().WAY_TAGS_GLOBAL);
-    if (meta)
-      rename_referred_file(db_dir, "", to, *meta_settings().WAYS_META);
+    rename_files(to);
 
     ++update_counter;
     if (update_counter % 16 == 0)
@@ -1118,6 +1148,18 @@ void Way_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu_stop
 }
 
 
+void Way_Updater::rename_files(const std::string& to)
+{
+  rename_referred_file(db_dir, "", to, *osm_base_settings().WAYS);
+  rename_referred_file(db_dir, "", to, *osm_base_settings().WAY_TAGS_LOCAL);
+  rename_referred_file(db_dir, "", to, *osm_base_settings().WAY_TAGS_GLOBAL);
+  if (meta)
+    rename_referred_file(db_dir, "", to, *meta_settings().WAYS_META);
+  if (parent_index)
+    rename_referred_file(db_dir, "", to, *osm_base_settings().NODE_PARENT_WAYS);
+}
+
+
 void Way_Updater::merge_files(const std::vector< std::string >& froms, std::string into)
 {
   Transaction_Collection from_transactions(false, false, db_dir, froms);
@@ -1133,4 +1175,7 @@ void Way_Updater::merge_files(const std::vector< std::string >& froms, std::stri
     ::merge_files< Uint31_Index, OSM_Element_Metadata_Skeleton< Way::Id_Type > >
         (from_transactions, into_transaction, *meta_settings().WAYS_META);
   }
+  if (parent_index)
+    ::merge_files< Node::Id_Type, Way::Id_Type >
+        (from_transactions, into_transaction, *osm_base_settings().NODE_PARENT_WAYS);
 }
@@ -94,6 +94,10 @@ private:
   Transaction* transaction;
   bool external_transaction;
   bool partial_possible;
+  // The database is built from scratch, hence no element can exist before it is written
+  bool bulk_load;
+  // Whether the index from nodes to their parent ways is maintained
+  bool parent_index;
   std::vector< std::pair< Way::Id_Type, Uint31_Index > > moved_ways;
   std::string db_dir;
 
@@ -108,6 +112,7 @@ private:
 
   Key_Storage keys;
 
+  void rename_files(const std::string& to);
   void merge_files(const std::vector< std::string >& froms, std::string into);
 };
 
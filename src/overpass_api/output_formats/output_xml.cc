@@ -19,6 +19,7 @@
 #include "../../expat/escape_xml.h"
 #include "../core/settings.h"
 #include "../frontend/basic_formats.h"
+#include "../frontend/output_buffer.h"
 #include "output_xml.h"
 
 
@@ -64,138 +65,139 @@ void Output_XML::display_error(const std::string& text)
 
 void Output_XML::print_global_bbox(const Bbox_Double& bbox)
 {
-  std::cout<<"  <bounds"
-      " minlat=\""<<std::fixed<<std::setprecision(7)<<bbox.south<<"\""
-      " minlon=\""<<std::fixed<<std::setprecision(7)<<bbox.west<<"\""
-      " maxlat=\""<<std::fixed<<std::setprecision(7)<<bbox.north<<"\""
-      " maxlon=\""<<std::fixed<<std::setprecision(7)<<bbox.east<<"\""
+  Output_Buffer out(std::cout);
+  out<<"  <bounds"
+      " minlat=\""<<Fixed_Coord(bbox.south)<<"\""
+      " minlon=\""<<Fixed_Coord(bbox.west)<<"\""
+      " maxlat=\""<<Fixed_Coord(bbox.north)<<"\""
+      " maxlon=\""<<Fixed_Coord(bbox.east)<<"\""
       "/>\n\n";
 }
 
 
 template< typename Id_Type >
-void print_meta_xml(const OSM_Element_Metadata_Skeleton< Id_Type >& meta,
+void print_meta_xml(Output_Buffer& out, const OSM_Element_Metadata_Skeleton< Id_Type >& meta,
 		    const std::map< uint32, std::string >& users)
 {
-  std::cout<<" version=\""<<meta.version<<"\" timestamp=\""<<iso_string(meta.timestamp)
+  out<<" version=\""<<meta.version<<"\" timestamp=\""<<iso_string(meta.timestamp)
       <<"\" changeset=\""<<meta.changeset<<"\" uid=\""<<meta.user_id<<"\"";
   std::map< uint32, std::string >::const_iterator it = users.find(meta.user_id);
   if (it != users.end())
-    std::cout<<" user=\""<<escape_xml(it->second)<<"\"";
+    out<<" user=\""<<Xml_Escaped(it->second)<<"\"";
 }
 
 
-void prepend_action(const Output_Handler::Feature_Action& action, bool allow_delta = true)
+void prepend_action(Output_Buffer& out, const Output_Handler::Feature_Action& action, bool allow_delta = true)
 {
   if (action == Output_Handler::keep)
     ;
   else if (action == Output_Handler::show_from)
-    std::cout<<"<action type=\"show_initial\">\n";
+    out<<"<action type=\"show_initial\">\n";
   else if (action == Output_Handler::show_to)
-    std::cout<<"<action type=\"show_final\">\n";
+    out<<"<action type=\"show_final\">\n";
 
   if (allow_delta)
   {
     if (action == Output_Handler::modify)
-      std::cout<<"<action type=\"modify\">\n<old>\n";
+      out<<"<action type=\"modify\">\n<old>\n";
     else if (action == Output_Handler::create)
-      std::cout<<"<action type=\"create\">\n";
+      out<<"<action type=\"create\">\n";
     else if (action == Output_Handler::erase || action == Output_Handler::push_away)
-      std::cout<<"<action type=\"delete\">\n<old>\n";
+      out<<"<action type=\"delete\">\n<old>\n";
   }
 }
 
 
-void insert_action(const Output_Handler::Feature_Action& action)
+void insert_action(Output_Buffer& out, const Output_Handler::Feature_Action& action)
 {
   if (action == Output_Handler::keep)
     ;
   else if (action == Output_Handler::modify
       || action == Output_Handler::erase || action == Output_Handler::push_away)
-    std::cout<<"</old>\n<new>\n";
+    out<<"</old>\n<new>\n";
 }
 
 
-void append_action(const Output_Handler::Feature_Action& action, bool is_new = false, bool allow_delta = true)
+void append_action(Output_Buffer& out, const Output_Handler::Feature_Action& action, bool is_new = false, bool allow_delta = true)
 {
   if (action == Output_Handler::keep)
     ;
   else if (action == Output_Handler::show_from || action == Output_Handler::show_to)
-    std::cout<<"</action>\n";
+    out<<"</action>\n";
 
   if (allow_delta)
   {
     if (action == Output_Handler::modify)
-      std::cout<<"</new>\n</action>\n";
+      out<<"</new>\n</action>\n";
     else if (action == Output_Handler::create)
-      std::cout<<"</action>\n";
+      out<<"</action>\n";
     else if (action == Output_Handler::erase || action == Output_Handler::push_away)
     {
       if (is_new)
-        std::cout<<"</new>\n</action>\n";
+        out<<"</new>\n</action>\n";
       else
-        std::cout<<"</old>\n</action>\n";
+        out<<"</old>\n</action>\n";
     }
   }
 }
 
 
-void print_tags(const std::vector< std::pair< std::string, std::string > >* tags,
+void print_tags(Output_Buffer& out, const std::vector< std::pair< std::string, std::string > >* tags,
 		Output_Mode mode, bool& inner_tags_printed)
 {
   if ((mode.mode & Output_Mode::TAGS) && tags && !tags->empty())
   {
     if (!inner_tags_printed)
     {
-      std::cout<<">\n";
+      out<<">\n";
       inner_tags_printed = true;
     }
     for (std::vector< std::pair< std::string, std::string > >::const_iterator it = tags->begin();
 	 it != tags->end(); ++it)
-      std::cout<<"    <tag k=\""<<escape_xml(it->first)<<"\" v=\""<<escape_xml(it->second)<<"\"/>\n";
+      out<<"    <tag k=\""<<Xml_Escaped(it->first)<<"\" v=\""<<Xml_Escaped(it->second)<<"\"/>\n";
   }
 }
 
 
-void print_bounds(const Opaque_Geometry& geometry, Output_Mode mode, bool& inner_tags_printed)
+void print_bounds(Output_Buffer& out, const Opaque_Geometry& geometry, Output_Mode mode, bool& inner_tags_printed)
 {
   if ((mode.mode & Output_Mode::BOUNDS) && geometry.has_bbox())
   {
     if (!inner_tags_printed)
     {
-      std::cout<<">\n";
+      out<<">\n";
       inner_tags_printed = true;
     }
-    std::cout<<"    <bounds"
-        " minlat=\""<<std::fixed<<std::setprecision(7)<<geometry.south()<<"\""
-        " minlon=\""<<std::fixed<<std::setprecision(7)<<geometry.west()<<"\""
-        " maxlat=\""<<std::fixed<<std::setprecision(7)<<geometry.north()<<"\""
-        " maxlon=\""<<std::fixed<<std::setprecision(7)<<geometry.east()<<"\""
+    out<<"    <bounds"
+        " minlat=\""<<Fixed_Coord(geometry.south())<<"\""
+        " minlon=\""<<Fixed_Coord(geometry.west())<<"\""
+        " maxlat=\""<<Fixed_Coord(geometry.north())<<"\""
+        " maxlon=\""<<Fixed_Coord(geometry.east())<<"\""
         "/>\n";
   }
   else if ((mode.mode & Output_Mode::CENTER) && geometry.has_center())
   {
     if (!inner_tags_printed)
     {
-      std::cout<<">\n";
+      out<<">\n";
       inner_tags_printed = true;
     }
-    std::cout<<"    <center"
-        " lat=\""<<std::fixed<<std::setprecision(7)<<geometry.center_lat()<<"\""
-        " lon=\""<<std::fixed<<std::setprecision(7)<<geometry.center_lon()<<"\""
+    out<<"    <center"
+        " lat=\""<<Fixed_Coord(geometry.center_lat())<<"\""
+        " lon=\""<<Fixed_Coord(geometry.center_lon())<<"\""
         "/>\n";
   }
 }
 
 
-void print_geometry(const Opaque_Geometry& geometry, Output_Mode mode, bool& inner_tags_printed,
+void print_geometry(Output_Buffer& out, const Opaque_Geometry& geometry, Output_Mode mode, bool& inner_tags_printed,
     const std::string& indent)
 {
   if ((mode.mode & Output_Mode::GEOMETRY) && geometry.has_components())
   {
     if (!inner_tags_printed)
     {
-      std::cout<<">\n";
+      out<<">\n";
       inner_tags_printed = true;
     }
     const std::vector< Opaque_Geometry* >* components = geometry.get_components();
@@ -203,9 +205,9 @@ void print_geometry(const Opaque_Geometry& geometry, Output_Mode mode, bool& inn
     {
       if (*it)
       {
-        std::cout<<indent<<"<group>\n";
-        print_geometry(**it, mode, inner_tags_printed, indent + "  ");
-        std::cout<<indent<<"</group>\n";
+        out<<indent<<"<group>\n";
+        print_geometry(out, **it, mode, inner_tags_printed, indent + "  ");
+        out<<indent<<"</group>\n";
       }
     }
   }
@@ -213,100 +215,100 @@ void print_geometry(const Opaque_Geometry& geometry, Output_Mode mode, bool& inn
   {
     if (!inner_tags_printed)
     {
-      std::cout<<">\n";
+      out<<">\n";
       inner_tags_printed = true;
     }
     const std::vector< Point_Double >* line = geometry.get_line_geometry();
     for (std::vector< Point_Double >::const_iterator it = line->begin(); it != line->end(); ++it)
-      std::cout<<indent<<"<vertex"
-          " lat=\""<<std::fixed<<std::setprecision(7)<<it->lat<<"\""
-          " lon=\""<<std::fixed<<std::setprecision(7)<<it->lon<<"\""
+      out<<indent<<"<vertex"
+          " lat=\""<<Fixed_Coord(it->lat)<<"\""
+          " lon=\""<<Fixed_Coord(it->lon)<<"\""
           "/>\n";
   }
   else if ((mode.mode & Output_Mode::GEOMETRY) && geometry.has_multiline_geometry())
   {
     if (!inner_tags_printed)
     {
-      std::cout<<">\n";
+      out<<">\n";
       inner_tags_printed = true;
     }
     const std::vector< std::vector< Point_Double > >* linestrings = geometry.get_multiline_geometry();
     for (std::vector< std::vector< Point_Double > >::const_iterator iti = linestrings->begin();
         iti != linestrings->end(); ++iti)
     {
-      std::cout<<indent<<"<linestring>\n";
+      out<<indent<<"<linestring>\n";
       for (std::vector< Point_Double >::const_iterator it = iti->begin(); it != iti->end(); ++it)
-        std::cout<<indent<<"  <vertex"
-            " lat=\""<<std::fixed<<std::setprecision(7)<<it->lat<<"\""
-            " lon=\""<<std::fixed<<std::setprecision(7)<<it->lon<<"\""
+        out<<indent<<"  <vertex"
+            " lat=\""<<Fixed_Coord(it->lat)<<"\""
+            " lon=\""<<Fixed_Coord(it->lon)<<"\""
             "/>\n";
-      std::cout<<indent<<"</linestring>\n";
+      out<<indent<<"</linestring>\n";
     }
   }
   else if ((mode.mode & Output_Mode::GEOMETRY) && geometry.has_center())
   {
     if (!inner_tags_printed)
     {
-      std::cout<<">\n";
+      out<<">\n";
       inner_tags_printed = true;
     }
-    std::cout<<indent<<"<point"
-        " lat=\""<<std::fixed<<std::setprecision(7)<<geometry.center_lat()<<"\""
-        " lon=\""<<std::fixed<<std::setprecision(7)<<geometry.center_lon()<<"\""
+    out<<indent<<"<point"
+        " lat=\""<<Fixed_Coord(geometry.center_lat())<<"\""
+        " lon=\""<<Fixed_Coord(geometry.center_lon())<<"\""
         "/>\n";
   }
   else if ((mode.mode & Output_Mode::BOUNDS) && geometry.has_bbox())
   {
     if (!inner_tags_printed)
     {
-      std::cout<<">\n";
+      out<<">\n";
       inner_tags_printed = true;
     }
-    std::cout<<"    <bounds"
-        " minlat=\""<<std::fixed<<std::setprecision(7)<<geometry.south()<<"\""
-        " minlon=\""<<std::fixed<<std::setprecision(7)<<geometry.west()<<"\""
-        " maxlat=\""<<std::fixed<<std::setprecision(7)<<geometry.north()<<"\""
-        " maxlon=\""<<std::fixed<<std::setprecision(7)<<geometry.east()<<"\""
+    out<<"    <bounds"
+        " minlat=\""<<Fixed_Coord(geometry.south())<<"\""
+        " minlon=\""<<Fixed_Coord(geometry.west())<<"\""
+        " maxlat=\""<<Fixed_Coord(geometry.north())<<"\""
+        " maxlon=\""<<Fixed_Coord(geometry.east())<<"\""
         "/>\n";
   }
   else if ((mode.mode & Output_Mode::CENTER) && geometry.has_center())
   {
     if (!inner_tags_printed)
     {
-      std::cout<<">\n";
+      out<<">\n";
       inner_tags_printed = true;
     }
-    std::cout<<indent<<"<center"
-        " lat=\""<<std::fixed<<std::setprecision(7)<<geometry.center_lat()<<"\""
-        " lon=\""<<std::fixed<<std::setprecision(7)<<geometry.center_lon()<<"\""
+    out<<indent<<"<center"
+        " lat=\""<<Fixed_Coord(geometry.center_lat())<<"\""
+        " lon=\""<<Fixed_Coord(geometry.center_lon())<<"\""
         "/>\n";
   }
 }
 
 
-void print_members(const Way_Skeleton& skel, const Opaque_Geometry& geometry,
+void print_members(Output_Buffer& out, const Way_Skeleton& skel, const Opaque_Geometry& geometry,
 		   Output_Mode mode, bool& inner_tags_printed)
 {
   if ((mode.mode & Output_Mode::NDS) && !skel.nds.empty())
   {
     if (!inner_tags_printed)
     {
-      std::cout<<">\n";
+      out<<">\n";
       inner_tags_printed = true;
     }
     for (uint i = 0; i < skel.nds.size(); ++i)
     {
-      std::cout<<"    <nd ref=\""<<skel.nds[i].val()<<"\"";
+      out<<"    <nd ref=\""<<skel.nds[i].val()<<"\"";
       if (geometry.has_faithful_way_geometry() && geometry.way_pos_is_valid(i))
-        std::cout<<" lat=\""<<std::fixed<<std::setprecision(7)<<geometry.way_pos_lat(i)
-            <<"\" lon=\""<<std::fixed<<std::setprecision(7)<<geometry.way_pos_lon(i)<<'\"';
-      std::cout<<"/>\n";
+        out<<" lat=\""<<Fixed_Coord(geometry.way_pos_lat(i))
+            <<"\" lon=\""<<Fixed_Coord(geometry.way_pos_lon(i))<<'\"';
+      out<<"/>\n";
     }
   }
 }
 
 
-void print_members(const Relation_Skeleton& skel, const Opaque_Geometry& geometry,
+void print_members(Output_Buffer& out, const Relation_Skeleton& skel, const Opaque_Geometry& geometry,
 		   const std::map< uint32, std::string >& roles,
 		   Output_Mode mode, bool& inner_tags_printed)
 {
@@ -314,27 +316,27 @@ void print_members(const Relation_Skeleton& skel, const Opaque_Geometry& geometr
   {
     if (!inner_tags_printed)
     {
-      std::cout<<">\n";
+      out<<">\n";
       inner_tags_printed = true;
     }
     for (uint i = 0; i < skel.members.size(); ++i)
     {
       std::map< uint32, std::string >::const_iterator it = roles.find(skel.members[i].role);
-      std::cout<<"    <member type=\""<<member_type_name(skel.members[i].type)
+      out<<"    <member type=\""<<member_type_name(skel.members[i].type)
 	  <<"\" ref=\""<<skel.members[i].ref.val()
-	  <<"\" role=\""<<escape_xml(it != roles.end() ? it->second : "???")<<"\"";
+	  <<"\" role=\""<<Xml_Escaped(it != roles.end() ? it->second : "???")<<"\"";
 
       if (skel.members[i].type == Relation_Entry::NODE)
       {
 	if (geometry.has_faithful_relation_geometry() && geometry.relation_pos_is_valid(i))
-          std::cout<<" lat=\""<<std::fixed<<std::setprecision(7)<<geometry.relation_pos_lat(i)
-              <<"\" lon=\""<<std::fixed<<std::setprecision(7)<<geometry.relation_pos_lon(i)<<'\"';
-        std::cout<<"/>\n";
+          out<<" lat=\""<<Fixed_Coord(geometry.relation_pos_lat(i))
+              <<"\" lon=\""<<Fixed_Coord(geometry.relation_pos_lon(i))<<'\"';
+        out<<"/>\n";
       }
       else if (skel.members[i].type == Relation_Entry::WAY)
       {
 	if (!geometry.has_faithful_relation_geometry())
-	  std::cout<<"/>\n";
+	  out<<"/>\n";
 	else
 	{
 	  bool has_some_geometry = false;
@@ -342,80 +344,80 @@ void print_members(const Relation_Skeleton& skel, const Opaque_Geometry& geometr
 	    has_some_geometry |= geometry.relation_pos_is_valid(i, j);
 
 	  if (!has_some_geometry)
-	    std::cout<<"/>\n";
+	    out<<"/>\n";
 	  else
 	  {
-            std::cout<<">\n";
+            out<<">\n";
 	    for (uint j = 0; j < geometry.relation_way_size(i); ++j)
 	    {
 	      if (geometry.relation_pos_is_valid(i, j))
-                  std::cout<<"      <nd lat=\""<<std::fixed<<std::setprecision(7)<<geometry.relation_pos_lat(i, j)
-                      <<"\" lon=\""<<std::fixed<<std::setprecision(7)<<geometry.relation_pos_lon(i, j)<<"\"/>\n";
+                  out<<"      <nd lat=\""<<Fixed_Coord(geometry.relation_pos_lat(i, j))
+                      <<"\" lon=\""<<Fixed_Coord(geometry.relation_pos_lon(i, j))<<"\"/>\n";
               else
-                  std::cout<<"      <nd/>\n";
+                  out<<"      <nd/>\n";
 	    }
-            std::cout<<"    </member>\n";
+            out<<"    </member>\n";
 	  }
 	}
       }
       else
-        std::cout<<"/>\n";
+        out<<"/>\n";
     }
   }
 }
 
 
-void print_node(const Node_Skeleton& skel,
+void print_node(Output_Buffer& out, const Node_Skeleton& skel,
       const Opaque_Geometry& geometry,
       const std::vector< std::pair< std::string, std::string > >* tags,
       const OSM_Element_Metadata_Skeleton< Node::Id_Type >* meta,
       const std::map< uint32, std::string >* users,
       Output_Mode mode)
 {
-  std::cout<<"  <node";
+  out<<"  <node";
   if (mode.mode & Output_Mode::ID)
-    std::cout<<" id=\""<<skel.id.val()<<'\"';
+    out<<" id=\""<<skel.id.val()<<'\"';
   if ((mode.mode & (Output_Mode::COORDS | Output_Mode::GEOMETRY | Output_Mode::BOUNDS | Output_Mode::CENTER))
       && geometry.has_center())
-    std::cout<<" lat=\""<<std::fixed<<std::setprecision(7)<<geometry.center_lat()
-        <<"\" lon=\""<<std::fixed<<std::setprecision(7)<<geometry.center_lon()<<'\"';
+    out<<" lat=\""<<Fixed_Coord(geometry.center_lat())
+        <<"\" lon=\""<<Fixed_Coord(geometry.center_lon())<<'\"';
   if ((mode.mode & (Output_Mode::VERSION | Output_Mode::META)) && meta && users)
-    print_meta_xml(*meta, *users);
+    print_meta_xml(out, *meta, *users);
 
   bool inner_tags_printed = false;
-  print_tags(tags, mode, inner_tags_printed);
+  print_tags(out, tags, mode, inner_tags_printed);
   if (!inner_tags_printed)
-    std::cout<<"/>\n";
+    out<<"/>\n";
   else
-    std::cout<<"  </node>\n";
+    out<<"  </node>\n";
 }
 
 
-void print_way(const Way_Skeleton& skel,
+void print_way(Output_Buffer& out, const Way_Skeleton& skel,
       const Opaque_Geometry& geometry,
       const std::vector< std::pair< std::string, std::string > >* tags,
       const OSM_Element_Metadata_Skeleton< Way::Id_Type >* meta,
       const std::map< uint32, std::string >* users,
       Output_Mode mode)
 {
-  std::cout<<"  <way";
+  out<<"  <way";
   if (mode.mode & Output_Mode::ID)
-    std::cout<<" id=\""<<skel.id.val()<<'\"';
+    out<<" id=\""<<skel.id.val()<<'\"';
   if ((mode.mode & (Output_Mode::VERSION | Output_Mode::META)) && meta && users)
-    print_meta_xml(*meta, *users);
+    print_meta_xml(out, *meta, *users);
 
   bool inner_tags_printed = false;
-  print_bounds(geometry, mode, inner_tags_printed);
-  print_members(skel, geometry, mode, inner_tags_printed);
-  print_tags(tags, mode, inner_tags_printed);
+  print_bounds(out, geometry, mode, inner_tags_printed);
+  print_members(out, skel, geometry, mode, inner_tags_printed);
+  print_tags(out, tags, mode, inner_tags_printed);
   if (!inner_tags_printed)
-    std::cout<<"/>\n";
+    out<<"/>\n";
   else
-    std::cout<<"  </way>\n";
+    out<<"  </way>\n";
 }
 
 
-void print_relation(const Relation_Skeleton& skel,
+void print_relation(Output_Buffer& out, const Relation_Skeleton& skel,
       const Opaque_Geometry& geometry,
       const std::vector< std::pair< std::string, std::string > >* tags,
       const OSM_Element_Metadata_Skeleton< Relation::Id_Type >* meta,
@@ -423,41 +425,41 @@ void print_relation(const Relation_Skeleton& skel,
       const std::map< uint32, std::string >* users,
       Output_Mode mode)
 {
-  std::cout<<"  <relation";
+  out<<"  <relation";
   if (mode.mode & Output_Mode::ID)
-    std::cout<<" id=\""<<skel.id.val()<<'\"';
+    out<<" id=\""<<skel.id.val()<<'\"';
   if ((mode.mode & (Output_Mode::VERSION | Output_Mode::META)) && meta && users)
-    print_meta_xml(*meta, *users);
+    print_meta_xml(out, *meta, *users);
 
   bool inner_tags_printed = false;
-  print_bounds(geometry, mode, inner_tags_printed);
+  print_bounds(out, geometry, mode, inner_tags_printed);
   if (roles)
-    print_members(skel, geometry, *roles, mode, inner_tags_printed);
-  print_tags(tags, mode, inner_tags_printed);
+    print_members(out, skel, geometry, *roles, mode, inner_tags_printed);
+  print_tags(out, tags, mode, inner_tags_printed);
   if (!inner_tags_printed)
-    std::cout<<"/>\n";
+    out<<"/>\n";
   else
-    std::cout<<"  </relation>\n";
+    out<<"  </relation>\n";
 }
 
 
 template< typename Id_Type >
-void print_deleted(const std::string& type_name, const Id_Type& id,
+void print_deleted(Output_Buffer& out, const std::string& type_name, const Id_Type& id,
       const Output_Handler::Feature_Action& action,
       const OSM_Element_Metadata_Skeleton< Id_Type >* meta,
       const std::map< uint32, std::string >* users,
       Output_Mode mode)
 {
-  std::cout<<"  <"<<type_name;
+  out<<"  <"<<type_name;
   if (mode.mode & Output_Mode::ID)
-    std::cout<<" id=\""<<id.val()<<'\"';
+    out<<" id=\""<<id.val()<<'\"';
   if (action == Output_Handler::erase)
-    std::cout<<" visible=\"false\"";
+    out<<" visible=\"false\"";
   else
-    std::cout<<" visible=\"true\"";
+    out<<" visible=\"true\"";
   if ((mode.mode & (Output_Mode::VERSION | Output_Mode::META)) && meta && users)
-    print_meta_xml(*meta, *users);
-  std::cout<<"/>\n";
+    print_meta_xml(out, *meta, *users);
+  out<<"/>\n";
 }
 
 
@@ -473,21 +475,22 @@ void Output_XML::print_item(const Node_Skeleton& skel,
       const std::vector< std::pair< std::string, std::string > >* new_tags,
       const OSM_Element_Metadata_Skeleton< Node::Id_Type >* new_meta)
 {
-  prepend_action(action);
+  Output_Buffer out(std::cout);
+  prepend_action(out, action);
 
-  print_node(skel, geometry, tags, meta, users, mode);
+  print_node(out, skel, geometry, tags, meta, users, mode);
 
   if (new_skel)
   {
-    insert_action(action);
+    insert_action(out, action);
 
     if (action == Output_Handler::erase || action == Output_Handler::push_away)
-      print_deleted("node", new_skel->id, action, new_meta, users, mode);
+      print_deleted(out, "node", new_skel->id, action, new_meta, users, mode);
     else
-      print_node(*new_skel, *new_geometry, new_tags, new_meta, users, mode);
+      print_node(out, *new_skel, *new_geometry, new_tags, new_meta, users, mode);
   }
 
-  append_action(action, new_skel);
+  append_action(out, action, new_skel);
 }
 
 
@@ -503,21 +506,22 @@ void Output_XML::print_item(const Way_Skeleton& skel,
       const std::vector< std::pair< std::string, std::string > >* new_tags,
       const OSM_Element_Metadata_Skeleton< Way::Id_Type >* new_meta)
 {
-  prepend_action(action);
+  Output_Buffer out(std::cout);
+  prepend_action(out, action);
 
-  print_way(skel, geometry, tags, meta, users, mode);
+  print_way(out, skel, geometry, tags, meta, users, mode);
 
   if (new_skel)
   {
-    insert_action(action);
+    insert_action(out, action);
 
     if (action == Output_Handler::erase || action == Output_Handler::push_away)
-      print_deleted("way", new_skel->id, action, new_meta, users, mode);
+      print_deleted(out, "way", new_skel->id, action, new_meta, users, mode);
     else
-      print_way(*new_skel, *new_geometry, new_tags, new_meta, users, mode);
+      print_way(out, *new_skel, *new_geometry, new_tags, new_meta, users, mode);
   }
 
-  append_action(action, new_skel);
+  append_action(out, action, new_skel);
 }
 
 
@@ -534,21 +538,22 @@ void Output_XML::print_item(const Relation_Skeleton& skel,
       const std::vector< std::pair< std::string, std::string > >* new_tags,
       const OSM_Element_Metadata_Skeleton< Relation::Id_Type >* new_meta)
 {
-  prepend_action(action);
+  Output_Buffer out(std::cout);
+  prepend_action(out, action);
 
-  print_relation(skel, geometry, tags, meta, roles, users, mode);
+  print_relation(out, skel, geometry, tags, meta, roles, users, mode);
 
   if (new_skel)
   {
-    insert_action(action);
+    insert_action(out, action);
 
     if (action == Output_Handler::erase || action == Output_Handler::push_away)
-      print_deleted("relation", new_skel->id, action, new_meta, users, mode);
+      print_deleted(out, "relation", new_skel->id, action, new_meta, users, mode);
     else
-      print_relation(*new_skel, *new_geometry, new_tags, new_meta, roles, users, mode);
+      print_relation(out, *new_skel, *new_geometry, new_tags, new_meta, roles, users, mode);
   }
 
-  append_action(action, new_skel);
+  append_action(out, action, new_skel);
 }
 
 
@@ -558,19 +563,20 @@ void Output_XML::print_item(const Derived_Skeleton& skel,
       Output_Mode mode,
       const Feature_Action& action)
 {
-  prepend_action(action, true);
+  Output_Buffer out(std::cout);
+  prepend_action(out, action, true);
 
-  std::cout<<"  <"<<skel.type_name;
+  out<<"  <"<<skel.type_name;
   if (mode.mode & Output_Mode::ID)
-    std::cout<<" id=\""<<skel.id.val()<<'\"';
+    out<<" id=\""<<skel.id.val()<<'\"';
 
   bool inner_tags_printed = false;
-  print_geometry(geometry, mode, inner_tags_printed, "    ");
-  print_tags(tags, mode, inner_tags_printed);
+  print_geometry(out, geometry, mode, inner_tags_printed, "    ");
+  print_tags(out, tags, mode, inner_tags_printed);
   if (!inner_tags_printed)
-    std::cout<<"/>\n";
+    out<<"/>\n";
   else
-    std::cout<<"  </"<<skel.type_name<<">\n";
+    out<<"  </"<<skel.type_name<<">\n";
 
-  append_action(action, false, true);
+  append_action(out, action, false, true);
 }
@@ -56,7 +56,7 @@ void eval_elems(Value_Aggregator& aggregator, Eval_Task& task,
   {
     for (typename std::vector< Maybe_Attic >::const_iterator elem_it = idx_it->second.begin();
         elem_it != idx_it->second.end(); ++elem_it)
-      aggregator.update_value(task.eval(input_set.get_context(idx_it->first, *elem_it), key));
+      aggregator.update_value(task.eval_value(input_set.get_context(idx_it->first, *elem_it), key));
   }
 }
 
@@ -196,8 +196,9 @@ Aggregator_Statement_Maker< Evaluator_Union_Value > Evaluator_Union_Value::state
 Aggregator_Evaluator_Maker< Evaluator_Union_Value > Evaluator_Union_Value::evaluator_maker;
 
 
-void Evaluator_Union_Value::Aggregator::update_value(const std::string& value)
+void Evaluator_Union_Value::Aggregator::update_value(const Eval_Value& value_v)
 {
+  std::string value = value_v.as_string();
   if (value != "" && value != agg_value)
     agg_value = (agg_value == "" ? value : "< multiple values found >");
 }
@@ -210,7 +211,7 @@ Aggregator_Statement_Maker< Evaluator_Min_Value > Evaluator_Min_Value::statement
 Aggregator_Evaluator_Maker< Evaluator_Min_Value > Evaluator_Min_Value::evaluator_maker;
 
 
-void Evaluator_Min_Value::Aggregator::update_value(const std::string& value)
+void Evaluator_Min_Value::Aggregator::update_value(const Eval_Value& value)
 {
   if (relevant_type == type_void)
     relevant_type = type_int64;
@@ -218,7 +219,7 @@ void Evaluator_Min_Value::Aggregator::update_value(const std::string& value)
   if (relevant_type <= type_int64)
   {
     int64 rhs_l = 0;
-    if (try_int64(value, rhs_l))
+    if (value.as_int64(rhs_l))
       result_l = std::min(result_l, rhs_l);
     else
       relevant_type = type_double;
@@ -227,14 +228,15 @@ void Evaluator_Min_Value::Aggregator::update_value(const std::string& value)
   if (relevant_type <= type_double)
   {
     double rhs_d = 0;
-    if (try_double(value, rhs_d))
+    if (value.as_double(rhs_d))
       result_d = std::min(result_d, rhs_d);
     else
       relevant_type = type_string;
   }
 
-  if (value != "")
-    result_s = (result_s != "" ? std::min(result_s, value) : value);
+  std::string value_s = value.as_string();
+  if (value_s != "")
+    result_s = (result_s != "" ? std::min(result_s, value_s) : value_s);
 }
 
 
@@ -258,7 +260,7 @@ Aggregator_Statement_Maker< Evaluator_Max_Value > Evaluator_Max_Value::statement
 Aggregator_Evaluator_Maker< Evaluator_Max_Value > Evaluator_Max_Value::evaluator_maker;
 
 
-void Evaluator_Max_Value::Aggregator::update_value(const std::string& value)
+void Evaluator_Max_Value::Aggregator::update_value(const Eval_Value& value)
 {
   if (relevant_type == type_void)
     relevant_type = type_int64;
@@ -266,7 +268,7 @@ void Evaluator_Max_Value::Aggregator::update_value(const std::string& value)
   if (relevant_type <= type_int64)
   {
     int64 rhs_l = 0;
-    if (try_int64(value, rhs_l))
+    if (value.as_int64(rhs_l))
       result_l = std::max(result_l, rhs_l);
     else
       relevant_type = type_double;
@@ -275,14 +277,15 @@ void Evaluator_Max_Value::Aggregator::update_value(const std::string& value)
   if (relevant_type <= type_double)
   {
     double rhs_d = 0;
-    if (try_double(value, rhs_d))
+    if (value.as_double(rhs_d))
       result_d = std::max(result_d, rhs_d);
     else
       relevant_type = type_string;
   }
 
-  if (value != "")
-    result_s = (result_s != "" ? std::max(result_s, value) : value);
+  std::string value_s = value.as_string();
+  if (value_s != "")
+    result_s = (result_s != "" ? std::max(result_s, value_s) : value_s);
 }
 
 
@@ -306,12 +309,12 @@ Aggregator_Statement_Maker< Evaluator_Sum_Value > Evaluator_Sum_Value::statement
 Aggregator_Evaluator_Maker< Evaluator_Sum_Value > Evaluator_Sum_Value::evaluator_maker;
 
 
-void Evaluator_Sum_Value::Aggregator::update_value(const std::string& value)
+void Evaluator_Sum_Value::Aggregator::update_value(const Eval_Value& value)
 {
   if (relevant_type == type_int64)
   {
     int64 rhs_l = 0;
-    if (try_int64(value, rhs_l))
+    if (value.as_int64(rhs_l))
       result_l += rhs_l;
     else
       relevant_type = type_double;
@@ -320,7 +323,7 @@ void Evaluator_Sum_Value::Aggregator::update_value(const std::string& value)
   if (relevant_type == type_int64 || relevant_type == type_double)
   {
     double rhs_d = 0;
-    if (try_double(value, rhs_d))
+    if (value.as_double(rhs_d))
       result_d += rhs_d;
     else
       relevant_type = type_string;
@@ -346,8 +349,9 @@ Aggregator_Statement_Maker< Evaluator_Set_Value > Evaluator_Set_Value::statement
 Aggregator_Evaluator_Maker< Evaluator_Set_Value > Evaluator_Set_Value::evaluator_maker;
 
 
-void Evaluator_Set_Value::Aggregator::update_value(const std::string& value)
+void Evaluator_Set_Value::Aggregator::update_value(const Eval_Value& value_v)
 {
+  std::string value = value_v.as_string();
   if (value != "")
     values.insert(value);
 }
@@ -117,6 +117,9 @@ void Area_Constraint::filter(Resource_Manager& rman, Set& into)
 
 void Area_Constraint::filter(const Statement& query, Resource_Manager& rman, Set& into)
 {
+  // The areas may have changed since the last call
+  area->clear_prepared_cells();
+
   std::set< Uint31_Index > area_blocks_req;
   if (area->areas_from_input())
   {
@@ -196,6 +199,8 @@ void Area_Constraint::filter(const Statement& query, Resource_Manager& rman, Set
   }
 
   //TODO: filter areas
+
+  area->clear_prepared_cells();
 }
 
 
@@ -236,7 +241,7 @@ Statement* Area_Query_Statement::Criterion_Maker::create_criterion(const Token_N
 
 Area_Query_Statement::Area_Query_Statement
     (int line_number_, const std::map< std::string, std::string >& input_attributes, Parsed_Query& global_settings)
-    : Output_Statement(line_number_), area_blocks_req_filled(false)
+    : Output_Statement(line_number_), area_blocks_req_filled(false), prepared_space(0)
 {
   is_used_ = true;
 
@@ -355,6 +360,188 @@ bool Area_Constraint::delivers_data(Resource_Manager& rman)
 }
 
 
+void Prepared_Area_Cell::prepare
+    (uint32 ll_index, const std::map< Area_Skeleton::Id_Type, std::vector< Area_Block > >& areas_)
+{
+  areas.clear();
+  areas.resize(areas_.size());
+  total_segments = 0;
+
+  std::vector< Prepared_Area >::iterator area_it = areas.begin();
+  for (std::map< Area_Skeleton::Id_Type, std::vector< Area_Block > >::const_iterator it = areas_.begin();
+      it != areas_.end(); ++it, ++area_it)
+  {
+    uint32 block = 0;
+    for (std::vector< Area_Block >::const_iterator it2 = it->second.begin(); it2 != it->second.end();
+        ++it2, ++block)
+    {
+      std::vector< uint64 >::const_iterator cit = it2->coors.begin();
+      if (cit == it2->coors.end())
+        continue;
+      Segment segment;
+      segment.block = block;
+      segment.lat = ::ilat(ll_index | (((*cit)>>32)&0xff), (*cit & 0xffffffff));
+      segment.lon = ::ilon(ll_index | (((*cit)>>32)&0xff), (*cit & 0xffffffff));
+      while (++cit != it2->coors.end())
+      {
+        segment.last_lat = segment.lat;
+        segment.last_lon = segment.lon;
+        segment.lat = ::ilat(ll_index | (((*cit)>>32)&0xff), (*cit & 0xffffffff));
+        segment.lon = ::ilon(ll_index | (((*cit)>>32)&0xff), (*cit & 0xffffffff));
+        area_it->segments.push_back(segment);
+      }
+    }
+    area_it->index_segments();
+    total_segments += area_it->segments.size();
+  }
+}
+
+
+uint64 Prepared_Area_Cell::used_space() const
+{
+  uint64 result = sizeof(Prepared_Area_Cell) + areas.capacity() * sizeof(Prepared_Area);
+  for (std::vector< Prepared_Area >::const_iterator it = areas.begin(); it != areas.end(); ++it)
+    result += it->segments.capacity() * sizeof(Segment)
+        + (it->bucket_starts.capacity() + it->bucket_items.capacity()) * sizeof(uint32);
+  return result;
+}
+
+
+// Limits the memory spent on segments that span many buckets
+const uint32 MAX_BUCKET_ITEMS_PER_SEGMENT = 8;
+
+
+void Prepared_Area_Cell::Prepared_Area::index_segments()
+{
+  min_lon = 0;
+  max_lon = -1;
+  bucket_width = 1;
+  bucket_starts.clear();
+  bucket_items.clear();
+  if (segments.empty())
+    return;
+
+  min_lon = std::min(segments.front().last_lon, segments.front().lon);
+  max_lon = std::max(segments.front().last_lon, segments.front().lon);
+  for (std::vector< Segment >::const_iterator it = segments.begin(); it != segments.end(); ++it)
+  {
+    min_lon = std::min(min_lon, std::min(it->last_lon, it->lon));
+    max_lon = std::max(max_lon, std::max(it->last_lon, it->lon));
+  }
+
+  uint32 num_buckets = std::min(segments.size(), (std::vector< Segment >::size_type)4096);
+  std::vector< uint32 > counts;
+  while (true)
+  {
+    bucket_width = ((int64)max_lon - min_lon)/num_buckets + 1;
+    counts.assign(num_buckets, 0);
+    uint64 total = 0;
+    for (std::vector< Segment >::const_iterator it = segments.begin(); it != segments.end(); ++it)
+    {
+      uint32 first = ((int64)std::min(it->last_lon, it->lon) - min_lon)/bucket_width;
+      uint32 last = ((int64)std::max(it->last_lon, it->lon) - min_lon)/bucket_width;
+      for (uint32 i = first; i <= last; ++i)
+        ++counts[i];
+      total += last - first + 1;
+    }
+    if (num_buckets == 1 || total <= (uint64)MAX_BUCKET_ITEMS_PER_SEGMENT*segments.size())
+      break;
+    num_buckets /= 2;
+  }
+
+  bucket_starts.resize(num_buckets + 1);
+  bucket_starts[0] = 0;
+  for (uint32 i = 0; i < num_buckets; ++i)
+    bucket_starts[i+1] = bucket_starts[i] + counts[i];
+
+  // Filling in the order of the segments keeps the segments of a block together in each bucket
+  bucket_items.resize(bucket_starts.back());
+  std::vector< uint32 > pos(bucket_starts.begin(), bucket_starts.end() - 1);
+  for (uint32 j = 0; j < segments.size(); ++j)
+  {
+    uint32 first = ((int64)std::min(segments[j].last_lon, segments[j].lon) - min_lon)/bucket_width;
+    uint32 last = ((int64)std::max(segments[j].last_lon, segments[j].lon) - min_lon)/bucket_width;
+    for (uint32 i = first; i <= last; ++i)
+      bucket_items[pos[i]++] = j;
+  }
+}
+
+
+Prepared_Area_Cell::Result Prepared_Area_Cell::check(uint32 area_idx, uint32 coord_lat, int32 coord_lon) const
+{
+  Result result;
+  const Prepared_Area& area = areas[area_idx];
+  if (coord_lon < area.min_lon || area.max_lon < coord_lon)
+    return result;
+
+  uint32 bucket = ((int64)coord_lon - area.min_lon)/area.bucket_width;
+  uint32 block = 0;
+  int block_state = 0;
+  for (uint32 i = area.bucket_starts[bucket]; i < area.bucket_starts[bucket+1]; ++i)
+  {
+    const Segment& segment = area.segments[area.bucket_items[i]];
+    if (segment.block != block)
+    {
+      if (block_state == Coord_Query_Statement::HIT)
+        ++result.hit_blocks;
+      else
+        result.state ^= block_state;
+      block = segment.block;
+      block_state = 0;
+    }
+    if (block_state == Coord_Query_Statement::HIT)
+      continue;
+
+    int check = Coord_Query_Statement::check_segment
+        (segment.last_lat, segment.last_lon, segment.lat, segment.lon, coord_lat, coord_lon);
+    if (check == Coord_Query_Statement::HIT)
+      block_state = Coord_Query_Statement::HIT;
+    else
+      block_state ^= check;
+  }
+  if (block_state == Coord_Query_Statement::HIT)
+    ++result.hit_blocks;
+  else
+    result.state ^= block_state;
+
+  return result;
+}
+
+
+// Limits the memory spent on the prepared cells of a single statement.
+// The memory is also reported to the health check, hence it counts against the query's maxsize.
+const uint64 MAX_PREPARED_SPACE = 128*1024*1024;
+
+
+void Area_Query_Statement::clear_prepared_cells()
+{
+  prepared_cells.clear();
+  prepared_space = 0;
+}
+
+
+const Prepared_Area_Cell* Area_Query_Statement::find_prepared_cell(uint32 idx) const
+{
+  std::map< Uint31_Index, Prepared_Area_Cell >::const_iterator it = prepared_cells.find(Uint31_Index(idx));
+  return (it != prepared_cells.end() ? &it->second : 0);
+}
+
+
+const Prepared_Area_Cell& Area_Query_Statement::prepare_cell
+    (uint32 idx, const std::map< Area_Skeleton::Id_Type, std::vector< Area_Block > >& areas)
+{
+  Prepared_Area_Cell cell;
+  cell.prepare(idx, areas);
+  if (prepared_space + cell.used_space() > MAX_PREPARED_SPACE)
+    clear_prepared_cells();
+
+  prepared_space += cell.used_space();
+  Prepared_Area_Cell& result = prepared_cells[Uint31_Index(idx)];
+  std::swap(result, cell);
+  return result;
+}
+
+
 void Area_Query_Statement::collect_nodes
     (const std::set< std::pair< Uint32_Index, Uint32_Index > >& nodes_req,
      const std::set< Uint31_Index >& req,
@@ -370,12 +557,13 @@ void Area_Query_Statement::collect_nodes
       area_it(area_blocks_db.discrete_begin(req.begin(), req.end()));
   Block_Backend< Uint32_Index, Node_Skeleton >::Range_Iterator
       nodes_it(nodes_db.range_begin(nodes_req.begin(), nodes_req.end()));
+  clear_prepared_cells();
   uint32 current_idx(0);
   if (!(area_it == area_blocks_db.discrete_end()))
     current_idx = area_it.index().val();
   while (!(area_it == area_blocks_db.discrete_end()))
   {
-    rman.health_check(*this);
+    rman.health_check(*this, 0, prepared_space);
 
     std::map< Area_Skeleton::Id_Type, std::vector< Area_Block > > areas;
     while ((!(area_it == area_blocks_db.discrete_end())) &&
@@ -385,6 +573,7 @@ void Area_Query_Statement::collect_nodes
 	areas[area_it.object().id].push_back(area_it.object());
       ++area_it;
     }
+    const Prepared_Area_Cell& cell = prepare_cell(current_idx, areas);
     while ((!(nodes_it == nodes_db.range_end())) &&
         ((nodes_it.index().val() & 0xffffff00) == current_idx))
     {
@@ -400,23 +589,10 @@ void Area_Query_Statement::collect_nodes
       int32 ilon(::lon(nodes_it.index().val(), nodes_it.object().ll_lower)*10000000
           + (::lon(nodes_it.index().val(), nodes_it.object().ll_lower) > 0
 	      ? 0.5 : -0.5));
-      for (std::map< Area_Skeleton::Id_Type, std::vector< Area_Block > >::const_iterator it = areas.begin();
-	   it != areas.end(); ++it)
+      for (uint32 i = 0; i < cell.num_areas(); ++i)
       {
-        int inside = 0;
-        for (std::vector< Area_Block >::const_iterator it2 = it->second.begin(); it2 != it->second.end();
-	     ++it2)
-        {
-	  int check(Coord_Query_Statement::check_area_block(current_idx, *it2, ilat, ilon));
-	  if (check == Coord_Query_Statement::HIT)
-	  {
-	    inside = 1;
-	    break;
-	  }
-	  else if (check != 0)
-	    inside ^= check;
-        }
-        if (inside)
+        Prepared_Area_Cell::Result check = cell.check(i, ilat, ilon);
+        if (check.hit_blocks > 0 || check.state != 0)
 	{
 	  nodes[nodes_it.index()].push_back(nodes_it.object());
 	  break;
@@ -449,15 +625,17 @@ void Area_Query_Statement::collect_nodes
     current_idx = area_it.index().val();
     if (loop_count > 1024*1024)
     {
-      rman.health_check(*this);
+      rman.health_check(*this, 0, prepared_space);
       loop_count = 0;
     }
 
+    // The cell may be prepared already by a previous call
+    const Prepared_Area_Cell* cell = find_prepared_cell(current_idx);
     std::map< Area_Skeleton::Id_Type, std::vector< Area_Block > > areas;
     while ((!(area_it == area_blocks_db.discrete_end())) &&
         (area_it.index().val() == current_idx))
     {
-      if (binary_search(area_id.begin(), area_id.end(), area_it.object().id))
+      if (!cell && binary_search(area_id.begin(), area_id.end(), area_it.object().id))
 	areas[area_it.object().id].push_back(area_it.object());
       ++area_it;
     }
@@ -467,6 +645,8 @@ void Area_Query_Statement::collect_nodes
       nodes_it->second.clear();
       ++nodes_it;
     }
+    if (!cell && nodes_it != nodes.end() && (nodes_it->first.val() & 0xffffff00) == current_idx)
+      cell = &prepare_cell(current_idx, areas);
     while (nodes_it != nodes.end() &&
         (nodes_it->first.val() & 0xffffff00) == current_idx)
     {
@@ -478,25 +658,13 @@ void Area_Query_Statement::collect_nodes
             + 91.0)*10000000+0.5);
         int32 ilon(::lon(nodes_it->first.val(), iit->ll_lower)*10000000
             + (::lon(nodes_it->first.val(), iit->ll_lower) > 0 ? 0.5 : -0.5));
-        for (std::map< Area_Skeleton::Id_Type, std::vector< Area_Block > >::const_iterator it = areas.begin();
-	     it != areas.end(); ++it)
+        for (uint32 i = 0; i < cell->num_areas(); ++i)
         {
-          int inside = 0;
-          for (std::vector< Area_Block >::const_iterator it2 = it->second.begin(); it2 != it->second.end();
-	       ++it2)
-          {
-            ++loop_count;
-
-	    int check(Coord_Query_Statement::check_area_block(current_idx, *it2, ilat, ilon));
-	    if (check == Coord_Query_Statement::HIT && add_border)
-	    {
-	      inside = 1;
-	      break;
-	    }
-	    else if (check != 0)
-	      inside ^= check;
-          }
-          if (inside)
+          ++loop_count;
+
+          // Without add_border, each block with the node on its boundary toggles the result
+          Prepared_Area_Cell::Result check = cell->check(i, ilat, ilon);
+          if ((add_border ? check.hit_blocks > 0 : check.hit_blocks % 2 == 1) || check.state != 0)
 	  {
 	    into.push_back(*iit);
 	    break;
@@ -732,7 +900,7 @@ void Area_Query_Statement::collect_ways
     current_idx = area_it.index().val();
     if (loop_count > 64*1024)
     {
-      rman.health_check(*this);
+      rman.health_check(*this, 0, prepared_space);
       loop_count = 0;
     }
 
@@ -748,6 +916,9 @@ void Area_Query_Statement::collect_ways
     // check nodes
     while (nodes_it != way_coords_to_id.end() && nodes_it->first < current_idx)
       ++nodes_it;
+    const Prepared_Area_Cell* cell = find_prepared_cell(current_idx);
+    if (!cell && nodes_it != way_coords_to_id.end() && (nodes_it->first & 0xffffff00) == current_idx)
+      cell = &prepare_cell(current_idx, areas);
     while (nodes_it != way_coords_to_id.end() &&
         (nodes_it->first & 0xffffff00) == current_idx)
     {
@@ -757,25 +928,13 @@ void Area_Query_Statement::collect_ways
       {
         uint32 ilat = ::ilat(nodes_it->first, iit->first);
         int32 ilon = ::ilon(nodes_it->first, iit->first);
-        for (std::map< Area_Skeleton::Id_Type, std::vector< Area_Block > >::const_iterator it = areas.begin();
-	     it != areas.end(); ++it)
+        for (uint32 i = 0; i < cell->num_areas(); ++i)
         {
-          int inside = 0;
-          for (std::vector< Area_Block >::const_iterator it2 = it->second.begin(); it2 != it->second.end();
-	       ++it2)
-          {
-            ++loop_count;
-
-	    int check(Coord_Query_Statement::check_area_block(current_idx, *it2, ilat, ilon));
-	    if (check == Coord_Query_Statement::HIT)
-            {
-              inside = Coord_Query_Statement::HIT;
-              break;
-            }
-	    else
-	      inside ^= check;
-          }
-          if (inside & (Coord_Query_Statement::TOGGLE_EAST | Coord_Query_Statement::TOGGLE_WEST))
+          ++loop_count;
+
+          // Nodes on the boundary do not count here
+          Prepared_Area_Cell::Result check = cell->check(i, ilat, ilon);
+          if (check.hit_blocks == 0 && check.state != 0)
             ways_inside[iit->second] = true;
         }
       }
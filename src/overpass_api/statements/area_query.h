@@ -29,6 +29,61 @@
 #include <vector>
 
 
+/* The area blocks of one index cell, prepared for many point-in-area tests.
+ * The segments of all blocks are decoded once. The test counts the crossings of a ray
+ * from the point to the south, hence only segments that span the longitude of the point matter.
+ * They are found through buckets of equal longitude width. */
+class Prepared_Area_Cell
+{
+  public:
+    struct Result
+    {
+      Result() : hit_blocks(0), state(0) {}
+
+      // The number of blocks that have the point on their boundary
+      uint32 hit_blocks;
+      // The toggles of all other blocks combined
+      int state;
+    };
+
+    void prepare(uint32 ll_index, const std::map< Area_Skeleton::Id_Type, std::vector< Area_Block > >& areas);
+
+    uint32 num_areas() const { return areas.size(); }
+    uint64 num_segments() const { return total_segments; }
+    // The bytes of memory held by the prepared data
+    uint64 used_space() const;
+
+    // Evaluates the blocks of the area like Coord_Query_Statement::check_area_block evaluates each block
+    Result check(uint32 area_idx, uint32 coord_lat, int32 coord_lon) const;
+
+  private:
+    struct Segment
+    {
+      uint32 last_lat;
+      int32 last_lon;
+      uint32 lat;
+      int32 lon;
+      uint32 block;
+    };
+
+    struct Prepared_Area
+    {
+      int32 min_lon;
+      int32 max_lon;
+      int64 bucket_width;
+      std::vector< Segment > segments;
+      // The segments of bucket i are bucket_items[bucket_starts[i]] to bucket_items[bucket_starts[i+1]-1]
+      std::vector< uint32 > bucket_starts;
+      std::vector< uint32 > bucket_items;
+
+      void index_segments();
+    };
+
+    std::vector< Prepared_Area > areas;
+    uint64 total_segments;
+};
+
+
 class Area_Query_Statement : public Output_Statement
 {
   public:
@@ -86,6 +141,9 @@ class Area_Query_Statement : public Output_Statement
        const std::set< Uint31_Index >& req, bool add_border,
        const Statement& query, Resource_Manager& rman);
 
+    // The prepared cells are kept from one collect call to the next until this is called
+    void clear_prepared_cells();
+
     bool areas_from_input() const { return (submitted_id == 0); }
     std::string get_input() const { return input; }
 
@@ -120,8 +178,14 @@ class Area_Query_Statement : public Output_Statement
     bool area_blocks_req_filled;
     static bool is_used_;
     std::vector< Query_Constraint* > constraints;
+    std::map< Uint31_Index, Prepared_Area_Cell > prepared_cells;
+    // The bytes of memory held by prepared_cells
+    uint64 prepared_space;
 
     void fill_ranges(Resource_Manager& rman);
+    const Prepared_Area_Cell* find_prepared_cell(uint32 idx) const;
+    const Prepared_Area_Cell& prepare_cell
+        (uint32 idx, const std::map< Area_Skeleton::Id_Type, std::vector< Area_Block > >& areas);
 };
 
 
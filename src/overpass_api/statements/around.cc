@@ -369,17 +369,21 @@ template< typename Node_Skeleton >
 void filter_nodes_expensive(const Around_Statement& around,
                             std::map< Uint32_Index, std::vector< Node_Skeleton > >& nodes)
 {
+  Around_Candidates candidates;
   for (typename std::map< Uint32_Index, std::vector< Node_Skeleton > >::iterator it = nodes.begin();
       it != nodes.end(); ++it)
   {
-    std::vector< Node_Skeleton > local_into;
+    candidates.clear();
     for (typename std::vector< Node_Skeleton >::const_iterator iit = it->second.begin();
         iit != it->second.end(); ++iit)
+      candidates.push_back(::lat(it->first.val(), iit->ll_lower), ::lon(it->first.val(), iit->ll_lower));
+    around.is_inside(candidates);
+
+    std::vector< Node_Skeleton > local_into;
+    for (uint32 i = 0; i < it->second.size(); ++i)
     {
-      double lat(::lat(it->first.val(), iit->ll_lower));
-      double lon(::lon(it->first.val(), iit->ll_lower));
-      if (around.is_inside(lat, lon))
-	local_into.push_back(*iit);
+      if (candidates.inside[i])
+	local_into.push_back(it->second[i]);
     }
     it->second.swap(local_into);
   }
@@ -391,6 +395,7 @@ void filter_ways_expensive(const Around_Statement& around,
                            const Way_Geometry_Store& way_geometries,
                            std::map< Uint31_Index, std::vector< Way_Skeleton > >& ways)
 {
+  Around_Candidates candidates;
   for (typename std::map< Uint31_Index, std::vector< Way_Skeleton > >::iterator it = ways.begin();
       it != ways.end(); ++it)
   {
@@ -398,7 +403,7 @@ void filter_ways_expensive(const Around_Statement& around,
     for (typename std::vector< Way_Skeleton >::const_iterator iit = it->second.begin();
         iit != it->second.end(); ++iit)
     {
-      if (around.is_inside(way_geometries.get_geometry(*iit)))
+      if (around.is_inside(way_geometries.get_geometry(*iit), candidates))
 	local_into.push_back(*iit);
     }
     it->second.swap(local_into);
@@ -413,6 +418,7 @@ void filter_relations_expensive(const Around_Statement& around,
                                 const Way_Geometry_Store& way_geometries,
                                 std::map< Uint31_Index, std::vector< Relation_Skeleton > >& relations)
 {
+  Around_Candidates candidates;
   for (typename std::map< Uint31_Index, std::vector< Relation_Skeleton > >::iterator it = relations.begin();
       it != relations.end(); ++it)
   {
@@ -444,7 +450,7 @@ void filter_relations_expensive(const Around_Statement& around,
               binary_search_for_pair_id(way_members_by_id, nit->ref32());
 	  if (!second_nd)
 	    continue;
-	  if (around.is_inside(way_geometries.get_geometry(*second_nd->second)))
+	  if (around.is_inside(way_geometries.get_geometry(*second_nd->second), candidates))
 	  {
 	    local_into.push_back(*iit);
 	    break;
@@ -676,9 +682,9 @@ Around_Statement::~Around_Statement()
 }
 
 
-std::vector< double > cartesian(double lat, double lon)
+Cartesian cartesian(double lat, double lon)
 {
-  std::vector< double > result(3);
+  Cartesian result;
 
   result[0] = sin(lat/90.0*acos(0));
   result[1] = cos(lat/90.0*acos(0))*sin(lon/90.0*acos(0));
@@ -688,7 +694,7 @@ std::vector< double > cartesian(double lat, double lon)
 }
 
 
-void rescale(double a, std::vector< double >& v)
+void rescale(double a, Cartesian& v)
 {
   v[0] *= a;
   v[1] *= a;
@@ -696,9 +702,9 @@ void rescale(double a, std::vector< double >& v)
 }
 
 
-std::vector< double > sum(const std::vector< double >& v, const std::vector< double >& w)
+Cartesian sum(const Cartesian& v, const Cartesian& w)
 {
-  std::vector< double > result(3);
+  Cartesian result;
 
   result[0] = v[0] + w[0];
   result[1] = v[1] + w[1];
@@ -708,15 +714,15 @@ std::vector< double > sum(const std::vector< double >& v, const std::vector< dou
 }
 
 
-double scalar_prod(const std::vector< double >& v, const std::vector< double >& w)
+double scalar_prod(const Cartesian& v, const Cartesian& w)
 {
   return v[0]*w[0] + v[1]*w[1] + v[2]*w[2];
 }
 
 
-std::vector< double > cross_prod(const std::vector< double >& v, const std::vector< double >& w)
+Cartesian cross_prod(const Cartesian& v, const Cartesian& w)
 {
-  std::vector< double > result(3);
+  Cartesian result;
 
   result[0] = v[1]*w[2] - v[2]*w[1];
   result[1] = v[2]*w[0] - v[0]*w[2];
@@ -745,7 +751,121 @@ Prepared_Point::Prepared_Point
 }
 
 
-double great_circle_line_dist(const Prepared_Segment& segment, const std::vector< double >& cartesian)
+void Around_Candidates::clear()
+{
+  lat.clear();
+  lon.clear();
+  ll_upper.clear();
+  x.clear();
+  y.clear();
+  z.clear();
+}
+
+
+void Around_Candidates::push_back(double lat_, double lon_)
+{
+  lat.push_back(lat_);
+  lon.push_back(lon_);
+  ll_upper.push_back(::ll_upper_(lat_, lon_));
+  Cartesian coord = cartesian(lat_, lon_);
+  x.push_back(coord[0]);
+  y.push_back(coord[1]);
+  z.push_back(coord[2]);
+}
+
+
+// Limits the memory spent on a single large item
+const uint32 MAX_BUCKETS_PER_ITEM = 1024;
+
+
+void Prepared_Bucket_Index::clear()
+{
+  shift = 16;
+  size = 0;
+  buckets.clear();
+  everywhere_.clear();
+}
+
+
+void Prepared_Bucket_Index::set_bucket_size(double meters)
+{
+  // With shift 16, a bucket has the size of a quadtile of the node index,
+  // i.e. 2^16 * 10^-7 degrees or about 730 meters of latitude
+  shift = 16;
+  while (shift < 30 && (1u<<shift)*(40000.0*1000.0/360.0/10000000.0) < meters)
+    ++shift;
+}
+
+
+bool Prepared_Bucket_Index::calc_buckets(const Bbox_Double& bbox, std::vector< Uint32_Index >& result) const
+{
+  if (!bbox.valid() || bbox.east < bbox.west)
+    return false;
+
+  uint32 south = ilat_(bbox.south)>>shift;
+  uint32 north = ilat_(bbox.north)>>shift;
+  int32 west = ilon_(bbox.west)>>shift;
+  int32 east = ilon_(bbox.east)>>shift;
+  if ((uint64)(north - south + 1)*(east - west + 1) > MAX_BUCKETS_PER_ITEM)
+    return false;
+
+  for (uint32 i = south; i <= north; ++i)
+  {
+    for (int32 j = west; j <= east; ++j)
+      result.push_back(Uint32_Index(::ll_upper(i<<shift, (int32)((uint32)j<<shift)) ^ 0x40000000));
+  }
+  return true;
+}
+
+
+void Prepared_Bucket_Index::add(const Bbox_Double& bbox)
+{
+  std::vector< Uint32_Index > idxs;
+  if (calc_buckets(bbox, idxs))
+  {
+    for (std::vector< Uint32_Index >::const_iterator it = idxs.begin(); it != idxs.end(); ++it)
+      buckets[*it].push_back(size);
+  }
+  else
+    everywhere_.push_back(size);
+  ++size;
+}
+
+
+const std::vector< uint32 >* Prepared_Bucket_Index::bucket(double lat, double lon) const
+{
+  // This is the bucket from calc_buckets, because only the lower bits of the quadtile differ
+  uint32 mask = ~((1u<<(2*(shift-16))) - 1);
+  std::map< Uint32_Index, std::vector< uint32 > >::const_iterator it
+      = buckets.find(Uint32_Index(::ll_upper_(lat, lon) & mask));
+  return (it != buckets.end() ? &it->second : 0);
+}
+
+
+void Prepared_Bucket_Index::collect(const Bbox_Double& bbox, std::vector< uint32 >& result) const
+{
+  result.clear();
+  std::vector< Uint32_Index > idxs;
+  if (!calc_buckets(bbox, idxs))
+  {
+    for (uint32 i = 0; i < size; ++i)
+      result.push_back(i);
+    return;
+  }
+
+  for (std::vector< Uint32_Index >::const_iterator it = idxs.begin(); it != idxs.end(); ++it)
+  {
+    std::map< Uint32_Index, std::vector< uint32 > >::const_iterator bit = buckets.find(*it);
+    if (bit != buckets.end())
+      result.insert(result.end(), bit->second.begin(), bit->second.end());
+  }
+  result.insert(result.end(), everywhere_.begin(), everywhere_.end());
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+}
+
+
+double great_circle_line_dist(const Prepared_Segment& segment, const Cartesian& cartesian)
 {
   double scalar_prod_ = std::abs(scalar_prod(cartesian, segment.norm))
       /sqrt(scalar_prod(segment.norm, segment.norm));
@@ -760,7 +880,7 @@ double great_circle_line_dist(const Prepared_Segment& segment, const std::vector
 double great_circle_line_dist(double llat1, double llon1, double llat2, double llon2,
                               double plat, double plon)
 {
-  std::vector< double > norm = cross_prod(cartesian(llat1, llon1), cartesian(llat2, llon2));
+  Cartesian norm = cross_prod(cartesian(llat1, llon1), cartesian(llat2, llon2));
 
   double scalar_prod_ = std::abs(scalar_prod(cartesian(plat, plon), norm))
       /sqrt(scalar_prod(norm, norm));
@@ -775,11 +895,11 @@ double great_circle_line_dist(double llat1, double llon1, double llat2, double l
 bool intersect(const Prepared_Segment& segment_a,
                const Prepared_Segment& segment_b)
 {
-  std::vector< double > intersection_pt = cross_prod(segment_a.norm, segment_b.norm);
+  Cartesian intersection_pt = cross_prod(segment_a.norm, segment_b.norm);
   rescale(1.0/sqrt(scalar_prod(intersection_pt, intersection_pt)), intersection_pt);
 
-  std::vector< double > asum = sum(segment_a.first_cartesian, segment_a.second_cartesian);
-  std::vector< double > bsum = sum(segment_b.first_cartesian, segment_b.second_cartesian);
+  Cartesian asum = sum(segment_a.first_cartesian, segment_a.second_cartesian);
+  Cartesian bsum = sum(segment_b.first_cartesian, segment_b.second_cartesian);
 
   return (std::abs(scalar_prod(asum, intersection_pt)) >= scalar_prod(asum, segment_a.first_cartesian)
       && std::abs(scalar_prod(bsum, intersection_pt)) >= scalar_prod(bsum, segment_b.first_cartesian));
@@ -789,24 +909,80 @@ bool intersect(const Prepared_Segment& segment_a,
 bool intersect(double alat1, double alon1, double alat2, double alon2,
 	       double blat1, double blon1, double blat2, double blon2)
 {
-  std::vector< double > a1 = cartesian(alat1, alon1);
-  std::vector< double > a2 = cartesian(alat2, alon2);
-  std::vector< double > norm_a = cross_prod(a1, a2);
-  std::vector< double > b1 = cartesian(blat1, blon1);
-  std::vector< double > b2 = cartesian(blat2, blon2);
-  std::vector< double > norm_b = cross_prod(b1, b2);
-
-  std::vector< double > intersection_pt = cross_prod(norm_a, norm_b);
+  Cartesian a1 = cartesian(alat1, alon1);
+  Cartesian a2 = cartesian(alat2, alon2);
+  Cartesian norm_a = cross_prod(a1, a2);
+  Cartesian b1 = cartesian(blat1, blon1);
+  Cartesian b2 = cartesian(blat2, blon2);
+  Cartesian norm_b = cross_prod(b1, b2);
+
+  Cartesian intersection_pt = cross_prod(norm_a, norm_b);
   rescale(1.0/sqrt(scalar_prod(intersection_pt, intersection_pt)), intersection_pt);
 
-  std::vector< double > asum = sum(a1, a2);
-  std::vector< double > bsum = sum(b1, b2);
+  Cartesian asum = sum(a1, a2);
+  Cartesian bsum = sum(b1, b2);
 
   return (std::abs(scalar_prod(asum, intersection_pt)) >= scalar_prod(asum, a1)
       && std::abs(scalar_prod(bsum, intersection_pt)) >= scalar_prod(bsum, b1));
 }
 
 
+// A point that passes the test against a segment in is_inside is at most twice the radius
+// away from the segment. We add a safety margin for rounding errors.
+double near_segment_dist(double radius)
+{
+  return 2.0*radius*1.01 + 1.0;
+}
+
+
+// Returns the bounding box of all points that are at most dist away from the segment
+// or an invalid bounding box if this wraps around the date line or a pole.
+Bbox_Double segment_bbox(const Prepared_Segment& segment, double dist)
+{
+  if (std::abs(segment.first_lon - segment.second_lon) > 180.0)
+    return Bbox_Double::invalid;
+
+  double south = std::min(segment.first_lat, segment.second_lat);
+  double north = std::max(segment.first_lat, segment.second_lat);
+  double west = std::min(segment.first_lon, segment.second_lon);
+  double east = std::max(segment.first_lon, segment.second_lon);
+
+  // The great circle may reach beyond the latitudes of the endpoints
+  double norm_sq = scalar_prod(segment.norm, segment.norm);
+  if (norm_sq > 0)
+  {
+    // The northernmost point of the great circle, not normalized
+    Cartesian top;
+    top[0] = 1 - segment.norm[0]*segment.norm[0]/norm_sq;
+    top[1] = -segment.norm[0]*segment.norm[1]/norm_sq;
+    top[2] = -segment.norm[0]*segment.norm[2]/norm_sq;
+    if (top[0] > 0)
+    {
+      double top_lat = asin(std::min(1.0, sqrt(top[0])))*(90.0/acos(0));
+      double from_first = scalar_prod(cross_prod(segment.first_cartesian, top), segment.norm);
+      double to_second = scalar_prod(cross_prod(top, segment.second_cartesian), segment.norm);
+      if (from_first >= 0 && to_second >= 0)
+        north = std::max(north, top_lat);
+      // The southernmost point is the antipode of the northernmost point
+      if (from_first <= 0 && to_second <= 0)
+        south = std::min(south, -top_lat);
+    }
+  }
+
+  double lat_dist = dist*(360.0/(40000.0*1000.0));
+  south -= lat_dist;
+  north += lat_dist;
+  if (south < -89.9 || north > 89.9)
+    return Bbox_Double::invalid;
+
+  double lon_dist = lat_dist/cos(std::max(-south, north)/90.0*acos(0));
+  if (lon_dist > 5.0)
+    return Bbox_Double::invalid;
+
+  return Bbox_Double(south, west - lon_dist, north, east + lon_dist);
+}
+
+
 std::set< std::pair< Uint32_Index, Uint32_Index > > Around_Statement::calc_ranges
     (const Set& input, Resource_Manager& rman) const
 {
@@ -838,7 +1014,7 @@ std::set< std::pair< Uint32_Index, Uint32_Index > > Around_Statement::calc_range
 
 
 void add_coord(double lat, double lon, double radius,
-               std::map< Uint32_Index, std::vector< Point_Double > >& radius_lat_lons,
+               std::map< Uint32_Index, std::vector< uint32 > >& radius_lat_lons,
 	       std::vector< Prepared_Point >& simple_lat_lons)
 {
   double south = lat - radius*(360.0/(40000.0*1000.0));
@@ -849,6 +1025,7 @@ void add_coord(double lat, double lon, double radius,
   double west = lon - radius*(360.0/(40000.0*1000.0))/cos(scale_lat/90.0*acos(0));
   double east = lon + radius*(360.0/(40000.0*1000.0))/cos(scale_lat/90.0*acos(0));
 
+  uint32 point_idx = simple_lat_lons.size();
   simple_lat_lons.push_back(Prepared_Point(lat, lon));
 
   std::vector< std::pair< uint32, uint32 > > uint_ranges
@@ -858,13 +1035,13 @@ void add_coord(double lat, double lon, double radius,
   {
     for (uint32 idx = Uint32_Index(it->first).val();
         idx < Uint32_Index(it->second).val(); ++idx)
-      radius_lat_lons[idx].push_back(Point_Double(lat, lon));
+      radius_lat_lons[idx].push_back(point_idx);
   }
 }
 
 
 void add_node(Uint32_Index idx, const Node_Skeleton& node, double radius,
-              std::map< Uint32_Index, std::vector< Point_Double > >& radius_lat_lons,
+              std::map< Uint32_Index, std::vector< uint32 > >& radius_lat_lons,
               std::vector< Prepared_Point >& simple_lat_lons)
 {
   add_coord(::lat(idx.val(), node.ll_lower), ::lon(idx.val(), node.ll_lower),
@@ -873,7 +1050,7 @@ void add_node(Uint32_Index idx, const Node_Skeleton& node, double radius,
 
 
 void add_way(const std::vector< Quad_Coord >& way_geometry, double radius,
-             std::map< Uint32_Index, std::vector< Point_Double > >& radius_lat_lons,
+             std::map< Uint32_Index, std::vector< uint32 > >& radius_lat_lons,
              std::vector< Prepared_Point >& simple_lat_lons,
              std::vector< Prepared_Segment >& simple_segments)
 {
@@ -906,7 +1083,7 @@ void add_way(const std::vector< Quad_Coord >& way_geometry, double radius,
 }
 
 void add_way(const std::vector< Point_Double >& points, double radius,
-             std::map< Uint32_Index, std::vector< Point_Double > >& radius_lat_lons,
+             std::map< Uint32_Index, std::vector< uint32 > >& radius_lat_lons,
              std::vector< Prepared_Point >& simple_lat_lons,
              std::vector< Prepared_Segment >& simple_segments)
 {
@@ -1039,11 +1216,13 @@ void Around_Statement::calc_lat_lons(const Set& input, Statement& query, Resourc
   if (points.size() == 1)
   {
     add_coord(points[0].lat, points[0].lon, radius, radius_lat_lons, simple_lat_lons);
+    index_prepared_geometry();
     return;
   }
   else if (points.size() > 1)
   {
     add_way(points, radius, radius_lat_lons, simple_lat_lons, simple_segments);
+    index_prepared_geometry();
     return;
   }
 
@@ -1071,40 +1250,209 @@ void Around_Statement::calc_lat_lons(const Set& input, Statement& query, Resourc
         = relation_way_members(&query, rman, input.attic_relations);
     add_ways(way_members, Way_Geometry_Store(way_members, query, rman));
   }
+
+  index_prepared_geometry();
+}
+
+
+void Around_Statement::index_prepared_geometry()
+{
+  double near_dist = near_segment_dist(radius);
+
+  lat_lons_by_bucket.clear();
+  lat_lons_by_bucket.set_bucket_size(near_dist);
+  for (std::vector< Prepared_Point >::const_iterator it = simple_lat_lons.begin();
+      it != simple_lat_lons.end(); ++it)
+    lat_lons_by_bucket.add(Bbox_Double(it->lat, it->lon, it->lat, it->lon));
+
+  segments_by_bucket.clear();
+  segments_by_bucket.set_bucket_size(near_dist);
+  for (std::vector< Prepared_Segment >::const_iterator it = simple_segments.begin();
+      it != simple_segments.end(); ++it)
+    segments_by_bucket.add(segment_bbox(*it, near_dist));
+}
+
+
+bool is_near_point(const Prepared_Point& point, double radius, double lat, double lon)
+{
+  return (radius > 0 && great_circle_dist(point.lat, point.lon, lat, lon) <= radius)
+      || (std::abs(point.lat - lat) < 1e-7 && std::abs(point.lon - lon) < 1e-7);
+}
+
+
+bool is_near_segment(const Prepared_Segment& segment, double radius,
+    double lat, double lon, const Cartesian& coord_cartesian)
+{
+  if (great_circle_line_dist(segment, coord_cartesian) <= radius)
+  {
+    double gcdist = great_circle_dist
+        (segment.first_lat, segment.first_lon, segment.second_lat, segment.second_lon);
+    double limit = sqrt(gcdist*gcdist + radius*radius);
+    if (great_circle_dist(lat, lon, segment.first_lat, segment.first_lon) <= limit &&
+        great_circle_dist(lat, lon, segment.second_lat, segment.second_lon) <= limit)
+      return true;
+  }
+  return false;
+}
+
+
+bool Around_Statement::is_near_segment(double lat, double lon, const Cartesian& coord_cartesian,
+    const std::vector< uint32 >& segment_idxs) const
+{
+  for (std::vector< uint32 >::const_iterator it = segment_idxs.begin(); it != segment_idxs.end(); ++it)
+  {
+    if (::is_near_segment(simple_segments[*it], radius, lat, lon, coord_cartesian))
+      return true;
+  }
+
+  return false;
 }
 
 
 bool Around_Statement::is_inside(double lat, double lon) const
 {
-  std::map< Uint32_Index, std::vector< Point_Double > >::const_iterator mit
+  std::map< Uint32_Index, std::vector< uint32 > >::const_iterator mit
       = radius_lat_lons.find(::ll_upper_(lat, lon));
   if (mit != radius_lat_lons.end())
   {
-    for (std::vector< Point_Double >::const_iterator cit = mit->second.begin();
+    for (std::vector< uint32 >::const_iterator cit = mit->second.begin();
         cit != mit->second.end(); ++cit)
     {
-      if ((radius > 0 && great_circle_dist(cit->lat, cit->lon, lat, lon) <= radius)
-          || (std::abs(cit->lat - lat) < 1e-7 && std::abs(cit->lon - lon) < 1e-7))
+      if (is_near_point(simple_lat_lons[*cit], radius, lat, lon))
         return true;
     }
   }
 
-  std::vector< double > coord_cartesian = cartesian(lat, lon);
-  for (std::vector< Prepared_Segment >::const_iterator
-      it = simple_segments.begin(); it != simple_segments.end(); ++it)
+  Cartesian coord_cartesian = cartesian(lat, lon);
+  const std::vector< uint32 >* segment_idxs = segments_by_bucket.bucket(lat, lon);
+  return (segment_idxs && is_near_segment(lat, lon, coord_cartesian, *segment_idxs))
+      || is_near_segment(lat, lon, coord_cartesian, segments_by_bucket.everywhere());
+}
+
+
+// The batched kernels only compute scalar products over the arrays of the candidates,
+// hence the compiler can vectorize them. They mark a superset of the candidates that pass
+// the exact tests. The margin in meters covers the rounding errors of both.
+const double KERNEL_MARGIN = 2.0;
+
+
+// Marks the candidates whose scalar product with the point is at least min_prod
+void mark_near_point(const Cartesian& point, double min_prod,
+    Around_Candidates& candidates, uint32 begin, uint32 end)
+{
+  const double px = point[0];
+  const double py = point[1];
+  const double pz = point[2];
+  const double* x = &candidates.x[0];
+  const double* y = &candidates.y[0];
+  const double* z = &candidates.z[0];
+  uint8* maybe = &candidates.maybe[0];
+
+  for (uint32 i = begin; i < end; ++i)
+    maybe[i] = (px*x[i] + py*y[i] + pz*z[i] >= min_prod);
+}
+
+
+// Marks the candidates whose scalar product with the normal vector is at most max_prod in absolute value
+void mark_near_line(const Cartesian& norm, double max_prod,
+    Around_Candidates& candidates, uint32 begin, uint32 end)
+{
+  const double nx = norm[0];
+  const double ny = norm[1];
+  const double nz = norm[2];
+  const double* x = &candidates.x[0];
+  const double* y = &candidates.y[0];
+  const double* z = &candidates.z[0];
+  uint8* maybe = &candidates.maybe[0];
+
+  for (uint32 i = begin; i < end; ++i)
+    maybe[i] = (std::abs(nx*x[i] + ny*y[i] + nz*z[i]) <= max_prod);
+}
+
+
+// The cosine of the angle that corresponds to the radius plus the margin
+double kernel_point_min_prod(double radius)
+{
+  double arc = (radius + KERNEL_MARGIN)*(acos(0)/(10*1000*1000));
+  return arc < 2*acos(0) ? cos(arc) - 1e-15 : -2.0;
+}
+
+
+// The sine of the angle that corresponds to the radius plus the margin
+double kernel_line_factor(double radius)
+{
+  double arc = (radius + KERNEL_MARGIN)*(acos(0)/(10*1000*1000));
+  return arc < acos(0) ? sin(arc) + 1e-15 : 2.0;
+}
+
+
+void Around_Statement::mark_near_segments(const std::vector< uint32 >& segment_idxs,
+    Around_Candidates& candidates, uint32 begin, uint32 end) const
+{
+  double line_factor = kernel_line_factor(radius);
+  for (std::vector< uint32 >::const_iterator it = segment_idxs.begin(); it != segment_idxs.end(); ++it)
   {
-    if (great_circle_line_dist(*it, coord_cartesian) <= radius)
+    const Prepared_Segment& segment = simple_segments[*it];
+    mark_near_line(segment.norm, line_factor*sqrt(scalar_prod(segment.norm, segment.norm)),
+        candidates, begin, end);
+    for (uint32 i = begin; i < end; ++i)
     {
-      double gcdist = great_circle_dist
-          (it->first_lat, it->first_lon, it->second_lat, it->second_lon);
-      double limit = sqrt(gcdist*gcdist + radius*radius);
-      if (great_circle_dist(lat, lon, it->first_lat, it->first_lon) <= limit &&
-          great_circle_dist(lat, lon, it->second_lat, it->second_lon) <= limit)
-	return true;
+      if (candidates.maybe[i] && !candidates.inside[i])
+      {
+        Cartesian coord_cartesian;
+        coord_cartesian[0] = candidates.x[i];
+        coord_cartesian[1] = candidates.y[i];
+        coord_cartesian[2] = candidates.z[i];
+        if (::is_near_segment(segment, radius, candidates.lat[i], candidates.lon[i], coord_cartesian))
+          candidates.inside[i] = 1;
+      }
     }
   }
+}
 
-  return false;
+
+void Around_Statement::is_inside(Around_Candidates& candidates) const
+{
+  uint32 size = candidates.size();
+  candidates.inside.assign(size, 0);
+  candidates.maybe.resize(size);
+
+  double min_prod = kernel_point_min_prod(radius);
+
+  uint32 begin = 0;
+  while (begin < size)
+  {
+    // Candidates in the same quadtile share the relevant points and segments
+    uint32 end = begin + 1;
+    while (end < size && candidates.ll_upper[end] == candidates.ll_upper[begin])
+      ++end;
+
+    std::map< Uint32_Index, std::vector< uint32 > >::const_iterator mit
+        = radius_lat_lons.find(Uint32_Index(candidates.ll_upper[begin]));
+    if (mit != radius_lat_lons.end())
+    {
+      for (std::vector< uint32 >::const_iterator cit = mit->second.begin();
+          cit != mit->second.end(); ++cit)
+      {
+        const Prepared_Point& point = simple_lat_lons[*cit];
+        mark_near_point(point.cartesian, min_prod, candidates, begin, end);
+        for (uint32 i = begin; i < end; ++i)
+        {
+          if (candidates.maybe[i] && !candidates.inside[i]
+              && is_near_point(point, radius, candidates.lat[i], candidates.lon[i]))
+            candidates.inside[i] = 1;
+        }
+      }
+    }
+
+    const std::vector< uint32 >* segment_idxs
+        = segments_by_bucket.bucket(candidates.lat[begin], candidates.lon[begin]);
+    if (segment_idxs)
+      mark_near_segments(*segment_idxs, candidates, begin, end);
+    mark_near_segments(segments_by_bucket.everywhere(), candidates, begin, end);
+
+    begin = end;
+  }
 }
 
 bool Around_Statement::is_inside
@@ -1112,9 +1460,11 @@ bool Around_Statement::is_inside
 {
   Prepared_Segment segment(first_lat, first_lon, second_lat, second_lon);
 
-  for (std::vector< Prepared_Point >::const_iterator cit = simple_lat_lons.begin();
-      cit != simple_lat_lons.end(); ++cit)
+  std::vector< uint32 > candidates;
+  lat_lons_by_bucket.collect(segment_bbox(segment, near_segment_dist(radius)), candidates);
+  for (std::vector< uint32 >::const_iterator it = candidates.begin(); it != candidates.end(); ++it)
   {
+    const Prepared_Point* cit = &simple_lat_lons[*it];
     if (great_circle_line_dist(segment, cit->cartesian) <= radius)
     {
       double gcdist = great_circle_dist(first_lat, first_lon, second_lat, second_lon);
@@ -1125,10 +1475,11 @@ bool Around_Statement::is_inside
     }
   }
 
-  for (std::vector< Prepared_Segment >::const_iterator
-      cit = simple_segments.begin(); cit != simple_segments.end(); ++cit)
+  // Intersecting segments have a common point, hence their bounding boxes intersect
+  segments_by_bucket.collect(segment_bbox(segment, 0), candidates);
+  for (std::vector< uint32 >::const_iterator it = candidates.begin(); it != candidates.end(); ++it)
   {
-    if (intersect(*cit, segment))
+    if (intersect(simple_segments[*it], segment))
       return true;
   }
 
@@ -1136,21 +1487,20 @@ bool Around_Statement::is_inside
 }
 
 
-bool Around_Statement::is_inside(const std::vector< Quad_Coord >& way_geometry) const
+bool Around_Statement::is_inside
+    (const std::vector< Quad_Coord >& way_geometry, Around_Candidates& candidates) const
 {
   std::vector< Quad_Coord >::const_iterator nit = way_geometry.begin();
   if (nit == way_geometry.end())
     return false;
 
   // Pre-check if a node is inside
+  candidates.clear();
   for (std::vector< Quad_Coord >::const_iterator it = way_geometry.begin(); it != way_geometry.end(); ++it)
-  {
-    double second_lat(::lat(it->ll_upper, it->ll_lower));
-    double second_lon(::lon(it->ll_upper, it->ll_lower));
-
-    if (is_inside(second_lat, second_lon))
-      return true;
-  }
+    candidates.push_back(::lat(it->ll_upper, it->ll_lower), ::lon(it->ll_upper, it->ll_lower));
+  is_inside(candidates);
+  if (std::find(candidates.inside.begin(), candidates.inside.end(), 1) != candidates.inside.end())
+    return true;
 
   double first_lat(::lat(nit->ll_upper, nit->ll_lower));
   double first_lon(::lon(nit->ll_upper, nit->ll_lower));
@@ -23,21 +23,33 @@
 #include <set>
 #include <string>
 #include <vector>
+#include "../core/geometry.h"
 #include "../data/collect_members.h"
 #include "../data/utils.h"
 #include "../data/way_geometry_store.h"
 #include "statement.h"
 
 
+/* A vector in three-dimensional cartesian coordinates.
+ * It is a plain value such that the geometric helpers do not allocate memory. */
+struct Cartesian
+{
+  double coord[3];
+
+  double& operator[](uint i) { return coord[i]; }
+  double operator[](uint i) const { return coord[i]; }
+};
+
+
 struct Prepared_Segment
 {
   double first_lat;
   double first_lon;
   double second_lat;
   double second_lon;
-  std::vector< double > first_cartesian;
-  std::vector< double > second_cartesian;
-  std::vector< double > norm;
+  Cartesian first_cartesian;
+  Cartesian second_cartesian;
+  Cartesian norm;
 
   Prepared_Segment(double first_lat, double first_lon, double second_lat, double second_lon);
 };
@@ -47,12 +59,66 @@ struct Prepared_Point
 {
   double lat;
   double lon;
-  std::vector< double > cartesian;
+  Cartesian cartesian;
 
   Prepared_Point(double lat, double lon);
 };
 
 
+/* Assigns prepared points or segments to buckets of coarse quadtiles.
+ * Items are numbered in the order they are added.
+ * An item with an invalid bounding box is relevant for all buckets. */
+class Prepared_Bucket_Index
+{
+  public:
+    Prepared_Bucket_Index() : shift(16), size(0) {}
+
+    void clear();
+    // Chooses buckets that are at least that large in both directions
+    void set_bucket_size(double meters);
+    void add(const Bbox_Double& bbox);
+
+    // The items of the bucket that contains the point, 0 if there are none
+    const std::vector< uint32 >* bucket(double lat, double lon) const;
+    const std::vector< uint32 >& everywhere() const { return everywhere_; }
+
+    // The sorted items whose bounding boxes may intersect bbox, all items if bbox is invalid
+    void collect(const Bbox_Double& bbox, std::vector< uint32 >& result) const;
+
+  private:
+    uint32 shift;
+    uint32 size;
+    std::map< Uint32_Index, std::vector< uint32 > > buckets;
+    std::vector< uint32 > everywhere_;
+
+    bool calc_buckets(const Bbox_Double& bbox, std::vector< Uint32_Index >& result) const;
+};
+
+
+/* Points to test against the around geometry in a batch. The coordinates are kept
+ * as structure of arrays such that the tests can run over contiguous arrays.
+ * The object should be reused between batches to keep the allocated memory. */
+struct Around_Candidates
+{
+  std::vector< double > lat;
+  std::vector< double > lon;
+  std::vector< uint32 > ll_upper;
+  // The cartesian coordinates of the points
+  std::vector< double > x;
+  std::vector< double > y;
+  std::vector< double > z;
+
+  // Set by Around_Statement::is_inside, nonzero for the points inside
+  std::vector< uint8 > inside;
+  // Scratch space for the tests
+  std::vector< uint8 > maybe;
+
+  void clear();
+  void push_back(double lat, double lon);
+  uint32 size() const { return lat.size(); }
+};
+
+
 class Around_Statement : public Output_Statement
 {
   public:
@@ -89,7 +155,9 @@ class Around_Statement : public Output_Statement
 
     bool is_inside(double lat, double lon) const;
     bool is_inside(double first_lat, double first_lon, double second_lat, double second_lon) const;
-    bool is_inside(const std::vector< Quad_Coord >& way_geometry) const;
+    bool is_inside(const std::vector< Quad_Coord >& way_geometry, Around_Candidates& candidates) const;
+    // Sets candidates.inside for all candidates at once
+    void is_inside(Around_Candidates& candidates) const;
 
     double get_radius() const { return radius; }
 
@@ -138,10 +206,19 @@ class Around_Statement : public Output_Statement
     double radius;
     std::vector< Point_Double > points;
 
-    std::map< Uint32_Index, std::vector< Point_Double > > radius_lat_lons;
+    // Indices into simple_lat_lons by the quadtiles they are relevant for
+    std::map< Uint32_Index, std::vector< uint32 > > radius_lat_lons;
     std::vector< Prepared_Point > simple_lat_lons;
     std::vector< Prepared_Segment > simple_segments;
+    Prepared_Bucket_Index lat_lons_by_bucket;
+    Prepared_Bucket_Index segments_by_bucket;
     std::vector< Query_Constraint* > constraints;
+
+    void index_prepared_geometry();
+    bool is_near_segment(double lat, double lon, const Cartesian& coord_cartesian,
+        const std::vector< uint32 >& segment_idxs) const;
+    void mark_near_segments(const std::vector< uint32 >& segment_idxs,
+        Around_Candidates& candidates, uint32 begin, uint32 end) const;
 };
 
 #endif
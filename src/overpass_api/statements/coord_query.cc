@@ -113,73 +113,82 @@ int Coord_Query_Statement::check_area_block
     lon = ::ilon(ll_index | (((*it)>>32)&0xff), (*it & 0xffffffff));
     lat = ::ilat(ll_index | (((*it)>>32)&0xff), (*it & 0xffffffff));
 
-    if (last_lon < lon)
+    int check = check_segment(last_lat, last_lon, lat, lon, coord_lat, coord_lon);
+    if (check == HIT)
+      return HIT;
+    state ^= check;
+  }
+  return state;
+}
+
+
+// Returns the contribution of a single segment from (last_lat, last_lon) to (lat, lon)
+// to the result of check_area_block.
+int Coord_Query_Statement::check_segment
+    (uint32 last_lat, int32 last_lon, uint32 lat, int32 lon,
+     uint32 coord_lat, int32 coord_lon)
+{
+  if (last_lon < lon)
+  {
+    if (lon < coord_lon)
+      return 0; // case (1)
+    else if (last_lon > coord_lon)
+      return 0; // case (1)
+    else if (lon == coord_lon)
     {
-      if (lon < coord_lon)
-	continue; // case (1)
-      else if (last_lon > coord_lon)
-	continue; // case (1)
-      else if (lon == coord_lon)
-      {
-	if (lat < coord_lat)
-	  state ^= TOGGLE_WEST; // case (4)
-	else if (lat == coord_lat)
-	  return HIT; // case (2)
-	// else: case (1)
-	continue;
-      }
-      else if (last_lon == coord_lon)
-      {
-	if (last_lat < coord_lat)
-	  state ^= TOGGLE_EAST; // case (4)
-	else if (last_lat == coord_lat)
-	  return HIT; // case (2)
-	// else: case (1)
-	continue;
-      }
+      if (lat < coord_lat)
+        return TOGGLE_WEST; // case (4)
+      else if (lat == coord_lat)
+        return HIT; // case (2)
+      return 0; // else: case (1)
     }
-    else if (last_lon > lon)
+    else if (last_lon == coord_lon)
     {
-      if (lon > coord_lon)
-	continue; // case (1)
-      else if (last_lon < coord_lon)
-	continue; // case (1)
-      else if (lon == coord_lon)
-      {
-	if (lat < coord_lat)
-	  state ^= TOGGLE_EAST; // case (4)
-	else if (lat == coord_lat)
-	  return HIT; // case (2)
-	// else: case (1)
-	continue;
-      }
-      else if (last_lon == coord_lon)
-      {
-	if (last_lat < coord_lat)
-	  state ^= TOGGLE_WEST; // case (4)
-	else if (last_lat == coord_lat)
-	  return HIT; // case (2)
-	// else: case (1)
-	continue;
-      }
+      if (last_lat < coord_lat)
+        return TOGGLE_EAST; // case (4)
+      else if (last_lat == coord_lat)
+        return HIT; // case (2)
+      return 0; // else: case (1)
     }
-    else // last_lon == lon
+  }
+  else if (last_lon > lon)
+  {
+    if (lon > coord_lon)
+      return 0; // case (1)
+    else if (last_lon < coord_lon)
+      return 0; // case (1)
+    else if (lon == coord_lon)
     {
-      if (lon == coord_lon &&
-          ((last_lat <= coord_lat && coord_lat <= lat) || (lat <= coord_lat && coord_lat <= last_lat)))
+      if (lat < coord_lat)
+        return TOGGLE_EAST; // case (4)
+      else if (lat == coord_lat)
         return HIT; // case (2)
-      continue; // else: case (1)
+      return 0; // else: case (1)
     }
-
-    uint32 intersect_lat = lat +
-        ((int64)coord_lon - lon)*((int64)last_lat - lat)/((int64)last_lon - lon);
-    if (coord_lat > intersect_lat)
-      state ^= (TOGGLE_EAST | TOGGLE_WEST); // case (3)
-    else if (coord_lat == intersect_lat)
+    else if (last_lon == coord_lon)
+    {
+      if (last_lat < coord_lat)
+        return TOGGLE_WEST; // case (4)
+      else if (last_lat == coord_lat)
+        return HIT; // case (2)
+      return 0; // else: case (1)
+    }
+  }
+  else // last_lon == lon
+  {
+    if (lon == coord_lon &&
+        ((last_lat <= coord_lat && coord_lat <= lat) || (lat <= coord_lat && coord_lat <= last_lat)))
       return HIT; // case (2)
-    // else: case (1)
+    return 0; // else: case (1)
   }
-  return state;
+
+  uint32 intersect_lat = lat +
+      ((int64)coord_lon - lon)*((int64)last_lat - lat)/((int64)last_lon - lon);
+  if (coord_lat > intersect_lat)
+    return (TOGGLE_EAST | TOGGLE_WEST); // case (3)
+  else if (coord_lat == intersect_lat)
+    return HIT; // case (2)
+  return 0; // else: case (1)
 }
 
 
@@ -37,7 +37,7 @@ class Coord_Query_Statement : public Output_Statement
     static Generic_Statement_Maker< Coord_Query_Statement > statement_maker;
 
     static int check_segment
-        (uint32 a_lat, int32 a_lon, uint32 b_lat, int32 b_lon,
+        (uint32 last_lat, int32 last_lon, uint32 lat, int32 lon,
          uint32 coord_lat, int32 coord_lon);
     //static uint32 shifted_lat(uint32 ll_index, uint64 coord);
     //static int32 lon_(uint32 ll_index, uint64 coord);
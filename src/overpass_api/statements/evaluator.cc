@@ -429,7 +429,7 @@ Element_With_Context< Derived_Skeleton > Set_With_Context::get_context(
 
 Prepare_Task_Context::Prepare_Task_Context(
     const Requested_Context& requested, const Statement& stmt, Resource_Manager& rman)
-    : contexts(requested.set_usage.size()), relation_member_roles_(0), users(0)
+    : contexts(requested.set_usage.size()), relation_member_roles_(0), user_names_rman(0)
 {
   for (std::vector< Set_Usage >::const_iterator it = requested.set_usage.begin(); it != requested.set_usage.end(); ++it)
   {
@@ -448,7 +448,7 @@ Prepare_Task_Context::Prepare_Task_Context(
     relation_member_roles_ = &relation_member_roles(*rman.get_transaction());
 
   if (requested.user_names_requested)
-    users = &rman.users();
+    user_names_rman = &rman;
 }
 
 
@@ -480,10 +480,11 @@ uint32 Prepare_Task_Context::get_role_id(const std::string& role) const
 
 const std::string* Prepare_Task_Context::get_user_name(uint32 user_id) const
 {
-  if (!users)
+  if (!user_names_rman)
     return 0;
-  std::map< uint32, std::string >::const_iterator it = users->find(user_id);
-  if (it == users->end())
+  const std::map< uint32, std::string >& users = user_names_rman->users(user_id);
+  std::map< uint32, std::string >::const_iterator it = users.find(user_id);
+  if (it == users.end())
     return 0;
   return &it->second;
 }
@@ -185,7 +185,8 @@ struct Prepare_Task_Context
 private:
   Array< Set_With_Context > contexts;
   const std::map< uint32, std::string >* relation_member_roles_;
-  const std::map< uint32, std::string >* users;
+  // Resolves the user names on demand if they have been requested
+  Resource_Manager* user_names_rman;
 };
 
 
@@ -212,6 +213,107 @@ They only make sense in the context of a single element.
 */
 
 
+/* The value of an evaluator. All evaluators are specified in terms of strings,
+ * but numbers computed by the operators keep their binary representation
+ * such that nested arithmetic need not convert them to and from strings.
+ * The accessors behave precisely like try_int64, try_double and string_represents_boolean_true
+ * applied to the string representation. Parsed numbers are remembered. */
+class Eval_Value
+{
+public:
+  Eval_Value() : type(string_value), int_state(invalid), double_state(invalid), value_l(0), value_d(0) {}
+  Eval_Value(const std::string& value_s_)
+      : type(string_value), int_state(unknown), double_state(unknown), value_l(0), value_d(0), value_s(value_s_) {}
+
+  static Eval_Value from_int64(int64 value);
+  static Eval_Value from_double(double value);
+  static Eval_Value from_bool(bool value) { return from_int64(value ? 1 : 0); }
+
+  bool as_int64(int64& result) const;
+  bool as_double(double& result) const;
+  bool is_true() const;
+  std::string as_string() const;
+
+private:
+  enum Type { string_value, int64_value, double_value };
+  enum State { unknown, valid, invalid };
+
+  Type type;
+  mutable State int_state;
+  mutable State double_state;
+  mutable int64 value_l;
+  mutable double value_d;
+  std::string value_s;
+};
+
+
+inline Eval_Value Eval_Value::from_int64(int64 value)
+{
+  Eval_Value result;
+  result.type = int64_value;
+  result.int_state = valid;
+  result.value_l = value;
+  result.double_state = valid;
+  result.value_d = value;
+  return result;
+}
+
+
+inline Eval_Value Eval_Value::from_double(double value)
+{
+  // The string representation has 14 significant digits.
+  // Only integers below that are not changed by the roundtrip through the string.
+  if (value < 1e14 && value > -1e14 && value == (double)(int64)value)
+  {
+    Eval_Value result;
+    result.type = double_value;
+    result.int_state = valid;
+    result.value_l = (int64)value;
+    result.double_state = valid;
+    result.value_d = value;
+    return result;
+  }
+  return Eval_Value(to_string(value));
+}
+
+
+inline bool Eval_Value::as_int64(int64& result) const
+{
+  if (int_state == unknown)
+    int_state = try_int64(value_s, value_l) ? valid : invalid;
+  result = value_l;
+  return int_state == valid;
+}
+
+
+inline bool Eval_Value::as_double(double& result) const
+{
+  if (double_state == unknown)
+    double_state = try_double(value_s, value_d) ? valid : invalid;
+  result = value_d;
+  return double_state == valid;
+}
+
+
+inline bool Eval_Value::is_true() const
+{
+  double val_d = 0;
+  if (as_double(val_d))
+    return val_d != 0;
+  return !value_s.empty();
+}
+
+
+inline std::string Eval_Value::as_string() const
+{
+  if (type == int64_value)
+    return to_string(value_l);
+  else if (type == double_value)
+    return to_string(value_d);
+  return value_s;
+}
+
+
 struct Eval_Task
 {
   virtual ~Eval_Task() {}
@@ -234,17 +336,66 @@ struct Eval_Task
       { return eval(key); }
   virtual std::string eval(const Element_With_Context< Derived_Skeleton >& data, const std::string* key) const
       { return eval(key); }
+
+  // Operators use these to pass on numbers without converting them to strings
+  virtual Eval_Value eval_value(const std::string* key) const { return Eval_Value(eval(key)); }
+
+  virtual Eval_Value eval_value(const Element_With_Context< Node_Skeleton >& data, const std::string* key) const
+      { return Eval_Value(eval(data, key)); }
+  virtual Eval_Value eval_value(const Element_With_Context< Attic< Node_Skeleton > >& data, const std::string* key) const
+      { return Eval_Value(eval(data, key)); }
+  virtual Eval_Value eval_value(const Element_With_Context< Way_Skeleton >& data, const std::string* key) const
+      { return Eval_Value(eval(data, key)); }
+  virtual Eval_Value eval_value(const Element_With_Context< Attic< Way_Skeleton > >& data, const std::string* key) const
+      { return Eval_Value(eval(data, key)); }
+  virtual Eval_Value eval_value(const Element_With_Context< Relation_Skeleton >& data, const std::string* key) const
+      { return Eval_Value(eval(data, key)); }
+  virtual Eval_Value eval_value(const Element_With_Context< Attic< Relation_Skeleton > >& data, const std::string* key) const
+      { return Eval_Value(eval(data, key)); }
+  virtual Eval_Value eval_value(const Element_With_Context< Area_Skeleton >& data, const std::string* key) const
+      { return Eval_Value(eval(data, key)); }
+  virtual Eval_Value eval_value(const Element_With_Context< Derived_Skeleton >& data, const std::string* key) const
+      { return Eval_Value(eval(data, key)); }
 };
 
 
 struct Const_Eval_Task : public Eval_Task
 {
-  Const_Eval_Task(const std::string& value_) : value(value_) {}
-
-  virtual std::string eval(const std::string* key) const { return value; }
+  Const_Eval_Task(const std::string& value_s_) : value(value_s_), value_s(value_s_) { prepare(); }
+  Const_Eval_Task(const Eval_Value& value_) : value(value_), value_s(value_.as_string()) { prepare(); }
+
+  virtual std::string eval(const std::string* key) const { return value_s; }
+  virtual Eval_Value eval_value(const std::string* key) const { return value; }
+
+  virtual Eval_Value eval_value(const Element_With_Context< Node_Skeleton >& data, const std::string* key) const
+      { return value; }
+  virtual Eval_Value eval_value(const Element_With_Context< Attic< Node_Skeleton > >& data, const std::string* key) const
+      { return value; }
+  virtual Eval_Value eval_value(const Element_With_Context< Way_Skeleton >& data, const std::string* key) const
+      { return value; }
+  virtual Eval_Value eval_value(const Element_With_Context< Attic< Way_Skeleton > >& data, const std::string* key) const
+      { return value; }
+  virtual Eval_Value eval_value(const Element_With_Context< Relation_Skeleton >& data, const std::string* key) const
+      { return value; }
+  virtual Eval_Value eval_value(const Element_With_Context< Attic< Relation_Skeleton > >& data, const std::string* key) const
+      { return value; }
+  virtual Eval_Value eval_value(const Element_With_Context< Area_Skeleton >& data, const std::string* key) const
+      { return value; }
+  virtual Eval_Value eval_value(const Element_With_Context< Derived_Skeleton >& data, const std::string* key) const
+      { return value; }
 
 private:
-  std::string value;
+  Eval_Value value;
+  std::string value_s;
+
+  // Parse the value once here instead of once per evaluated element
+  void prepare()
+  {
+    int64 value_l = 0;
+    double value_d = 0;
+    value.as_int64(value_l);
+    value.as_double(value_d);
+  }
 };
 
 
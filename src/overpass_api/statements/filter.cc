@@ -54,8 +54,7 @@ void eval_elems(std::map< Index, std::vector< Maybe_Attic > >& items,
     for (typename std::vector< Maybe_Attic >::const_iterator it_elem = it_idx->second.begin();
         it_elem != it_idx->second.end(); ++it_elem)
     {
-      if (string_represents_boolean_true(
-          task.eval(into_context.get_context(it_idx->first, *it_elem), 0)))
+      if (task.eval_value(into_context.get_context(it_idx->first, *it_elem), 0).is_true())
         local_into.push_back(*it_elem);
     }
 
@@ -34,7 +34,7 @@ Osm_Script_Statement::Osm_Script_Statement
     (int line_number_, const std::map< std::string, std::string >& input_attributes, Parsed_Query& global_settings)
     : Statement(line_number_),
        desired_timestamp(NOW), comparison_timestamp(0), add_deletion_information(false),
-       max_allowed_time(0), max_allowed_space(0),
+       max_allowed_time(0), max_allowed_space(0), max_parallel_threads(1),
        factory(0)
 {
   std::map< std::string, std::string > attributes;
@@ -42,6 +42,7 @@ Osm_Script_Statement::Osm_Script_Statement
   attributes["bbox"] = "";
   attributes["timeout"] = "180";
   attributes["element-limit"] = "536870912";
+  attributes["parallel"] = "1";
   attributes["output"] = "xml";
   attributes["output-config"] = "";
   attributes["date"] = "";
@@ -67,6 +68,13 @@ Osm_Script_Statement::Osm_Script_Statement
 
   max_allowed_space = max_space;
 
+  int32 parallel(atoi(attributes["parallel"].c_str()));
+  if (parallel <= 0 || parallel > 64)
+    add_static_error("For the attribute \"parallel\" of the element \"osm-script\""
+        " the only allowed values are integers from 1 to 64.");
+  else
+    max_parallel_threads = parallel;
+
 
   if (!global_settings.get_output_handler())
   {
@@ -207,6 +215,7 @@ void Osm_Script_Statement::add_statement(Statement* statement, std::string text)
 void Osm_Script_Statement::execute(Resource_Manager& rman)
 {
   rman.set_limits(max_allowed_time, max_allowed_space);
+  rman.set_max_parallel_threads(max_parallel_threads);
   rman.get_global_settings().trigger_print_bounds();
 
   if (comparison_timestamp > 0)
@@ -44,6 +44,7 @@ class Osm_Script_Statement : public Statement
 
     uint32 get_max_allowed_time() const { return max_allowed_time; }
     uint64 get_max_allowed_space() const { return max_allowed_space; }
+    uint32 get_max_parallel_threads() const { return max_parallel_threads; }
     uint64 get_desired_timestamp() const { return desired_timestamp; }
 
   private:
@@ -53,6 +54,7 @@ class Osm_Script_Statement : public Statement
     bool add_deletion_information;
     uint32 max_allowed_time;
     uint64 max_allowed_space;
+    uint32 max_parallel_threads;
     Statement::Factory* factory;
 };
 
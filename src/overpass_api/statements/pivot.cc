@@ -62,8 +62,8 @@ void collect_elems(Resource_Manager& rman, const File_Properties& prop,
       it(elems_db.discrete_begin(req.begin(), req.end()));
       !(it == elems_db.discrete_end()); ++it)
   {
-    if (binary_search(ids.begin(), ids.end(), it.object().id))
-      elems[it.index()].push_back(it.object());
+    if (binary_search(ids.begin(), ids.end(), it.handle().id()))
+      it.handle().push_back_to(elems[it.index()]);
   }
 }
 
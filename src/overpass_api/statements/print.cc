@@ -197,7 +197,10 @@ struct Extra_Data
       double south, double north, double west, double east);
   ~Extra_Data();
 
-  const std::map< uint32, std::string >* get_users() const;
+  // Returns 0 if no metadata is printed. Otherwise the map contains at least the user of meta.
+  template< typename Id_Type >
+  const std::map< uint32, std::string >* get_users(const OSM_Element_Metadata_Skeleton< Id_Type >* meta) const
+  { return meta && rman ? &rman->users(meta->user_id) : 0; }
 
   unsigned int mode;
   Output_Handler::Feature_Action action;
@@ -206,7 +209,7 @@ struct Extra_Data
   Relation_Geometry_Store* relation_geometry_store;
   Relation_Geometry_Store* attic_relation_geometry_store;
   const std::map< uint32, std::string >* roles;
-  const std::map< uint32, std::string >* users;
+  Resource_Manager* rman;
 };
 
 
@@ -215,7 +218,7 @@ Extra_Data::Extra_Data(
     unsigned int mode_, Output_Handler::Feature_Action action_,
     double south, double north, double west, double east)
     : mode(mode_), action(action_), way_geometry_store(0), attic_way_geometry_store(0),
-    relation_geometry_store(0), attic_relation_geometry_store(0), roles(0), users(0)
+    relation_geometry_store(0), attic_relation_geometry_store(0), roles(0), rman(0)
 {
   if (mode & (Output_Mode::GEOMETRY | Output_Mode::BOUNDS | Output_Mode::CENTER))
   {
@@ -240,13 +243,7 @@ Extra_Data::Extra_Data(
   roles = &relation_member_roles(*rman.get_transaction());
 
   if (mode & Output_Mode::META)
-    users = &rman.users();
-}
-
-
-const std::map< uint32, std::string >* Extra_Data::get_users() const
-{
-  return users;
+    this->rman = &rman;
 }
 
 
@@ -264,7 +261,7 @@ void print_item(Extra_Data& extra_data, Output_Handler& output, uint32 ll_upper,
                     const OSM_Element_Metadata_Skeleton< Node_Skeleton::Id_Type >* meta = 0)
 {
   output.print_item(skel, Point_Geometry(::lat(ll_upper, skel.ll_lower), ::lon(ll_upper, skel.ll_lower)),
-      tags, meta, extra_data.get_users(), Output_Mode(extra_data.mode), extra_data.action);
+      tags, meta, extra_data.get_users(meta), Output_Mode(extra_data.mode), extra_data.action);
 }
 
 
@@ -275,7 +272,7 @@ void print_item(Extra_Data& extra_data, Output_Handler& output, uint32 ll_upper,
   Geometry_From_Quad_Coords broker;
   output.print_item(skel,
       broker.make_way_geom(skel, extra_data.mode, extra_data.way_geometry_store),
-      tags, meta, extra_data.get_users(), Output_Mode(extra_data.mode), extra_data.action);
+      tags, meta, extra_data.get_users(meta), Output_Mode(extra_data.mode), extra_data.action);
 }
 
 
@@ -286,7 +283,7 @@ void print_item(Extra_Data& extra_data, Output_Handler& output, uint32 ll_upper,
   Geometry_From_Quad_Coords broker;
   output.print_item(skel,
       broker.make_way_geom(skel, extra_data.mode, extra_data.attic_way_geometry_store),
-      tags, meta, extra_data.get_users(), Output_Mode(extra_data.mode), extra_data.action);
+      tags, meta, extra_data.get_users(meta), Output_Mode(extra_data.mode), extra_data.action);
 }
 
 
@@ -297,7 +294,7 @@ void print_item(Extra_Data& extra_data, Output_Handler& output, uint32 ll_upper,
   Geometry_From_Quad_Coords broker;
   output.print_item(skel,
       broker.make_relation_geom(skel, extra_data.mode, extra_data.relation_geometry_store),
-      tags, meta, extra_data.roles, extra_data.get_users(), Output_Mode(extra_data.mode), extra_data.action);
+      tags, meta, extra_data.roles, extra_data.get_users(meta), Output_Mode(extra_data.mode), extra_data.action);
 }
 
 
@@ -308,7 +305,7 @@ void print_item(Extra_Data& extra_data, Output_Handler& output, uint32 ll_upper,
   Geometry_From_Quad_Coords broker;
   output.print_item(skel,
       broker.make_relation_geom(skel, extra_data.mode, extra_data.attic_relation_geometry_store),
-      tags, meta, extra_data.roles, extra_data.get_users(), Output_Mode(extra_data.mode), extra_data.action);
+      tags, meta, extra_data.roles, extra_data.get_users(meta), Output_Mode(extra_data.mode), extra_data.action);
 }
 
 
@@ -916,7 +913,7 @@ void Print_Statement::execute_comparison(Resource_Manager& rman)
   if (input_diff_set)
   {
     print_diff_set(*input_diff_set, mode, rman.get_global_settings().get_output_handler(),
-        rman.users(), relation_member_roles(*rman.get_transaction()), action == Diff_Action::collect_rhs_with_del);
+        rman.users(input_diff_set->user_ids()), relation_member_roles(*rman.get_transaction()), action == Diff_Action::collect_rhs_with_del);
     return;
   }
 
@@ -947,7 +944,7 @@ void Print_Statement::execute_comparison(Resource_Manager& rman)
         south, north, west, east, action == Diff_Action::collect_rhs_with_del);
 
     print_diff_set(result, mode, rman.get_global_settings().get_output_handler(),
-        rman.users(), relation_member_roles(*rman.get_transaction()), action == Diff_Action::collect_rhs_with_del);
+        rman.users(result.user_ids()), relation_member_roles(*rman.get_transaction()), action == Diff_Action::collect_rhs_with_del);
   }
 
   rman.health_check(*this);
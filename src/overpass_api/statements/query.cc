@@ -17,6 +17,7 @@
  */
 
 #include "../../template_db/block_backend.h"
+#include "../../template_db/parallel_jobs.h"
 #include "../../template_db/random_file.h"
 #include "../core/settings.h"
 #include "../data/abstract_processing.h"
@@ -290,7 +291,8 @@ std::vector< std::pair< Id_Type, Uint31_Index > > Query_Statement::collect_ids
     {
       if (timestamp == NOW)
       {
-        std::set< std::pair< Tag_Index_Global, Tag_Index_Global > > range_req = get_k_req(krit->first);
+        std::set< std::pair< Tag_Index_Global, Tag_Index_Global > > range_req
+          = get_kregv_req(krit->first, *krit->second);
 	filter_id_list(new_ids, filtered,
 	    tags_db.range_begin(range_req.begin(), range_req.end()), tags_db.range_end(),
 		Trivial_Regex(), *krit->second, check_keys_late);
@@ -368,7 +370,8 @@ std::vector< Id_Type > Query_Statement::collect_ids
     for (std::vector< std::pair< std::string, Regular_Expression* > >::const_iterator krit = key_regexes.begin();
 	 krit != key_regexes.end(); ++krit)
     {
-      std::set< std::pair< Tag_Index_Global, Tag_Index_Global > > range_req = get_k_req(krit->first);
+      std::set< std::pair< Tag_Index_Global, Tag_Index_Global > > range_req
+          = get_kregv_req(krit->first, *krit->second);
       filter_id_list(new_ids, filtered,
 	  tags_db.range_begin(range_req.begin(), range_req.end()), tags_db.range_end(),
 	      Trivial_Regex(), *krit->second);
@@ -438,7 +441,8 @@ std::vector< std::pair< Id_Type, Uint31_Index > > Query_Statement::collect_non_i
   {
     if (timestamp == NOW)
     {
-      std::set< std::pair< Tag_Index_Global, Tag_Index_Global > > range_req = get_k_req(knrit->first);
+      std::set< std::pair< Tag_Index_Global, Tag_Index_Global > > range_req
+          = get_kregv_req(knrit->first, *knrit->second);
       for (typename Block_Backend< Tag_Index_Global, Tag_Object_Global< Id_Type > >::Range_Iterator
           it2(tags_db.range_begin
           (Default_Range_Iterator< Tag_Index_Global >(range_req.begin()),
@@ -502,7 +506,8 @@ std::vector< Id_Type > Query_Statement::collect_non_ids
   for (std::vector< std::pair< std::string, Regular_Expression* > >::const_iterator knrit = key_nregexes.begin();
       knrit != key_nregexes.end(); ++knrit)
   {
-    std::set< std::pair< Tag_Index_Global, Tag_Index_Global > > range_req = get_k_req(knrit->first);
+    std::set< std::pair< Tag_Index_Global, Tag_Index_Global > > range_req
+          = get_kregv_req(knrit->first, *knrit->second);
     for (typename Block_Backend< Tag_Index_Global, Id_Type >::Range_Iterator
         it2(tags_db.range_begin
         (Default_Range_Iterator< Tag_Index_Global >(range_req.begin()),
@@ -1297,6 +1302,61 @@ void Query_Statement::progress_1(std::vector< Id_Type >& ids, bool& invert_ids,
 }
 
 
+/* Runs progress_1 for one element type on a thread of run_parallel_jobs().
+ * A timeout in a worker thread only stops the job. It is reported by the main thread. */
+template< typename Skeleton, typename Id_Type, typename Index >
+struct Progress_1_Job : public Parallel_Job
+{
+  Progress_1_Job(Query_Statement& stmt_, uint64 timestamp_, bool check_keys_late_,
+                 const File_Properties& file_prop_, const File_Properties& attic_file_prop_,
+                 Resource_Manager& rman_)
+      : stmt(&stmt_), timestamp(timestamp_), check_keys_late(check_keys_late_),
+        file_prop(&file_prop_), attic_file_prop(&attic_file_prop_), rman(&rman_),
+        invert_ids(false), answer_state(nothing), timed_out(false), owner(pthread_self()) {}
+
+  // Transaction::data_index() creates the indexes on first use, hence this must happen
+  // on the main thread before the job is run
+  Parallel_Job* open_indexes()
+  {
+    Transaction& transaction = *rman->get_transaction();
+    transaction.data_index(file_prop);
+    if (timestamp != NOW)
+      transaction.data_index(attic_file_prop);
+    transaction.data_index(key_file_properties< Skeleton >());
+    return this;
+  }
+
+  virtual void run()
+  {
+    try
+    {
+      stmt->progress_1< Skeleton, Id_Type, Index >(ids, range_vec, invert_ids, timestamp,
+          answer_state, check_keys_late, *file_prop, *attic_file_prop, *rman);
+    }
+    catch (const Resource_Error& e)
+    {
+      if (pthread_equal(pthread_self(), owner))
+        throw;
+      timed_out = true;
+    }
+  }
+
+  Query_Statement* stmt;
+  uint64 timestamp;
+  bool check_keys_late;
+  const File_Properties* file_prop;
+  const File_Properties* attic_file_prop;
+  Resource_Manager* rman;
+
+  std::vector< Id_Type > ids;
+  std::vector< Index > range_vec;
+  bool invert_ids;
+  Answer_State answer_state;
+  bool timed_out;
+  pthread_t owner;
+};
+
+
 template< class Id_Type >
 void Query_Statement::collect_nodes(std::vector< Id_Type >& ids,
 				 bool& invert_ids, Answer_State& answer_state, Set& into,
@@ -1378,6 +1438,67 @@ std::set< std::pair< Index, Index > > intersect_ranges
 }
 
 
+void Query_Statement::progress_1_parallel(
+    std::vector< Node::Id_Type >& node_ids, std::vector< Uint32_Index >& node_range_vec,
+    Answer_State& node_answer_state,
+    std::vector< Way::Id_Type >& way_ids, std::vector< Uint31_Index >& way_range_vec,
+    Answer_State& way_answer_state,
+    std::vector< Relation::Id_Type >& relation_ids, std::vector< Uint31_Index >& relation_range_vec,
+    Answer_State& relation_answer_state,
+    bool& invert_ids, uint64 timestamp, bool check_keys_late, Set& into, Resource_Manager& rman)
+{
+  // The tag lookups of the different element types read disjoint files.
+  // Only they run concurrently, the collect steps share the constraints and stay sequential.
+  Progress_1_Job< Node_Skeleton, Node::Id_Type, Uint32_Index > node_job(
+      *this, timestamp, check_keys_late,
+      *osm_base_settings().NODE_TAGS_GLOBAL, *attic_settings().NODE_TAGS_GLOBAL, rman);
+  Progress_1_Job< Way_Skeleton, Way::Id_Type, Uint31_Index > way_job(
+      *this, timestamp, check_keys_late,
+      *osm_base_settings().WAY_TAGS_GLOBAL, *attic_settings().WAY_TAGS_GLOBAL, rman);
+  Progress_1_Job< Relation_Skeleton, Relation::Id_Type, Uint31_Index > relation_job(
+      *this, timestamp, check_keys_late,
+      *osm_base_settings().RELATION_TAGS_GLOBAL, *attic_settings().RELATION_TAGS_GLOBAL, rman);
+
+  std::vector< Parallel_Job* > jobs;
+  if (type & QUERY_NODE)
+    jobs.push_back(node_job.open_indexes());
+  if (type & QUERY_WAY)
+    jobs.push_back(way_job.open_indexes());
+  if (type & QUERY_RELATION)
+    jobs.push_back(relation_job.open_indexes());
+  run_parallel_jobs(jobs, rman.get_max_parallel_threads());
+
+  if (node_job.timed_out || way_job.timed_out || relation_job.timed_out)
+    // Reports the timeout from the main thread
+    rman.health_check(*this);
+
+  if (type & QUERY_NODE)
+  {
+    node_ids.swap(node_job.ids);
+    node_range_vec.swap(node_job.range_vec);
+    node_answer_state = node_job.answer_state;
+    invert_ids |= node_job.invert_ids;
+    collect_nodes(node_ids, invert_ids, node_answer_state, into, rman);
+  }
+  if (type & QUERY_WAY)
+  {
+    way_ids.swap(way_job.ids);
+    way_range_vec.swap(way_job.range_vec);
+    way_answer_state = way_job.answer_state;
+    invert_ids |= way_job.invert_ids;
+    collect_elems(way_ids, invert_ids, way_answer_state, into, rman);
+  }
+  if (type & QUERY_RELATION)
+  {
+    relation_ids.swap(relation_job.ids);
+    relation_range_vec.swap(relation_job.range_vec);
+    relation_answer_state = relation_job.answer_state;
+    invert_ids |= relation_job.invert_ids;
+    collect_elems(relation_ids, invert_ids, relation_answer_state, into, rman);
+  }
+}
+
+
 void Query_Statement::execute(Resource_Manager& rman)
 {
   Cpu_Timer cpu(rman, 1);
@@ -1413,26 +1534,35 @@ void Query_Statement::execute(Resource_Manager& rman)
     std::set< std::pair< Uint31_Index, Uint31_Index > > relation_range_req_31;
     std::vector< Uint31_Index > relation_range_vec_31;
 
-    if (type & QUERY_NODE)
-    {
-      progress_1< Node_Skeleton, Node::Id_Type, Uint32_Index >(
-	  node_ids, range_vec_32, invert_ids, timestamp, node_answer_state, check_keys_late,
-          *osm_base_settings().NODE_TAGS_GLOBAL, *attic_settings().NODE_TAGS_GLOBAL, rman);
-      collect_nodes(node_ids, invert_ids, node_answer_state, into, rman);
-    }
-    if (type & QUERY_WAY)
-    {
-      progress_1< Way_Skeleton, Way::Id_Type, Uint31_Index >(
-	  way_ids, way_range_vec_31, invert_ids, timestamp, way_answer_state, check_keys_late,
-          *osm_base_settings().WAY_TAGS_GLOBAL, *attic_settings().WAY_TAGS_GLOBAL, rman);
-      collect_elems(way_ids, invert_ids, way_answer_state, into, rman);
-    }
-    if (type & QUERY_RELATION)
+    if (rman.get_max_parallel_threads() > 1
+        && ((type & QUERY_NODE ? 1 : 0) + (type & QUERY_WAY ? 1 : 0) + (type & QUERY_RELATION ? 1 : 0)) > 1)
+      progress_1_parallel(node_ids, range_vec_32, node_answer_state,
+          way_ids, way_range_vec_31, way_answer_state,
+          relation_ids, relation_range_vec_31, relation_answer_state,
+          invert_ids, timestamp, check_keys_late, into, rman);
+    else
     {
-      progress_1< Relation_Skeleton, Relation::Id_Type, Uint31_Index >(
-	  relation_ids, relation_range_vec_31, invert_ids, timestamp, relation_answer_state, check_keys_late,
-          *osm_base_settings().RELATION_TAGS_GLOBAL,  *attic_settings().RELATION_TAGS_GLOBAL, rman);
-      collect_elems(relation_ids, invert_ids, relation_answer_state, into, rman);
+      if (type & QUERY_NODE)
+      {
+        progress_1< Node_Skeleton, Node::Id_Type, Uint32_Index >(
+	    node_ids, range_vec_32, invert_ids, timestamp, node_answer_state, check_keys_late,
+            *osm_base_settings().NODE_TAGS_GLOBAL, *attic_settings().NODE_TAGS_GLOBAL, rman);
+        collect_nodes(node_ids, invert_ids, node_answer_state, into, rman);
+      }
+      if (type & QUERY_WAY)
+      {
+        progress_1< Way_Skeleton, Way::Id_Type, Uint31_Index >(
+	    way_ids, way_range_vec_31, invert_ids, timestamp, way_answer_state, check_keys_late,
+            *osm_base_settings().WAY_TAGS_GLOBAL, *attic_settings().WAY_TAGS_GLOBAL, rman);
+        collect_elems(way_ids, invert_ids, way_answer_state, into, rman);
+      }
+      if (type & QUERY_RELATION)
+      {
+        progress_1< Relation_Skeleton, Relation::Id_Type, Uint31_Index >(
+	    relation_ids, relation_range_vec_31, invert_ids, timestamp, relation_answer_state, check_keys_late,
+            *osm_base_settings().RELATION_TAGS_GLOBAL,  *attic_settings().RELATION_TAGS_GLOBAL, rman);
+        collect_elems(relation_ids, invert_ids, relation_answer_state, into, rman);
+      }
     }
     if (type & QUERY_DERIVED)
     {
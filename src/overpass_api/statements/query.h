@@ -225,6 +225,18 @@ class Query_Statement : public Output_Statement
 				 Resource_Manager& rman);
 
     void collect_elems(Answer_State& answer_state, Set& into, Resource_Manager& rman);
+
+    void progress_1_parallel(
+        std::vector< Node::Id_Type >& node_ids, std::vector< Uint32_Index >& node_range_vec,
+        Answer_State& node_answer_state,
+        std::vector< Way::Id_Type >& way_ids, std::vector< Uint31_Index >& way_range_vec,
+        Answer_State& way_answer_state,
+        std::vector< Relation::Id_Type >& relation_ids, std::vector< Uint31_Index >& relation_range_vec,
+        Answer_State& relation_answer_state,
+        bool& invert_ids, uint64 timestamp, bool check_keys_late, Set& into, Resource_Manager& rman);
+
+    template< typename Skeleton, typename Id_Type, typename Index >
+    friend struct Progress_1_Job;
 };
 
 
@@ -179,7 +179,8 @@ void collect_relations
 {
   std::vector< Relation_Entry::Ref_Type > ids = extract_children_ids< TSourceIndex, TSourceObject, Relation_Entry::Ref_Type >(sources);
   rman.health_check(stmt);
-  std::set< Uint31_Index > req = extract_parent_indices(sources);
+  std::set< Uint31_Index > req = extract_parent_indices(stmt, rman,
+      parent_relations_file_properties< TSourceObject >(), *osm_base_settings().RELATIONS, sources);
   rman.health_check(stmt);
 
   collect_items_discrete(&stmt, rman, *osm_base_settings().RELATIONS, req,
@@ -195,7 +196,8 @@ void collect_relations
 {
   std::vector< Relation_Entry::Ref_Type > ids = extract_children_ids< TSourceIndex, TSourceObject, Relation_Entry::Ref_Type >(sources);
   rman.health_check(stmt);
-  std::set< Uint31_Index > req = extract_parent_indices(sources);
+  std::set< Uint31_Index > req = extract_parent_indices(stmt, rman,
+      parent_relations_file_properties< TSourceObject >(), *osm_base_settings().RELATIONS, sources);
   rman.health_check(stmt);
 
   collect_items_discrete(&stmt, rman, *osm_base_settings().RELATIONS, req,
@@ -212,7 +214,8 @@ void collect_relations
 {
   std::vector< Relation_Entry::Ref_Type > children_ids = extract_children_ids< TSourceIndex, TSourceObject, Relation_Entry::Ref_Type >(sources);
   rman.health_check(stmt);
-  std::set< Uint31_Index > req = extract_parent_indices(sources);
+  std::set< Uint31_Index > req = extract_parent_indices(stmt, rman,
+      parent_relations_file_properties< TSourceObject >(), *osm_base_settings().RELATIONS, sources);
   rman.health_check(stmt);
 
   if (!invert_ids)
@@ -241,7 +244,8 @@ void collect_relations
 {
   std::vector< Relation_Entry::Ref_Type > children_ids = extract_children_ids< TSourceIndex, TSourceObject, Relation_Entry::Ref_Type >(sources);
   rman.health_check(stmt);
-  std::set< Uint31_Index > req = extract_parent_indices(sources);
+  std::set< Uint31_Index > req = extract_parent_indices(stmt, rman,
+      parent_relations_file_properties< TSourceObject >(), *osm_base_settings().RELATIONS, sources);
   rman.health_check(stmt);
 
   if (!invert_ids)
@@ -416,6 +420,26 @@ void collect_relations
 }
 
 
+/* Without the index from members to their parents, any relation can be the parent
+ * of a relation. Hence then all relations must be read. */
+template< class TPredicate >
+void collect_parent_relations
+    (const Statement& stmt, Resource_Manager& rman,
+     const std::map< Uint31_Index, std::vector< Relation_Skeleton > >& sources,
+     const TPredicate& predicate, std::map< Uint31_Index, std::vector< Relation_Skeleton > >& result)
+{
+  if (rman.has_parent_index())
+  {
+    std::set< Uint31_Index > req = extract_parent_indices(stmt, rman,
+        osm_base_settings().RELATION_PARENT_RELATIONS, *osm_base_settings().RELATIONS, sources);
+    rman.health_check(stmt);
+    collect_items_discrete(&stmt, rman, *osm_base_settings().RELATIONS, req, predicate, result);
+  }
+  else
+    collect_items_flat(stmt, rman, *osm_base_settings().RELATIONS, predicate, result);
+}
+
+
 void collect_relations
     (const Statement& stmt, Resource_Manager& rman,
      const std::map< Uint31_Index, std::vector< Relation_Skeleton > >& sources,
@@ -424,7 +448,7 @@ void collect_relations
   std::vector< Uint64 > ids = extract_children_ids< Uint31_Index, Relation_Skeleton, Uint64 >(sources);
   rman.health_check(stmt);
 
-  collect_items_flat(stmt, rman, *osm_base_settings().RELATIONS,
+  collect_parent_relations(stmt, rman, sources,
       Get_Parent_Rels_Predicate(ids, Relation_Entry::RELATION), result);
 }
 
@@ -437,7 +461,7 @@ void collect_relations
   std::vector< Uint64 > ids = extract_children_ids< Uint31_Index, Relation_Skeleton, Uint64 >(sources);
   rman.health_check(stmt);
 
-  collect_items_flat(stmt, rman, *osm_base_settings().RELATIONS,
+  collect_parent_relations(stmt, rman, sources,
       Get_Parent_Rels_Role_Predicate(ids, Relation_Entry::RELATION, role_id), result);
 }
 
@@ -452,14 +476,14 @@ void collect_relations
   rman.health_check(stmt);
 
   if (!invert_ids)
-    collect_items_flat(stmt, rman, *osm_base_settings().RELATIONS,
+    collect_parent_relations(stmt, rman, sources,
         And_Predicate< Relation_Skeleton,
 	    Id_Predicate< Relation_Skeleton >, Get_Parent_Rels_Predicate >
 	    (Id_Predicate< Relation_Skeleton >(ids),
             Get_Parent_Rels_Predicate(children_ids, Relation_Entry::RELATION)),
         result);
   else
-    collect_items_flat(stmt, rman, *osm_base_settings().RELATIONS,
+    collect_parent_relations(stmt, rman, sources,
         And_Predicate< Relation_Skeleton,
 	    Not_Predicate< Relation_Skeleton, Id_Predicate< Relation_Skeleton > >,
 	    Get_Parent_Rels_Predicate >
@@ -480,14 +504,14 @@ void collect_relations
   rman.health_check(stmt);
 
   if (!invert_ids)
-    collect_items_flat(stmt, rman, *osm_base_settings().RELATIONS,
+    collect_parent_relations(stmt, rman, sources,
         And_Predicate< Relation_Skeleton,
             Id_Predicate< Relation_Skeleton >, Get_Parent_Rels_Role_Predicate >
             (Id_Predicate< Relation_Skeleton >(ids),
             Get_Parent_Rels_Role_Predicate(children_ids, Relation_Entry::RELATION, role_id)),
         result);
   else
-    collect_items_flat(stmt, rman, *osm_base_settings().RELATIONS,
+    collect_parent_relations(stmt, rman, sources,
         And_Predicate< Relation_Skeleton,
             Not_Predicate< Relation_Skeleton, Id_Predicate< Relation_Skeleton > >,
             Get_Parent_Rels_Role_Predicate >
@@ -896,22 +920,50 @@ void collect_relations(const Statement& query, Resource_Manager& rman,
 }
 
 
+/* Removes from found the elements whose id is already in the same index of known.
+ * Both must be sorted. */
+template< typename Index, typename Object >
+void remove_known(std::map< Index, std::vector< Object > >& found,
+                  const std::map< Index, std::vector< Object > >& known)
+{
+  typename std::map< Index, std::vector< Object > >::iterator it = found.begin();
+  while (it != found.end())
+  {
+    typename std::map< Index, std::vector< Object > >::const_iterator known_it = known.find(it->first);
+    if (known_it != known.end())
+    {
+      std::vector< Object > unknown;
+      std::set_difference(it->second.begin(), it->second.end(),
+          known_it->second.begin(), known_it->second.end(),
+          back_inserter(unknown), Compare_By_Id< Object >());
+      it->second.swap(unknown);
+    }
+    if (it->second.empty())
+      found.erase(it++);
+    else
+      ++it;
+  }
+}
+
+
+/* The loops below compute the closure of source under a step that finds the relations
+ * below or above the given ones. The step works element by element, hence each round
+ * only needs to start from the relations that the previous round has added. */
+
 void relations_loop(const Statement& query, Resource_Manager& rman,
 		    std::map< Uint31_Index, std::vector< Relation_Skeleton > > source,
 		    std::map< Uint31_Index, std::vector< Relation_Skeleton > >& result)
 {
-  uint old_rel_count = count(source);
-  while (true)
-  {
-    result = relation_relation_members(query, rman, source);
-    sort_second(source);
-    sort_second(result);
-    indexed_set_union(result, source);
-    uint new_rel_count = count(result);
-    if (new_rel_count == old_rel_count)
-      return;
-    old_rel_count = new_rel_count;
-    source.swap(result);
+  sort_second(source);
+  result = source;
+  while (!source.empty())
+  {
+    std::map< Uint31_Index, std::vector< Relation_Skeleton > > found
+        = relation_relation_members(query, rman, source);
+    sort_second(found);
+    remove_known(found, result);
+    indexed_set_union(result, found);
+    source.swap(found);
   }
 }
 
@@ -922,29 +974,28 @@ void relations_loop(const Statement& query, Resource_Manager& rman,
                     std::map< Uint31_Index, std::vector< Relation_Skeleton > >& result,
                     std::map< Uint31_Index, std::vector< Attic< Relation_Skeleton > > >& attic_result)
 {
-  uint old_rel_count = count(source) + count(attic_source);
-  while (true)
+  sort_second(source);
+  sort_second(attic_source);
+  result = source;
+  attic_result = attic_source;
+  keep_matching_skeletons(result, attic_result, rman.get_desired_timestamp());
+  while (count(source) + count(attic_source) > 0)
   {
     std::pair< std::map< Uint31_Index, std::vector< Relation_Skeleton > >,
-        std::map< Uint31_Index, std::vector< Attic< Relation_Skeleton > > > > result_pair
+        std::map< Uint31_Index, std::vector< Attic< Relation_Skeleton > > > > found
         = relation_relation_members(query, rman, source, attic_source);
-    sort_second(source);
-    sort_second(attic_source);
-    sort_second(result_pair.first);
-    sort_second(result_pair.second);
-    indexed_set_union(result_pair.first, source);
-    indexed_set_union(result_pair.second, attic_source);
-    keep_matching_skeletons(result_pair.first, result_pair.second, rman.get_desired_timestamp());
-    uint new_rel_count = count(result_pair.first) + count(result_pair.second);
-    if (new_rel_count == old_rel_count)
-    {
-      result.swap(result_pair.first);
-      attic_result.swap(result_pair.second);
-      return;
-    }
-    old_rel_count = new_rel_count;
-    source.swap(result_pair.first);
-    attic_source.swap(result_pair.second);
+    sort_second(found.first);
+    sort_second(found.second);
+    remove_known(found.first, result);
+    remove_known(found.second, attic_result);
+    indexed_set_union(result, found.first);
+    indexed_set_union(attic_result, found.second);
+    keep_matching_skeletons(result, attic_result, rman.get_desired_timestamp());
+    // Versions discarded by keep_matching_skeletons are not followed
+    item_filter_map(found.first, result);
+    item_filter_map(found.second, attic_result);
+    source.swap(found.first);
+    attic_source.swap(found.second);
   }
 }
 
@@ -953,19 +1004,16 @@ void relations_up_loop(const Statement& query, Resource_Manager& rman,
 		    std::map< Uint31_Index, std::vector< Relation_Skeleton > > source,
 		    std::map< Uint31_Index, std::vector< Relation_Skeleton > >& result)
 {
-  uint old_rel_count = count(source);
-  while (true)
-  {
-    result.clear();
-    collect_relations(query, rman, source, result);
-    sort_second(source);
-    sort_second(result);
-    indexed_set_union(result, source);
-    uint new_rel_count = count(result);
-    if (new_rel_count == old_rel_count)
-      return;
-    old_rel_count = new_rel_count;
-    source.swap(result);
+  sort_second(source);
+  result = source;
+  while (!source.empty())
+  {
+    std::map< Uint31_Index, std::vector< Relation_Skeleton > > found;
+    collect_relations(query, rman, source, found);
+    sort_second(found);
+    remove_known(found, result);
+    indexed_set_union(result, found);
+    source.swap(found);
   }
 }
 
@@ -976,25 +1024,28 @@ void relations_up_loop(const Statement& query, Resource_Manager& rman,
                     std::map< Uint31_Index, std::vector< Relation_Skeleton > >& result,
                     std::map< Uint31_Index, std::vector< Attic< Relation_Skeleton > > >& attic_result)
 {
-  uint old_rel_count = count(source) + count(attic_source);
-  while (true)
-  {
-    result.clear();
-    attic_result.clear();
-    collect_relations(query, rman, source, attic_source, result, attic_result);
-    sort_second(source);
-    sort_second(result);
-    indexed_set_union(result, source);
-    sort_second(attic_source);
-    sort_second(attic_result);
-    indexed_set_union(attic_result, attic_source);
+  sort_second(source);
+  sort_second(attic_source);
+  result = source;
+  attic_result = attic_source;
+  keep_matching_skeletons(result, attic_result, rman.get_desired_timestamp());
+  while (count(source) + count(attic_source) > 0)
+  {
+    std::map< Uint31_Index, std::vector< Relation_Skeleton > > found;
+    std::map< Uint31_Index, std::vector< Attic< Relation_Skeleton > > > attic_found;
+    collect_relations(query, rman, source, attic_source, found, attic_found);
+    sort_second(found);
+    sort_second(attic_found);
+    remove_known(found, result);
+    remove_known(attic_found, attic_result);
+    indexed_set_union(result, found);
+    indexed_set_union(attic_result, attic_found);
     keep_matching_skeletons(result, attic_result, rman.get_desired_timestamp());
-    uint new_rel_count = count(result) + count(attic_result);
-    if (new_rel_count == old_rel_count)
-      return;
-    old_rel_count = new_rel_count;
-    source.swap(result);
-    attic_source.swap(attic_result);
+    // Versions discarded by keep_matching_skeletons are not followed
+    item_filter_map(found, result);
+    item_filter_map(attic_found, attic_result);
+    source.swap(found);
+    attic_source.swap(attic_found);
   }
 }
 
@@ -127,6 +127,8 @@ std::string Statement_Dump::dump_compact_map_ql(Statement::Factory& stmt_factory
 	result += "[timeout:" + it->second + "]";
       else if (it->first == "element-limit")
 	result += "[maxsize:" + it->second + "]";
+      else if (it->first == "parallel")
+	result += "[parallel:" + it->second + "]";
       else if (it->first == "output")
       {
         if (stmt_factory.global_settings.get_output_handler())
@@ -198,6 +200,8 @@ std::string Statement_Dump::dump_bbox_map_ql(Statement::Factory& stmt_factory)
       }
       else if (it->first == "element-limit")
 	result += "[maxsize:" + it->second + "]";
+      else if (it->first == "parallel")
+	result += "[parallel:" + it->second + "]";
       else if (it->first == "output")
       {
         if (stmt_factory.global_settings.get_output_handler())
@@ -268,6 +272,8 @@ std::string Statement_Dump::dump_pretty_map_ql(Statement::Factory& stmt_factory)
 	result += "[timeout:" + it->second + "]\n";
       else if (it->first == "element-limit")
 	result += "[maxsize:" + it->second + "]\n";
+      else if (it->first == "parallel")
+	result += "[parallel:" + it->second + "]\n";
       else if (it->first == "output")
       {
         if (stmt_factory.global_settings.get_output_handler())
@@ -26,16 +26,22 @@ String_Endom_Evaluator_Maker< Evaluator_Number > Evaluator_Number::evaluator_mak
 
 
 std::string Evaluator_Number::process(const std::string& rhs_s) const
+{
+  return process_value(Eval_Value(rhs_s)).as_string();
+}
+
+
+Eval_Value Evaluator_Number::process_value(const Eval_Value& rhs_v) const
 {
   int64 rhs_l = 0;
-  if (try_int64(rhs_s, rhs_l))
-    return to_string(rhs_l);
+  if (rhs_v.as_int64(rhs_l))
+    return Eval_Value::from_int64(rhs_l);
 
   double rhs_d = 0;
-  if (try_starts_with_double(rhs_s, rhs_d))
-    return to_string(rhs_d);
+  if (try_starts_with_double(rhs_v.as_string(), rhs_d))
+    return Eval_Value::from_double(rhs_d);
 
-  return "NaN";
+  return Eval_Value("NaN");
 }
 
 
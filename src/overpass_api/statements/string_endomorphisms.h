@@ -141,6 +141,7 @@ public:
       : Evaluator_String_Endom_Syntax< Evaluator_Number >(line_number_, input_attributes) {}
 
   virtual std::string process(const std::string& rhs_result) const;
+  virtual Eval_Value process_value(const Eval_Value& rhs_result) const;
 };
 
 
@@ -103,97 +103,162 @@ Eval_Task* Ternary_Evaluator::get_string_task(Prepare_Task_Context& context, con
   Eval_Task* cond_task = condition ? condition->get_string_task(context, key) : 0;
   Eval_Task* lhs_task = lhs ? lhs->get_string_task(context, key) : 0;
   Eval_Task* rhs_task = rhs ? rhs->get_string_task(context, key) : 0;
+
+  // A constant condition selects the branch once and for all
+  if (dynamic_cast< Const_Eval_Task* >(cond_task))
+  {
+    bool cond_true = cond_task->eval_value(key).is_true();
+    delete cond_task;
+    Eval_Task* chosen = cond_true ? lhs_task : rhs_task;
+    delete (cond_true ? rhs_task : lhs_task);
+    return chosen ? chosen : new Const_Eval_Task("");
+  }
+
   return new Ternary_Eval_Task(cond_task, lhs_task, rhs_task);
 }
 
 
 std::string Ternary_Eval_Task::eval(const std::string* key) const
 {
-  if (!condition)
-    return "0";
-  if (string_represents_boolean_true(condition->eval(key)))
-    return lhs ? lhs->eval(key) : "";
-  return rhs ? rhs->eval(key) : "";
+  return eval_value(key).as_string();
 }
 
 
 std::string Ternary_Eval_Task::eval(const Element_With_Context< Node_Skeleton >& data, const std::string* key) const
 {
-  if (!condition)
-    return "0";
-  if (string_represents_boolean_true(condition->eval(data, key)))
-    return lhs ? lhs->eval(data, key) : "";
-  return rhs ? rhs->eval(data, key) : "";
+  return eval_value(data, key).as_string();
 }
 
 
 std::string Ternary_Eval_Task::eval(const Element_With_Context< Attic< Node_Skeleton > >& data, const std::string* key) const
 {
-  if (!condition)
-    return "0";
-  if (string_represents_boolean_true(condition->eval(data, key)))
-    return lhs ? lhs->eval(data, key) : "";
-  return rhs ? rhs->eval(data, key) : "";
+  return eval_value(data, key).as_string();
 }
 
 
 std::string Ternary_Eval_Task::eval(const Element_With_Context< Way_Skeleton >& data, const std::string* key) const
 {
-  if (!condition)
-    return "0";
-  if (string_represents_boolean_true(condition->eval(data, key)))
-    return lhs ? lhs->eval(data, key) : "";
-  return rhs ? rhs->eval(data, key) : "";
+  return eval_value(data, key).as_string();
 }
 
 
 std::string Ternary_Eval_Task::eval(const Element_With_Context< Attic< Way_Skeleton > >& data, const std::string* key) const
 {
-  if (!condition)
-    return "0";
-  if (string_represents_boolean_true(condition->eval(data, key)))
-    return lhs ? lhs->eval(data, key) : "";
-  return rhs ? rhs->eval(data, key) : "";
+  return eval_value(data, key).as_string();
 }
 
 
 std::string Ternary_Eval_Task::eval(const Element_With_Context< Relation_Skeleton >& data, const std::string* key) const
 {
-  if (!condition)
-    return "0";
-  if (string_represents_boolean_true(condition->eval(data, key)))
-    return lhs ? lhs->eval(data, key) : "";
-  return rhs ? rhs->eval(data, key) : "";
+  return eval_value(data, key).as_string();
 }
 
 
 std::string Ternary_Eval_Task::eval(const Element_With_Context< Attic< Relation_Skeleton > >& data, const std::string* key) const
 {
-  if (!condition)
-    return "0";
-  if (string_represents_boolean_true(condition->eval(data, key)))
-    return lhs ? lhs->eval(data, key) : "";
-  return rhs ? rhs->eval(data, key) : "";
+  return eval_value(data, key).as_string();
 }
 
 
 std::string Ternary_Eval_Task::eval(const Element_With_Context< Area_Skeleton >& data, const std::string* key) const
 {
-  if (!condition)
-    return "0";
-  if (string_represents_boolean_true(condition->eval(data, key)))
-    return lhs ? lhs->eval(data, key) : "";
-  return rhs ? rhs->eval(data, key) : "";
+  return eval_value(data, key).as_string();
 }
 
 
 std::string Ternary_Eval_Task::eval(const Element_With_Context< Derived_Skeleton >& data, const std::string* key) const
+{
+  return eval_value(data, key).as_string();
+}
+
+
+Eval_Value Ternary_Eval_Task::eval_value(const std::string* key) const
+{
+  if (!condition)
+    return Eval_Value("0");
+  if (condition->eval_value(key).is_true())
+    return lhs ? lhs->eval_value(key) : Eval_Value();
+  return rhs ? rhs->eval_value(key) : Eval_Value();
+}
+
+
+Eval_Value Ternary_Eval_Task::eval_value(const Element_With_Context< Node_Skeleton >& data, const std::string* key) const
+{
+  if (!condition)
+    return Eval_Value("0");
+  if (condition->eval_value(data, key).is_true())
+    return lhs ? lhs->eval_value(data, key) : Eval_Value();
+  return rhs ? rhs->eval_value(data, key) : Eval_Value();
+}
+
+
+Eval_Value Ternary_Eval_Task::eval_value(const Element_With_Context< Attic< Node_Skeleton > >& data, const std::string* key) const
+{
+  if (!condition)
+    return Eval_Value("0");
+  if (condition->eval_value(data, key).is_true())
+    return lhs ? lhs->eval_value(data, key) : Eval_Value();
+  return rhs ? rhs->eval_value(data, key) : Eval_Value();
+}
+
+
+Eval_Value Ternary_Eval_Task::eval_value(const Element_With_Context< Way_Skeleton >& data, const std::string* key) const
+{
+  if (!condition)
+    return Eval_Value("0");
+  if (condition->eval_value(data, key).is_true())
+    return lhs ? lhs->eval_value(data, key) : Eval_Value();
+  return rhs ? rhs->eval_value(data, key) : Eval_Value();
+}
+
+
+Eval_Value Ternary_Eval_Task::eval_value(const Element_With_Context< Attic< Way_Skeleton > >& data, const std::string* key) const
+{
+  if (!condition)
+    return Eval_Value("0");
+  if (condition->eval_value(data, key).is_true())
+    return lhs ? lhs->eval_value(data, key) : Eval_Value();
+  return rhs ? rhs->eval_value(data, key) : Eval_Value();
+}
+
+
+Eval_Value Ternary_Eval_Task::eval_value(const Element_With_Context< Relation_Skeleton >& data, const std::string* key) const
+{
+  if (!condition)
+    return Eval_Value("0");
+  if (condition->eval_value(data, key).is_true())
+    return lhs ? lhs->eval_value(data, key) : Eval_Value();
+  return rhs ? rhs->eval_value(data, key) : Eval_Value();
+}
+
+
+Eval_Value Ternary_Eval_Task::eval_value(const Element_With_Context< Attic< Relation_Skeleton > >& data, const std::string* key) const
+{
+  if (!condition)
+    return Eval_Value("0");
+  if (condition->eval_value(data, key).is_true())
+    return lhs ? lhs->eval_value(data, key) : Eval_Value();
+  return rhs ? rhs->eval_value(data, key) : Eval_Value();
+}
+
+
+Eval_Value Ternary_Eval_Task::eval_value(const Element_With_Context< Area_Skeleton >& data, const std::string* key) const
+{
+  if (!condition)
+    return Eval_Value("0");
+  if (condition->eval_value(data, key).is_true())
+    return lhs ? lhs->eval_value(data, key) : Eval_Value();
+  return rhs ? rhs->eval_value(data, key) : Eval_Value();
+}
+
+
+Eval_Value Ternary_Eval_Task::eval_value(const Element_With_Context< Derived_Skeleton >& data, const std::string* key) const
 {
   if (!condition)
-    return "0";
-  if (string_represents_boolean_true(condition->eval(data, key)))
-    return lhs ? lhs->eval(data, key) : "";
-  return rhs ? rhs->eval(data, key) : "";
+    return Eval_Value("0");
+  if (condition->eval_value(data, key).is_true())
+    return lhs ? lhs->eval_value(data, key) : Eval_Value();
+  return rhs ? rhs->eval_value(data, key) : Eval_Value();
 }
 
 
@@ -210,7 +275,7 @@ Opaque_Geometry* Ternary_Eval_Geometry_Task::eval() const
 {
   if (!condition)
     return 0;
-  if (string_represents_boolean_true(condition->eval(0)))
+  if (condition->eval_value(0).is_true())
     return lhs ? lhs->eval() : 0;
   return rhs ? rhs->eval() : 0;
 }
@@ -220,7 +285,7 @@ Opaque_Geometry* Ternary_Eval_Geometry_Task::eval(const Element_With_Context< No
 {
   if (!condition)
     return 0;
-  if (string_represents_boolean_true(condition->eval(data, 0)))
+  if (condition->eval_value(data, 0).is_true())
     return lhs ? lhs->eval(data) : 0;
   return rhs ? rhs->eval(data) : 0;
 }
@@ -230,7 +295,7 @@ Opaque_Geometry* Ternary_Eval_Geometry_Task::eval(const Element_With_Context< At
 {
   if (!condition)
     return 0;
-  if (string_represents_boolean_true(condition->eval(data, 0)))
+  if (condition->eval_value(data, 0).is_true())
     return lhs ? lhs->eval(data) : 0;
   return rhs ? rhs->eval(data) : 0;
 }
@@ -240,7 +305,7 @@ Opaque_Geometry* Ternary_Eval_Geometry_Task::eval(const Element_With_Context< Wa
 {
   if (!condition)
     return 0;
-  if (string_represents_boolean_true(condition->eval(data, 0)))
+  if (condition->eval_value(data, 0).is_true())
     return lhs ? lhs->eval(data) : 0;
   return rhs ? rhs->eval(data) : 0;
 }
@@ -250,7 +315,7 @@ Opaque_Geometry* Ternary_Eval_Geometry_Task::eval(const Element_With_Context< At
 {
   if (!condition)
     return 0;
-  if (string_represents_boolean_true(condition->eval(data, 0)))
+  if (condition->eval_value(data, 0).is_true())
     return lhs ? lhs->eval(data) : 0;
   return rhs ? rhs->eval(data) : 0;
 }
@@ -260,7 +325,7 @@ Opaque_Geometry* Ternary_Eval_Geometry_Task::eval(const Element_With_Context< Re
 {
   if (!condition)
     return 0;
-  if (string_represents_boolean_true(condition->eval(data, 0)))
+  if (condition->eval_value(data, 0).is_true())
     return lhs ? lhs->eval(data) : 0;
   return rhs ? rhs->eval(data) : 0;
 }
@@ -270,7 +335,7 @@ Opaque_Geometry* Ternary_Eval_Geometry_Task::eval(const Element_With_Context< At
 {
   if (!condition)
     return 0;
-  if (string_represents_boolean_true(condition->eval(data, 0)))
+  if (condition->eval_value(data, 0).is_true())
     return lhs ? lhs->eval(data) : 0;
   return rhs ? rhs->eval(data) : 0;
 }
@@ -280,7 +345,7 @@ Opaque_Geometry* Ternary_Eval_Geometry_Task::eval(const Element_With_Context< Ar
 {
   if (!condition)
     return 0;
-  if (string_represents_boolean_true(condition->eval(data, 0)))
+  if (condition->eval_value(data, 0).is_true())
     return lhs ? lhs->eval(data) : 0;
   return rhs ? rhs->eval(data) : 0;
 }
@@ -290,7 +355,7 @@ Opaque_Geometry* Ternary_Eval_Geometry_Task::eval(const Element_With_Context< De
 {
   if (!condition)
     return 0;
-  if (string_represents_boolean_true(condition->eval(data, 0)))
+  if (condition->eval_value(data, 0).is_true())
     return lhs ? lhs->eval(data) : 0;
   return rhs ? rhs->eval(data) : 0;
 }
@@ -37,6 +37,16 @@ void Evaluator_Unary_Function::add_statement(Statement* statement, std::string t
 Eval_Task* Evaluator_Unary_Function::get_string_task(Prepare_Task_Context& context, const std::string* key)
 {
   Eval_Task* rhs_task = rhs ? rhs->get_string_task(context, key) : 0;
+
+  // Fold constant subexpressions such that they are computed once and not once per element
+  Const_Eval_Task* rhs_const = dynamic_cast< Const_Eval_Task* >(rhs_task);
+  if (rhs_const)
+  {
+    Eval_Value result = process_value(rhs_const->eval_value(key));
+    delete rhs_task;
+    return new Const_Eval_Task(result);
+  }
+
   return new Unary_Eval_Task(rhs_task, this);
 }
 
@@ -51,55 +61,109 @@ Requested_Context Evaluator_Unary_Function::request_context() const
 
 std::string Unary_Eval_Task::eval(const std::string* key) const
 {
-  return evaluator->process(rhs ? rhs->eval(key) : "");
+  return eval_value(key).as_string();
 }
 
 
 std::string Unary_Eval_Task::eval(const Element_With_Context< Node_Skeleton >& data, const std::string* key) const
 {
-  return evaluator->process(rhs ? rhs->eval(data, key) : "");
+  return eval_value(data, key).as_string();
 }
 
 
 std::string Unary_Eval_Task::eval(const Element_With_Context< Attic< Node_Skeleton > >& data, const std::string* key) const
 {
-  return evaluator->process(rhs ? rhs->eval(data, key) : "");
+  return eval_value(data, key).as_string();
 }
 
 
 std::string Unary_Eval_Task::eval(const Element_With_Context< Way_Skeleton >& data, const std::string* key) const
 {
-  return evaluator->process(rhs ? rhs->eval(data, key) : "");
+  return eval_value(data, key).as_string();
 }
 
 
 std::string Unary_Eval_Task::eval(const Element_With_Context< Attic< Way_Skeleton > >& data, const std::string* key) const
 {
-  return evaluator->process(rhs ? rhs->eval(data, key) : "");
+  return eval_value(data, key).as_string();
 }
 
 
 std::string Unary_Eval_Task::eval(const Element_With_Context< Relation_Skeleton >& data, const std::string* key) const
 {
-  return evaluator->process(rhs ? rhs->eval(data, key) : "");
+  return eval_value(data, key).as_string();
 }
 
 
 std::string Unary_Eval_Task::eval(const Element_With_Context< Attic< Relation_Skeleton > >& data, const std::string* key) const
 {
-  return evaluator->process(rhs ? rhs->eval(data, key) : "");
+  return eval_value(data, key).as_string();
 }
 
 
 std::string Unary_Eval_Task::eval(const Element_With_Context< Area_Skeleton >& data, const std::string* key) const
 {
-  return evaluator->process(rhs ? rhs->eval(data, key) : "");
+  return eval_value(data, key).as_string();
 }
 
 
 std::string Unary_Eval_Task::eval(const Element_With_Context< Derived_Skeleton >& data, const std::string* key) const
 {
-  return evaluator->process(rhs ? rhs->eval(data, key) : "");
+  return eval_value(data, key).as_string();
+}
+
+
+Eval_Value Unary_Eval_Task::eval_value(const std::string* key) const
+{
+  return evaluator->process_value(rhs ? rhs->eval_value(key) : Eval_Value());
+}
+
+
+Eval_Value Unary_Eval_Task::eval_value(const Element_With_Context< Node_Skeleton >& data, const std::string* key) const
+{
+  return evaluator->process_value(rhs ? rhs->eval_value(data, key) : Eval_Value());
+}
+
+
+Eval_Value Unary_Eval_Task::eval_value(const Element_With_Context< Attic< Node_Skeleton > >& data, const std::string* key) const
+{
+  return evaluator->process_value(rhs ? rhs->eval_value(data, key) : Eval_Value());
+}
+
+
+Eval_Value Unary_Eval_Task::eval_value(const Element_With_Context< Way_Skeleton >& data, const std::string* key) const
+{
+  return evaluator->process_value(rhs ? rhs->eval_value(data, key) : Eval_Value());
+}
+
+
+Eval_Value Unary_Eval_Task::eval_value(const Element_With_Context< Attic< Way_Skeleton > >& data, const std::string* key) const
+{
+  return evaluator->process_value(rhs ? rhs->eval_value(data, key) : Eval_Value());
+}
+
+
+Eval_Value Unary_Eval_Task::eval_value(const Element_With_Context< Relation_Skeleton >& data, const std::string* key) const
+{
+  return evaluator->process_value(rhs ? rhs->eval_value(data, key) : Eval_Value());
+}
+
+
+Eval_Value Unary_Eval_Task::eval_value(const Element_With_Context< Attic< Relation_Skeleton > >& data, const std::string* key) const
+{
+  return evaluator->process_value(rhs ? rhs->eval_value(data, key) : Eval_Value());
+}
+
+
+Eval_Value Unary_Eval_Task::eval_value(const Element_With_Context< Area_Skeleton >& data, const std::string* key) const
+{
+  return evaluator->process_value(rhs ? rhs->eval_value(data, key) : Eval_Value());
+}
+
+
+Eval_Value Unary_Eval_Task::eval_value(const Element_With_Context< Derived_Skeleton >& data, const std::string* key) const
+{
+  return evaluator->process_value(rhs ? rhs->eval_value(data, key) : Eval_Value());
 }
 
 
@@ -216,6 +280,15 @@ Eval_Task* Evaluator_Binary_Function::get_string_task(Prepare_Task_Context& cont
 {
   Eval_Task* first_task = first ? first->get_string_task(context, key) : 0;
   Eval_Task* second_task = second ? second->get_string_task(context, key) : 0;
+
+  if (dynamic_cast< Const_Eval_Task* >(first_task) && dynamic_cast< Const_Eval_Task* >(second_task))
+  {
+    std::string result = process(first_task->eval(key), second_task->eval(key));
+    delete first_task;
+    delete second_task;
+    return new Const_Eval_Task(result);
+  }
+
   return new Binary_Func_Eval_Task(first_task, second_task, this);
 }
 
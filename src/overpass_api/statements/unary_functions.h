@@ -39,6 +39,9 @@ public:
   virtual Eval_Task* get_string_task(Prepare_Task_Context& context, const std::string* key);
 
   virtual std::string process(const std::string& rhs_result) const = 0;
+  // Operators on numbers override this to avoid the conversion to and from strings
+  virtual Eval_Value process_value(const Eval_Value& rhs_result) const
+      { return Eval_Value(process(rhs_result.as_string())); }
 
 protected:
   Evaluator* rhs;
@@ -61,6 +64,17 @@ struct Unary_Eval_Task : public Eval_Task
   virtual std::string eval(const Element_With_Context< Area_Skeleton >& data, const std::string* key) const;
   virtual std::string eval(const Element_With_Context< Derived_Skeleton >& data, const std::string* key) const;
 
+  virtual Eval_Value eval_value(const std::string* key) const;
+
+  virtual Eval_Value eval_value(const Element_With_Context< Node_Skeleton >& data, const std::string* key) const;
+  virtual Eval_Value eval_value(const Element_With_Context< Attic< Node_Skeleton > >& data, const std::string* key) const;
+  virtual Eval_Value eval_value(const Element_With_Context< Way_Skeleton >& data, const std::string* key) const;
+  virtual Eval_Value eval_value(const Element_With_Context< Attic< Way_Skeleton > >& data, const std::string* key) const;
+  virtual Eval_Value eval_value(const Element_With_Context< Relation_Skeleton >& data, const std::string* key) const;
+  virtual Eval_Value eval_value(const Element_With_Context< Attic< Relation_Skeleton > >& data, const std::string* key) const;
+  virtual Eval_Value eval_value(const Element_With_Context< Area_Skeleton >& data, const std::string* key) const;
+  virtual Eval_Value eval_value(const Element_With_Context< Derived_Skeleton >& data, const std::string* key) const;
+
 private:
   Eval_Task* rhs;
   Evaluator_Unary_Function* evaluator;
@@ -20,15 +20,18 @@
 #define DE__OSM3S___TEMPLATE_DB__BLOCK_BACKEND_H
 
 #include "file_blocks.h"
+#include "parallel_jobs.h"
 
 #include <cstring>
 #include <map>
 #include <set>
+#include <vector>
 
 
 struct Block_Backend_Basic_Ref
 {
-  Block_Backend_Basic_Ref(uint32 block_size, uint32 pos_) : buffer(block_size), count(0), pos(pos_) {}
+  Block_Backend_Basic_Ref(uint32 block_size, uint32 pos_)
+      : buffer(block_size), data(buffer.ptr), count(0), pos(pos_) {}
 
   uint32 get_pos() const { return pos; }
   void set_pos(uint32 pos_) { pos = pos_; }
@@ -37,19 +40,24 @@ struct Block_Backend_Basic_Ref
   void* get_load_target()
   {
     ++count;
+    data = buffer.ptr;
     return buffer.ptr;
   }
+  // The loaded block may live outside the own buffer, e.g. in a read-only file mapping
+  void set_loaded(void* data_) { data = (uint8*)data_; }
   Void_Pointer< uint8 >& get_buffer() { return buffer; }
   const Void_Pointer< uint8 >& get_buffer() const { return buffer; }
-  uint32 get_used_block_size() const { return *(uint32*)buffer.ptr; }
+  uint8* get_data() const { return data; }
+  uint32 get_used_block_size() const { return *(uint32*)data; }
 
-  void* get_ptr() const { return buffer.ptr + pos; }
+  void* get_ptr() const { return data + pos; }
   uint32 get_count() const { return count; }
 
 private:
   Block_Backend_Basic_Ref(const Block_Backend_Basic_Ref&);
 
   Void_Pointer< uint8 > buffer;
+  uint8* data;
   uint32 count;
   uint32 pos;
 };
@@ -66,6 +74,13 @@ public:
   const Object& object() const;
   typename Object::Id_Type id() const;
 
+  // Wraps the object in its on-disk representation without decoding it.
+  template< typename View >
+  View view() const;
+
+  // Same as target.push_back(object()), but does not keep a decoded copy in the handle.
+  void push_back_to(std::vector< Object >& target) const;
+
 private:
   void update_ptr() const;
 
@@ -106,6 +121,26 @@ typename Object::Id_Type Handle< Object >::id() const
 }
 
 
+template< typename Object >
+template< typename View >
+View Handle< Object >::view() const
+{
+  update_ptr();
+  return View(ptr);
+}
+
+
+template< typename Object >
+void Handle< Object >::push_back_to(std::vector< Object >& target) const
+{
+  update_ptr();
+  if (obj)
+    target.push_back(*obj);
+  else
+    target.push_back(Object(ptr));
+}
+
+
 template< typename Object >
 void Handle< Object >::update_ptr() const
 {
@@ -165,6 +200,8 @@ struct Block_Backend_Basic_Iterator : public Block_Backend_Basic_Ref
   uint32* current_idx_pos;
   TIndex* current_index;
   Handle< TObject > object_handle;
+  // Number of blocks to read until the next read ahead request
+  uint32 prefetch_countdown;
 };
 
 template< class TIndex, class TObject, class TIterator >
@@ -276,6 +313,10 @@ private:
   bool read_block();
 };
 
+// Number of blocks that discrete and range iterators request ahead of the current block.
+// Then the disk can work on them while the current block is processed.
+const uint32 BLOCK_BACKEND_PREFETCH_WINDOW = 16;
+
 template< class TIndex, class TObject >
 struct Empty_Update_Logger
 {
@@ -308,6 +349,20 @@ struct Block_Backend
         { return Range_Iterator(file_blocks, begin, end, block_size); }
     const Range_Iterator& range_end() const { return *range_end_it; }
 
+    /* Reads the objects from the ranges [begin, end) that match the predicate and appends them to result.
+     * The ranges are split into shards of adjacent ranges with roughly the same number of blocks.
+     * Each shard is read on up to max_threads threads with its own File_Blocks, and the shards are
+     * merged in index order. Hence the result is the same as if the ranges had been read sequentially.
+     * The ranges must be disjoint. The blocks read by the shards are added to read_count().
+     *
+     * Every 256k objects health_check is called with the result of the shard so far, possibly
+     * from a worker thread. If it returns false then the reading of that shard stops. */
+    template< class Predicate, class Health_Check >
+    void read_ranges_parallel
+        (Default_Range_Iterator< TIndex > begin, Default_Range_Iterator< TIndex > end,
+         const Predicate& predicate, const Health_Check& health_check, uint max_threads,
+         std::map< TIndex, std::vector< TObject > >& result);
+
     template< class Update_Logger >
     void update
         (const std::map< TIndex, std::set< TObject > >& to_delete,
@@ -326,6 +381,7 @@ struct Block_Backend
     void reset_read_count() const { file_blocks.reset_read_count(); }
 
   private:
+    File_Blocks_Index_Base* index;
     File_Blocks_ file_blocks;
     Flat_Iterator* flat_end_it;
     Discrete_Iterator* discrete_end_it;
@@ -365,17 +421,21 @@ template< class TIndex, class TObject >
 Block_Backend_Basic_Iterator< TIndex, TObject >::
     Block_Backend_Basic_Iterator(uint32 block_size_, bool is_end)
     : Block_Backend_Basic_Ref(block_size_, 0), block_size(block_size_),
-      current_idx_pos(0), current_index(0), object_handle(*this) {}
+      current_idx_pos(0), current_index(0), object_handle(*this), prefetch_countdown(0) {}
 
 
 template< class TIndex, class TObject >
 Block_Backend_Basic_Iterator< TIndex, TObject >::
     Block_Backend_Basic_Iterator(const Block_Backend_Basic_Iterator& it)
     : Block_Backend_Basic_Ref(it.block_size, it.get_pos()), block_size(it.block_size),
-      current_idx_pos(0), current_index(0), object_handle(*this)
+      current_idx_pos(0), current_index(0), object_handle(*this),
+      prefetch_countdown(it.prefetch_countdown)
 {
-  memcpy(get_buffer().ptr, it.get_buffer().ptr, block_size);
-  current_idx_pos = (uint32*)(get_buffer().ptr + ((uint8*)it.current_idx_pos - it.get_buffer().ptr));
+  if (it.get_data() == it.get_buffer().ptr)
+    memcpy(get_buffer().ptr, it.get_buffer().ptr, block_size);
+  else
+    set_loaded(it.get_data());
+  current_idx_pos = (uint32*)(get_data() + ((uint8*)it.current_idx_pos - it.get_data()));
 }
 
 
@@ -522,7 +582,7 @@ bool Block_Backend_Flat_Iterator< TIndex, TObject, TIterator >::read_block()
     return true;
   }
   this->set_pos(4);
-  file_blocks.read_block(file_it, this->get_load_target());
+  this->set_loaded(file_blocks.read_block_inplace(file_it, this->get_load_target()));
 
   return false;
 }
@@ -602,10 +662,11 @@ bool Block_Backend_Discrete_Iterator< TIndex, TObject, TIterator >::search_next_
   {
     this->inc_pos(4);
 
+    // the index is only decoded if it is requested, see index()
     if (this->current_index)
       delete this->current_index;
-    this->current_index = new TIndex(this->get_ptr());
-    while ((index_it != index_end) && (*index_it < *(this->current_index)))
+    this->current_index = 0;
+    while ((index_it != index_end) && Index_Data_Comparator< TIndex >::greater(this->get_ptr(), *index_it))
       ++index_it;
     if (index_it == index_end)
     {
@@ -614,14 +675,12 @@ bool Block_Backend_Discrete_Iterator< TIndex, TObject, TIterator >::search_next_
       this->set_pos(0);
       return true;
     }
-    if (*index_it == *(this->current_index))
+    if (Index_Data_Comparator< TIndex >::equal(this->get_ptr(), *index_it))
     {
       // we have reached the next valid index
       this->inc_pos(TIndex::size_of(this->get_ptr()));
       return true;
     }
-    delete this->current_index;
-    this->current_index = 0;
 
     this->set_pos(*(this->current_idx_pos));
     this->current_idx_pos = (uint32*)(this->get_ptr());
@@ -645,8 +704,14 @@ bool Block_Backend_Discrete_Iterator< TIndex, TObject, TIterator >::read_block()
     this->set_pos(0);
     return true;
   }
+  if (this->prefetch_countdown == 0)
+  {
+    file_blocks.prefetch(file_it, file_end, BLOCK_BACKEND_PREFETCH_WINDOW);
+    this->prefetch_countdown = BLOCK_BACKEND_PREFETCH_WINDOW;
+  }
+  --this->prefetch_countdown;
   this->set_pos(4);
-  file_blocks.read_block(file_it, this->get_load_target());
+  this->set_loaded(file_blocks.read_block_inplace(file_it, this->get_load_target()));
 
   return false;
 }
@@ -724,11 +789,12 @@ bool Block_Backend_Range_Iterator< TIndex, TObject, TIterator >::search_next_ind
   {
     this->inc_pos(4);
 
+    // the index is only decoded if it is requested, see index()
     if (this->current_index)
       delete this->current_index;
-    this->current_index = new TIndex(this->get_ptr());
+    this->current_index = 0;
     while ((index_it != index_end) &&
-      (!(*(this->current_index) < index_it.upper_bound())))
+      (!Index_Data_Comparator< TIndex >::less(this->get_ptr(), index_it.upper_bound())))
       ++(index_it);
     if (index_it == index_end)
     {
@@ -737,14 +803,12 @@ bool Block_Backend_Range_Iterator< TIndex, TObject, TIterator >::search_next_ind
       this->set_pos(0);
       return true;
     }
-    if (!(*(this->current_index) < index_it.lower_bound()))
+    if (!Index_Data_Comparator< TIndex >::less(this->get_ptr(), index_it.lower_bound()))
     {
       // we have reached the next valid index
       this->inc_pos(TIndex::size_of(this->get_ptr()));
       return true;
     }
-    delete this->current_index;
-    this->current_index = 0;
 
     this->set_pos(*(this->current_idx_pos));
     this->current_idx_pos = (uint32*)(this->get_ptr());
@@ -764,8 +828,14 @@ bool Block_Backend_Range_Iterator< TIndex, TObject, TIterator >::read_block()
     this->set_pos(0);
     return true;
   }
+  if (this->prefetch_countdown == 0)
+  {
+    file_blocks.prefetch(file_it, file_end, BLOCK_BACKEND_PREFETCH_WINDOW);
+    this->prefetch_countdown = BLOCK_BACKEND_PREFETCH_WINDOW;
+  }
+  --this->prefetch_countdown;
   this->set_pos(4);
-  file_blocks.read_block(file_it, this->get_load_target());
+  this->set_loaded(file_blocks.read_block_inplace(file_it, this->get_load_target()));
 
   return false;
 }
@@ -774,7 +844,7 @@ bool Block_Backend_Range_Iterator< TIndex, TObject, TIterator >::read_block()
 
 template< class TIndex, class TObject, class TIterator >
 Block_Backend< TIndex, TObject, TIterator >::Block_Backend(File_Blocks_Index_Base* index_)
-  : file_blocks(index_),
+  : index(index_), file_blocks(index_),
     block_size(((File_Blocks_Index< TIndex >*)index_)->get_block_size()
         * ((File_Blocks_Index< TIndex >*)index_)->get_compression_factor()),
     data_filename
@@ -793,6 +863,126 @@ Block_Backend< TIndex, TObject, TIterator >::~Block_Backend()
   delete range_end_it;
 }
 
+template< class TIndex, class TObject, class Predicate, class Health_Check >
+struct Block_Backend_Range_Job : public Parallel_Job
+{
+  Block_Backend_Range_Job
+      (File_Blocks_Index_Base* index_,
+       Default_Range_Iterator< TIndex > begin_, Default_Range_Iterator< TIndex > end_,
+       const Predicate& predicate_, const Health_Check& health_check_)
+      : index(index_), begin(begin_), end(end_), predicate(&predicate_), health_check(&health_check_),
+        read_count(0) {}
+
+  virtual void run()
+  {
+    Block_Backend< TIndex, TObject > db(index);
+    uint32 count = 0;
+    for (typename Block_Backend< TIndex, TObject >::Range_Iterator it(db.range_begin(begin, end));
+        !(it == db.range_end()); ++it)
+    {
+      if (++count >= 256*1024)
+      {
+        count = 0;
+        if (!(*health_check)(result))
+          break;
+      }
+      if (predicate->match(it.handle()))
+        it.handle().push_back_to(result[it.index()]);
+    }
+    read_count = db.read_count();
+  }
+
+  File_Blocks_Index_Base* index;
+  Default_Range_Iterator< TIndex > begin;
+  Default_Range_Iterator< TIndex > end;
+  const Predicate* predicate;
+  const Health_Check* health_check;
+  std::map< TIndex, std::vector< TObject > > result;
+  uint read_count;
+};
+
+
+template< class TIndex, class TObject, class TIterator >
+template< class Predicate, class Health_Check >
+void Block_Backend< TIndex, TObject, TIterator >::read_ranges_parallel
+    (Default_Range_Iterator< TIndex > begin, Default_Range_Iterator< TIndex > end,
+     const Predicate& predicate, const Health_Check& health_check, uint max_threads,
+     std::map< TIndex, std::vector< TObject > >& result)
+{
+  // Weigh each range by the number of blocks that start within it
+  const std::list< File_Block_Index_Entry< TIndex > >& blocks
+      = ((File_Blocks_Index< TIndex >*)index)->get_blocks();
+  typename std::list< File_Block_Index_Entry< TIndex > >::const_iterator block_it = blocks.begin();
+  std::vector< uint64 > weights;
+  uint64 total_weight = 0;
+  for (Default_Range_Iterator< TIndex > it = begin; !(it == end); ++it)
+  {
+    while (block_it != blocks.end() && block_it->index < it.lower_bound())
+      ++block_it;
+    uint64 weight = 1;
+    for (typename std::list< File_Block_Index_Entry< TIndex > >::const_iterator
+        inner_it = block_it; inner_it != blocks.end() && inner_it->index < it.upper_bound(); ++inner_it)
+      ++weight;
+    weights.push_back(weight);
+    total_weight += weight;
+  }
+
+  // A shard may only end where no earlier range reaches into the next one
+  uint64 shard_weight = std::max(total_weight / (std::max(max_threads, 1u) * 4), (uint64)1);
+  std::vector< Block_Backend_Range_Job< TIndex, TObject, Predicate, Health_Check >* > shards;
+  Default_Range_Iterator< TIndex > shard_begin = begin;
+  const TIndex* upper_bound = 0;
+  uint64 weight = 0;
+  std::vector< uint64 >::const_iterator weight_it = weights.begin();
+  for (Default_Range_Iterator< TIndex > it = begin; !(it == end); ++it)
+  {
+    if (weight >= shard_weight && !(it.lower_bound() < *upper_bound))
+    {
+      shards.push_back(new Block_Backend_Range_Job< TIndex, TObject, Predicate, Health_Check >
+          (index, shard_begin, it, predicate, health_check));
+      shard_begin = it;
+      weight = 0;
+    }
+    if (!upper_bound || *upper_bound < it.upper_bound())
+      upper_bound = &it.upper_bound();
+    weight += *(weight_it++);
+  }
+  if (!(shard_begin == end))
+    shards.push_back(new Block_Backend_Range_Job< TIndex, TObject, Predicate, Health_Check >
+        (index, shard_begin, end, predicate, health_check));
+
+  try
+  {
+    std::vector< Parallel_Job* > jobs(shards.begin(), shards.end());
+    run_parallel_jobs(jobs, max_threads);
+  }
+  catch (...)
+  {
+    for (typename std::vector< Block_Backend_Range_Job< TIndex, TObject, Predicate, Health_Check >* >
+        ::const_iterator it = shards.begin(); it != shards.end(); ++it)
+      delete *it;
+    throw;
+  }
+
+  for (typename std::vector< Block_Backend_Range_Job< TIndex, TObject, Predicate, Health_Check >* >
+      ::const_iterator it = shards.begin(); it != shards.end(); ++it)
+  {
+    // The shards read through their own File_Blocks
+    file_blocks.add_read_count((*it)->read_count);
+    for (typename std::map< TIndex, std::vector< TObject > >::iterator
+        rit = (*it)->result.begin(); rit != (*it)->result.end(); ++rit)
+    {
+      std::vector< TObject >& target = result[rit->first];
+      if (target.empty())
+        target.swap(rit->second);
+      else
+        target.insert(target.end(), rit->second.begin(), rit->second.end());
+    }
+    delete *it;
+  }
+}
+
+
 template< class TIndex, class TObject, class TIterator >
 template< class Update_Logger >
 void Block_Backend< TIndex, TObject, TIterator >::update
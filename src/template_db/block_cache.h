@@ -0,0 +1,350 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DE__OSM3S___TEMPLATE_DB__BLOCK_CACHE_H
+#define DE__OSM3S___TEMPLATE_DB__BLOCK_CACHE_H
+
+#include "types.h"
+
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+
+/* A cache of decompressed file blocks in shared memory. The dispatcher creates it and
+ * announces every commit as a new generation. Reading processes attach to it and pin
+ * the generation that was current when they have read their index files.
+ *
+ * A block is identified by its file, its position in the file, and the generation.
+ * The cache is organized in sets of a few slots each. Eviction is least recently used
+ * within the set. Slots are as large as the largest decompressed block, but only the used
+ * part of each block is written, so untouched pages of the shared memory stay unallocated. */
+class Shared_Block_Cache
+{
+  Shared_Block_Cache(const Shared_Block_Cache&);
+  Shared_Block_Cache& operator=(const Shared_Block_Cache&);
+
+public:
+  static const uint32 SLOT_SIZE = 2*1024*1024;
+  static const uint32 WAYS = 8;
+
+  /** Creates the shared memory. To be called by the dispatcher only. */
+  Shared_Block_Cache(const std::string& shm_name, uint64 total_size);
+
+  /** Attaches to an existing shared memory and pins the current generation.
+      Throws File_Error if there is no cache. */
+  explicit Shared_Block_Cache(const std::string& shm_name);
+
+  ~Shared_Block_Cache();
+
+  static uint64 file_id(const std::string& file_name);
+
+  // Copies the block to target and returns true if it is in the cache.
+  bool get(uint64 file_id, uint32 pos, void* target, uint32 target_size);
+  void put(uint64 file_id, uint32 pos, const void* source, uint32 size);
+
+  void next_generation();
+  /** Pins the generation that is current now. To be called by reading processes
+      right before they read the index files. */
+  void pin_generation();
+  uint32 get_generation() const { return generation; }
+  uint64 get_total_size() const { return total_size; }
+  uint64 get_hits() const { return header ? header->hits : 0; }
+  uint64 get_misses() const { return header ? header->misses : 0; }
+
+private:
+  struct Header
+  {
+    uint32 magic;
+    uint32 num_sets;
+    uint32 generation;
+    uint32 padding;
+    uint64 clock;
+    uint64 hits;
+    uint64 misses;
+    pthread_mutex_t mutex;
+  };
+
+  struct Slot
+  {
+    uint64 file_id;
+    uint32 pos;
+    uint32 generation;
+    uint32 size;
+    uint32 sequence;
+    uint64 last_used;
+  };
+
+  static const uint32 MAGIC = 0x6f736d63;
+
+  std::string shm_name;
+  bool is_owner;
+  int shm_fd;
+  uint64 total_size;
+  uint8* shm_ptr;
+  Header* header;
+  uint32 generation;
+
+  Slot* slots() const { return (Slot*)(shm_ptr + 4096); }
+  uint8* slot_data(uint32 slot_idx) const
+  { return shm_ptr + layout_size(header->num_sets) + (uint64)slot_idx * SLOT_SIZE; }
+  Slot* find_set(uint64 file_id, uint32 pos) const;
+  void lock();
+  void unlock() { pthread_mutex_unlock(&header->mutex); }
+
+  static uint64 layout_size(uint32 num_sets)
+  { return (4096 + (uint64)num_sets * WAYS * sizeof(Slot) + 4095) / 4096 * 4096; }
+};
+
+
+//-----------------------------------------------------------------------------
+
+
+inline Shared_Block_Cache::Shared_Block_Cache(const std::string& shm_name_, uint64 total_size_)
+  : shm_name(shm_name_), is_owner(true), shm_fd(-1), total_size(0), shm_ptr(0), header(0), generation(0)
+{
+  uint32 num_sets = total_size_ / SLOT_SIZE / WAYS;
+  if (num_sets == 0)
+    num_sets = 1;
+  total_size = layout_size(num_sets) + (uint64)num_sets * WAYS * SLOT_SIZE;
+
+  shm_unlink(shm_name.c_str());
+  shm_fd = shm_open(shm_name.c_str(), O_RDWR|O_CREAT|O_TRUNC|O_EXCL, S_666);
+  if (shm_fd < 0)
+    throw File_Error(errno, shm_name, "Shared_Block_Cache::1");
+  fchmod(shm_fd, S_666);
+  if (ftruncate(shm_fd, total_size) != 0)
+    throw File_Error(errno, shm_name, "Shared_Block_Cache::2");
+  shm_ptr = (uint8*)mmap(0, total_size, PROT_READ|PROT_WRITE, MAP_SHARED, shm_fd, 0);
+  if (shm_ptr == MAP_FAILED)
+  {
+    shm_ptr = 0;
+    throw File_Error(errno, shm_name, "Shared_Block_Cache::3");
+  }
+
+  header = (Header*)shm_ptr;
+  header->num_sets = num_sets;
+  header->generation = 0;
+  header->clock = 0;
+  header->hits = 0;
+  header->misses = 0;
+
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+#ifndef __APPLE__
+  // A reading process may be killed while it holds the lock
+  pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+#endif
+  pthread_mutex_init(&header->mutex, &attr);
+  pthread_mutexattr_destroy(&attr);
+
+  // The shared memory is zero-filled, hence all slots are empty.
+  header->magic = MAGIC;
+}
+
+
+inline Shared_Block_Cache::Shared_Block_Cache(const std::string& shm_name_)
+  : shm_name(shm_name_), is_owner(false), shm_fd(-1), total_size(0), shm_ptr(0), header(0), generation(0)
+{
+  shm_fd = shm_open(shm_name.c_str(), O_RDWR, S_666);
+  if (shm_fd < 0)
+    throw File_Error(errno, shm_name, "Shared_Block_Cache::4");
+
+  struct stat stat_buf;
+  if (fstat(shm_fd, &stat_buf) != 0 || (uint64)stat_buf.st_size < 4096)
+  {
+    close(shm_fd);
+    throw File_Error(errno, shm_name, "Shared_Block_Cache::5");
+  }
+  total_size = stat_buf.st_size;
+  shm_ptr = (uint8*)mmap(0, total_size, PROT_READ|PROT_WRITE, MAP_SHARED, shm_fd, 0);
+  if (shm_ptr == MAP_FAILED)
+  {
+    shm_ptr = 0;
+    close(shm_fd);
+    throw File_Error(errno, shm_name, "Shared_Block_Cache::6");
+  }
+
+  header = (Header*)shm_ptr;
+  if (header->magic != MAGIC
+      || layout_size(header->num_sets) + (uint64)header->num_sets * WAYS * SLOT_SIZE > total_size)
+  {
+    munmap(shm_ptr, total_size);
+    close(shm_fd);
+    throw File_Error(0, shm_name, "Shared_Block_Cache::7");
+  }
+
+  pin_generation();
+}
+
+
+inline Shared_Block_Cache::~Shared_Block_Cache()
+{
+  if (shm_ptr)
+    munmap(shm_ptr, total_size);
+  if (shm_fd >= 0)
+    close(shm_fd);
+  if (is_owner)
+    shm_unlink(shm_name.c_str());
+}
+
+
+inline uint64 Shared_Block_Cache::file_id(const std::string& file_name)
+{
+  // FNV-1a
+  uint64 hash = 14695981039346656037ull;
+  for (std::string::size_type i = 0; i < file_name.size(); ++i)
+  {
+    hash ^= (uint8)file_name[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+
+inline void Shared_Block_Cache::lock()
+{
+  int result = pthread_mutex_lock(&header->mutex);
+#ifndef __APPLE__
+  if (result == EOWNERDEAD)
+    // Slots are invalidated before they are written, so the state is consistent
+    pthread_mutex_consistent(&header->mutex);
+#endif
+}
+
+
+inline Shared_Block_Cache::Slot* Shared_Block_Cache::find_set(uint64 file_id, uint32 pos) const
+{
+  uint64 hash = (file_id ^ ((uint64)pos * 0x9e3779b97f4a7c15ull));
+  hash ^= (hash>>29);
+  return slots() + (hash % header->num_sets) * WAYS;
+}
+
+
+inline bool Shared_Block_Cache::get(uint64 file_id, uint32 pos, void* target, uint32 target_size)
+{
+  if (!header)
+    return false;
+
+  lock();
+  Slot* set = find_set(file_id, pos);
+  Slot* found = 0;
+  for (uint32 i = 0; i < WAYS; ++i)
+  {
+    if (set[i].size > 0 && set[i].file_id == file_id && set[i].pos == pos
+        && set[i].generation == generation && set[i].size <= target_size)
+    {
+      set[i].last_used = ++header->clock;
+      found = set + i;
+      break;
+    }
+  }
+  if (!found)
+  {
+    ++header->misses;
+    unlock();
+    return false;
+  }
+  uint32 sequence = found->sequence;
+  uint32 size = found->size;
+  unlock();
+
+  // The copy runs without the lock. A put() into the same slot in the meantime
+  // changes the sequence number, and then the copy is discarded.
+  memcpy(target, slot_data(found - slots()), size);
+
+  lock();
+  bool valid = (found->sequence == sequence && found->size == size);
+  if (valid)
+    ++header->hits;
+  else
+    ++header->misses;
+  unlock();
+  return valid;
+}
+
+
+inline void Shared_Block_Cache::put(uint64 file_id, uint32 pos, const void* source, uint32 size)
+{
+  if (!header || size == 0 || size > SLOT_SIZE)
+    return;
+
+  lock();
+  Slot* set = find_set(file_id, pos);
+  Slot* victim = set;
+  for (uint32 i = 0; i < WAYS; ++i)
+  {
+    if (set[i].size > 0 && set[i].file_id == file_id && set[i].pos == pos
+        && set[i].generation == generation)
+    {
+      // Another process has been faster
+      unlock();
+      return;
+    }
+    // Empty slots and slots of outdated generations have priority for reuse
+    if (set[i].size == 0 || set[i].generation != header->generation)
+    {
+      if (victim->size > 0 && victim->generation == header->generation)
+        victim = set + i;
+    }
+    else if (victim->size > 0 && victim->generation == header->generation
+        && set[i].last_used < victim->last_used)
+      victim = set + i;
+  }
+
+  victim->size = 0;
+  ++victim->sequence;
+  memcpy(slot_data(victim - slots()), source, size);
+  victim->file_id = file_id;
+  victim->pos = pos;
+  victim->generation = generation;
+  victim->last_used = ++header->clock;
+  victim->size = size;
+  unlock();
+}
+
+
+inline void Shared_Block_Cache::next_generation()
+{
+  if (!header)
+    return;
+
+  lock();
+  ++header->generation;
+  generation = header->generation;
+  unlock();
+}
+
+
+inline void Shared_Block_Cache::pin_generation()
+{
+  if (!header)
+    return;
+
+  lock();
+  generation = header->generation;
+  unlock();
+}
+
+
+#endif
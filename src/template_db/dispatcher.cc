@@ -20,6 +20,7 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <signal.h>
 #include <sys/mman.h>
 #include <sys/select.h>
@@ -106,6 +107,37 @@ void Dispatcher_Socket::look_for_a_new_connection(Connection_Per_Pid_Map& connec
 }
 
 
+bool Dispatcher_Socket::wait_for_activity
+    (const Connection_Per_Pid_Map& connection_per_pid, uint32 milliseconds)
+{
+  std::vector< pollfd > fds;
+  pollfd entry;
+  entry.events = POLLIN;
+  entry.revents = 0;
+
+  entry.fd = socket.descriptor();
+  fds.push_back(entry);
+  for (std::vector< int >::const_iterator it = started_connections.begin();
+      it != started_connections.end(); ++it)
+  {
+    entry.fd = *it;
+    fds.push_back(entry);
+  }
+  for (std::map< Connection_Per_Pid_Map::pid_t, Blocking_Client_Socket* >::const_iterator
+      it = connection_per_pid.base_map().begin();
+      it != connection_per_pid.base_map().end(); ++it)
+  {
+    entry.fd = it->second->descriptor();
+    fds.push_back(entry);
+  }
+
+  int result = poll(&fds[0], fds.size(), milliseconds);
+  if (result == -1 && errno != EINTR)
+    throw File_Error(errno, "(socket)", "Dispatcher_Socket::wait_for_activity");
+  return result != 0;
+}
+
+
 int Global_Resource_Planner::probe(pid_t pid, uint32 client_token, uint32 time_units, uint64 max_space)
 {
   std::map< uint32, std::vector< Pending_Client > >::iterator pending_it = pending.find(client_token);
@@ -366,16 +398,17 @@ Dispatcher::Dispatcher
      uint64 total_available_space_,
      uint64 total_available_time_units_,
      const std::vector< File_Properties* >& controlled_files_,
-     Dispatcher_Logger* logger_)
+     Dispatcher_Logger* logger_,
+     const std::string& version_file_)
     : socket(dispatcher_share_name_, shadow_name_, db_dir_, max_num_reading_processes_),
-      transaction_insulator(db_dir_, controlled_files_),
+      transaction_insulator(db_dir_, controlled_files_, version_file_),
       shadow_name(shadow_name_),
       dispatcher_share_name(dispatcher_share_name_),
       logger(logger_),
-      pending_commit(false),
       requests_started_counter(0),
       requests_finished_counter(0),
-      global_resource_planner(total_available_time_units_, total_available_space_, 0)
+      global_resource_planner(total_available_time_units_, total_available_space_, 0),
+      block_cache(0)
 {
   signal(SIGPIPE, SIG_IGN);
 
@@ -415,10 +448,12 @@ Dispatcher::Dispatcher
 
   // Set command state to zero.
   *(uint32*)dispatcher_shm_ptr = 0;
+  index_generation() = 0;
 
   if (file_exists(shadow_name))
   {
-    transaction_insulator.copy_shadows_to_mains();
+    transaction_insulator.stage_shadows_as_mains();
+    transaction_insulator.publish_staged_mains();
     remove(shadow_name.c_str());
   }
   transaction_insulator.remove_shadows();
@@ -429,6 +464,7 @@ Dispatcher::Dispatcher
 
 Dispatcher::~Dispatcher()
 {
+  delete block_cache;
   munmap((void*)dispatcher_shm_ptr, SHM_SIZE + transaction_insulator.db_dir().size() + shadow_name.size());
   shm_unlink(dispatcher_share_name.c_str());
 }
@@ -485,20 +521,13 @@ void Dispatcher::write_rollback(pid_t pid)
 
 void Dispatcher::write_commit(pid_t pid)
 {
-  if (!processes_reading_idx.empty())
-  {
-    pending_commit = true;
-    return;
-  }
-  pending_commit = false;
-
   if (logger)
     logger->write_commit(pid);
   try
   {
     Raw_File shadow_file(shadow_name, O_RDWR|O_CREAT|O_EXCL, S_666, "write_commit:1");
 
-    transaction_insulator.copy_shadows_to_mains();
+    transaction_insulator.stage_shadows_as_mains();
   }
   catch (File_Error e)
   {
@@ -506,10 +535,42 @@ void Dispatcher::write_commit(pid_t pid)
     return;
   }
 
+  // Reading processes compare the generation before and after they read the index files.
+  // Only the renames happen while it is odd, so they never wait long.
+  ++index_generation();
+  try
+  {
+    transaction_insulator.publish_staged_mains();
+  }
+  catch (File_Error e)
+  {
+    ++index_generation();
+    std::cerr<<"File_Error "<<e.error_number<<' '<<strerror(e.error_number)<<' '<<e.filename<<' '<<e.origin<<'\n';
+    return;
+  }
+  // Freed blocks may be reused from now on
+  if (block_cache)
+    block_cache->next_generation();
+  ++index_generation();
+
   remove(shadow_name.c_str());
   transaction_insulator.remove_shadows();
   remove((shadow_name + ".lock").c_str());
   transaction_insulator.set_current_footprints();
+
+  // A process that is reading the index files may get either generation
+  for (std::set< pid_t >::const_iterator it = processes_reading_idx.begin();
+      it != processes_reading_idx.end(); ++it)
+    transaction_insulator.extend_footprints(*it);
+}
+
+
+void Dispatcher::set_block_cache_size(uint64 total_size)
+{
+  delete block_cache;
+  block_cache = 0;
+  if (total_size > 0)
+    block_cache = new Shared_Block_Cache(block_cache_name(dispatcher_share_name), total_size);
 }
 
 
@@ -578,9 +639,11 @@ void Dispatcher::standby_loop(uint64 milliseconds)
 
     if (command == 0)
     {
-      ++counter;
+      // Wake up as soon as a client sends something. A connection that becomes readable
+      // always yields a command or a state change in the next round.
       ++idle_counter;
-      millisleep(idle_counter < 10 ? idle_counter*10 : 100);
+      if (!socket.wait_for_activity(connection_per_pid, 100))
+        ++counter;
       continue;
     }
 
@@ -650,12 +713,6 @@ void Dispatcher::standby_loop(uint64 milliseconds)
 	uint64 max_allowed_space = (((uint64)arguments[2])<<32 | arguments[1]);
 	uint32 client_token = arguments[3];
 
-	if (pending_commit)
-	{
-	  connection_per_pid.get(client_pid)->send_result(0);
-	  continue;
-	}
-
 	command = global_resource_planner.probe(client_pid, client_token, max_allowed_time, max_allowed_space);
 	if (command == REQUEST_READ_AND_IDX)
 	  request_read_and_idx(client_pid, max_allowed_time, max_allowed_space, client_token);
@@ -788,6 +845,11 @@ void Dispatcher::output_status()
         <<"Average claimed time units: "<<global_resource_planner.get_average_claimed_time()<<'\n'
         <<"Counter of started requests: "<<requests_started_counter<<'\n'
         <<"Counter of finished requests: "<<requests_finished_counter<<'\n';
+    if (block_cache)
+      status<<"Block cache size: "<<block_cache->get_total_size()<<'\n'
+          <<"Block cache generation: "<<block_cache->get_generation()<<'\n'
+          <<"Block cache hits: "<<block_cache->get_hits()<<'\n'
+          <<"Block cache misses: "<<block_cache->get_misses()<<'\n';
 
     std::set< ::pid_t > collected_pids = transaction_insulator.registered_pids();
 
@@ -804,7 +866,8 @@ void Dispatcher::output_status()
       collected_pids.insert(it->client_pid);
     }
 
-    for (std::map< pid_t, Blocking_Client_Socket* >::const_iterator it = connection_per_pid.base_map().begin();
+    for (std::map< Connection_Per_Pid_Map::pid_t, Blocking_Client_Socket* >::const_iterator
+      it = connection_per_pid.base_map().begin();
 	 it != connection_per_pid.base_map().end(); ++it)
     {
       if (processes_reading_idx.find(it->first) == processes_reading_idx.end()
@@ -19,6 +19,7 @@
 #ifndef DE__OSM3S___TEMPLATE_DB__DISPATCHER_H
 #define DE__OSM3S___TEMPLATE_DB__DISPATCHER_H
 
+#include "block_cache.h"
 #include "file_tools.h"
 #include "types.h"
 #include "transaction_insulator.h"
@@ -148,6 +149,10 @@ public:
   ~Dispatcher_Socket();
 
   void look_for_a_new_connection(Connection_Per_Pid_Map& connection_per_pid);
+
+  // Blocks until a new connection or a connected client has something to read,
+  // but at most for the given time. Returns false if the time has expired.
+  bool wait_for_activity(const Connection_Per_Pid_Map& connection_per_pid, uint32 milliseconds);
   std::vector< int >::size_type num_started_connections() { return started_connections.size(); }
 
 private:
@@ -166,6 +171,8 @@ class Dispatcher
     static const int OFFSET_BACK = 20;
     static const int OFFSET_DB_1 = OFFSET_BACK+12;
     static const int OFFSET_DB_2 = OFFSET_DB_1+(256+4);
+    // Counts the commits twice: it is odd while a commit replaces the index files.
+    static const int OFFSET_INDEX_GENERATION = sizeof(uint32);
 
     static const uint32 TERMINATE = 1;
     static const uint32 OUTPUT_STATUS = 2;
@@ -193,7 +200,9 @@ class Dispatcher
 
     /** Opens a shared memory for dispatcher communication. Furthermore,
       * detects whether idx or idy are valid, clears to idx if necessary,
-      * and loads them into the shared memory idx_share_name. */
+      * and loads them into the shared memory idx_share_name.
+      * If version_file is not empty then a file of that name in db_dir
+      * is replaced by its ".shadow" copy on each commit, together with the index files. */
     Dispatcher(std::string dispatcher_share_name,
 	       std::string index_share_name,
 	       std::string shadow_name,
@@ -202,7 +211,8 @@ class Dispatcher
 	       uint64 total_available_space,
 	       uint64 total_available_time_units,
 	       const std::vector< File_Properties* >& controlled_files,
-	       Dispatcher_Logger* logger = 0);
+	       Dispatcher_Logger* logger = 0,
+	       const std::string& version_file = "");
 
     ~Dispatcher();
 
@@ -216,16 +226,18 @@ class Dispatcher
         index file. */
     void write_rollback(pid_t pid);
 
-    /** Copies the shadow files onto the main index files. A lock prevents
-        that incomplete copies after a crash may leave the database in an
-	unstable state. Removes the mutex for the write process. */
+    /** Replaces the main index files by the shadow files. Each file is replaced
+        in a single step and the index generation announces the change, hence reading
+        processes need not to be waited for. A lock prevents that incomplete copies after
+        a crash may leave the database in an unstable state. Removes the mutex for the
+        write process. */
     void write_commit(pid_t pid);
 
     /** Read operations: --------------------------------------------------- */
 
     /** Request the index for a read operation and registers the reading process.
-        Reading the index files should be taking a quick copy, because if any process
-	is in this state, write_commits are blocked. */
+        The blocks of all index generations committed while the process is in this state
+        are kept for it. */
     void request_read_and_idx(pid_t pid, uint32 max_allowed_time, uint64 max_allowed_space,
 			      uint32 client_token);
 
@@ -252,6 +264,13 @@ class Dispatcher
     /** Set the limit of simultaneous queries from a single IP address. */
     void set_rate_limit(uint rate_limit) { global_resource_planner.set_rate_limit(rate_limit); }
 
+    /** Offers reading processes a shared cache of decompressed blocks with the given total size
+        in bytes. The size zero disables the cache. */
+    void set_block_cache_size(uint64 total_size);
+
+    static std::string block_cache_name(const std::string& dispatcher_share_name)
+    { return dispatcher_share_name + "_block_cache"; }
+
   private:
     Dispatcher_Socket socket;
     Connection_Per_Pid_Map connection_per_pid;
@@ -263,10 +282,13 @@ class Dispatcher
     volatile uint8* dispatcher_shm_ptr;
     Dispatcher_Logger* logger;
     std::set< pid_t > disconnected;
-    bool pending_commit;
     uint32 requests_started_counter;
     uint32 requests_finished_counter;
     Global_Resource_Planner global_resource_planner;
+    Shared_Block_Cache* block_cache;
+
+    volatile uint32& index_generation()
+    { return *(volatile uint32*)(dispatcher_shm_ptr + OFFSET_INDEX_GENERATION); }
 
     uint64 total_claimed_space() const;
     uint64 total_claimed_time_units() const;
@@ -449,6 +449,25 @@ void sync_log(const std::string& message)
   out<<message;
 }
 
+void print_version(const std::string& file_name)
+{
+  if (!file_exists(BASE_DIRECTORY + file_name))
+  {
+    std::cout<<file_name<<" doesn't exist.\n";
+    return;
+  }
+  std::string version;
+  std::ifstream in((BASE_DIRECTORY + file_name).c_str());
+  getline(in, version);
+  std::cout<<file_name<<": "<<version<<'\n';
+}
+
+void write_version(const std::string& version)
+{
+  std::ofstream out((BASE_DIRECTORY + "test_version.shadow").c_str());
+  out<<version<<'\n';
+}
+
 int main(int argc, char* args[])
 {
   std::string test_to_execute;
@@ -1539,4 +1558,40 @@ int main(int argc, char* args[])
           <<e.error_number<<' '<<e.filename<<' '<<e.origin<<'\n';
     }
   }
+
+  if ((test_to_execute == "") || (test_to_execute == "28"))
+  {
+    // The version file changes only on commit and together with the index files
+    Test_File test_file("Test_File");
+
+    std::vector< File_Properties* > file_properties;
+    file_properties.push_back(&test_file);
+    Dispatcher dispatcher("osm3s_share_test", "osm3s_index_share_test",
+			  BASE_DIRECTORY + "test-shadow", BASE_DIRECTORY,
+			  5, 180, 1024*1024*1024,  1024*1024, file_properties, 0, "test_version");
+    dispatcher.write_start(480);
+    put_elem(0, 1, test_file);
+    write_version("first");
+    print_version("test_version");
+    dispatcher.write_commit(0);
+    print_version("test_version");
+    print_version("test_version.shadow");
+
+    dispatcher.write_start(481);
+    put_elem(0, 2, test_file);
+    write_version("second");
+    dispatcher.write_rollback(0);
+    print_version("test_version");
+    print_version("test_version.shadow");
+
+    dispatcher.write_start(482);
+    put_elem(0, 3, test_file);
+    write_version("third");
+    dispatcher.write_commit(0);
+    print_version("test_version");
+    data_read_test(test_file);
+    remove("Test_File.bin");
+    remove("Test_File.bin.idx");
+    remove("test_version");
+  }
 }
@@ -35,7 +35,7 @@
 
 Dispatcher_Client::Dispatcher_Client
     (const std::string& dispatcher_share_name_)
-    : dispatcher_share_name(dispatcher_share_name_), socket("")
+    : dispatcher_share_name(dispatcher_share_name_), socket(""), block_cache(0)
 {
   signal(SIGPIPE, SIG_IGN);
 
@@ -78,6 +78,7 @@ bool file_present(const std::string& full_path)
 
 Dispatcher_Client::~Dispatcher_Client()
 {
+  detach_block_cache();
   munmap((void*)dispatcher_shm_ptr,
 	 Dispatcher::SHM_SIZE + db_dir.size() + shadow_name.size());
   close(dispatcher_shm_fd);
@@ -169,7 +170,6 @@ void Dispatcher_Client::write_commit()
   pid_t pid = getpid();
 
   send_message(Dispatcher::WRITE_COMMIT, "Dispatcher_Client::write_commit::socket");
-  millisleep(200);
 
   while (true)
   {
@@ -214,7 +214,11 @@ void Dispatcher_Client::request_read_and_idx(uint32 max_allowed_time, uint64 max
 
     ack = ack_arrived();
     if (ack == Dispatcher::REQUEST_READ_AND_IDX)
+    {
+      // begin_index_snapshot() pins the cache again right before the index files are read
+      attach_block_cache();
       return;
+    }
 
     millisleep(300);
   }
@@ -225,6 +229,32 @@ void Dispatcher_Client::request_read_and_idx(uint32 max_allowed_time, uint64 max
 }
 
 
+uint32 Dispatcher_Client::begin_index_snapshot()
+{
+  volatile uint32* generation = (volatile uint32*)(dispatcher_shm_ptr + Dispatcher::OFFSET_INDEX_GENERATION);
+  uint32 result = *generation;
+  uint counter = 0;
+  while (result & 1)
+  {
+    // The dispatcher only renames files in the meantime. If it stays odd then the dispatcher
+    // has died while it committed.
+    if (++counter > 10000)
+      throw File_Error(0, dispatcher_share_name, "Dispatcher_Client::begin_index_snapshot::timeout");
+    millisleep(1);
+    result = *generation;
+  }
+  if (block_cache)
+    block_cache->pin_generation();
+  return result;
+}
+
+
+bool Dispatcher_Client::index_snapshot_valid(uint32 generation)
+{
+  return *(volatile uint32*)(dispatcher_shm_ptr + Dispatcher::OFFSET_INDEX_GENERATION) == generation;
+}
+
+
 void Dispatcher_Client::read_idx_finished()
 {
 //   *(uint32*)(dispatcher_shm_ptr + 2*sizeof(uint32)) = 0;
@@ -241,6 +271,27 @@ void Dispatcher_Client::read_idx_finished()
 }
 
 
+void Dispatcher_Client::attach_block_cache()
+{
+  detach_block_cache();
+  try
+  {
+    block_cache = new Shared_Block_Cache(Dispatcher::block_cache_name(dispatcher_share_name));
+  }
+  catch (File_Error e)
+  {
+    // The dispatcher runs without a block cache
+  }
+}
+
+
+void Dispatcher_Client::detach_block_cache()
+{
+  delete block_cache;
+  block_cache = 0;
+}
+
+
 void Dispatcher_Client::read_finished()
 {
 //   *(uint32*)(dispatcher_shm_ptr + 2*sizeof(uint32)) = 0;
@@ -19,6 +19,7 @@
 #ifndef DE__OSM3S___TEMPLATE_DB__DISPATCHER_CLIENT_H
 #define DE__OSM3S___TEMPLATE_DB__DISPATCHER_CLIENT_H
 
+#include "block_cache.h"
 #include "types.h"
 
 #include <vector>
@@ -64,11 +65,20 @@ class Dispatcher_Client
     /** Read operations: --------------------------------------------------- */
 
     /** Request the index for a read operation and registers the reading process.
-    Reading the index files should be taking a quick copy, because if any process
-    is in this state, write_commits are blocked. */
+    Commits do not wait for the process. Hence it should read the index files
+    between begin_index_snapshot() and index_snapshot_valid(). */
     void request_read_and_idx(uint32 max_allowed_time, uint64 max_allowed_space,
 			      uint32 client_token);
 
+    /** Waits until no commit is replacing the index files and returns the index generation.
+    Pins the block cache to the same generation. Throws a File_Error if the files
+    are still being replaced after about ten seconds. */
+    uint32 begin_index_snapshot();
+
+    /** Returns true if no commit has happened since begin_index_snapshot() returned
+    the given generation. Otherwise the index files must be read again. */
+    bool index_snapshot_valid(uint32 generation);
+
     /** Changes the registered state from reading the index to reading the
     database. Can be safely called multiple times for the same process. */
     void read_idx_finished();
@@ -100,12 +110,20 @@ class Dispatcher_Client
     const std::string& get_db_dir() { return db_dir; }
     const std::string& get_shadow_name() { return shadow_name; }
 
+    /** The block cache of this dispatcher, or 0 if it runs without one.
+    Transactions on the files of this dispatcher should read through it. */
+    Shared_Block_Cache* get_block_cache() { return block_cache; }
+
   private:
     std::string dispatcher_share_name;
     int dispatcher_shm_fd;
     volatile uint8* dispatcher_shm_ptr;
     std::string db_dir, shadow_name;
     Unix_Socket socket;
+    Shared_Block_Cache* block_cache;
+
+    void attach_block_cache();
+    void detach_block_cache();
 
     uint32 ack_arrived();
 
@@ -19,6 +19,7 @@
 #ifndef DE__OSM3S___TEMPLATE_DB__FILE_BLOCKS_H
 #define DE__OSM3S___TEMPLATE_DB__FILE_BLOCKS_H
 
+#include "block_cache.h"
 #include "file_blocks_index.h"
 #include "types.h"
 #include "lz4_wrapper.h"
@@ -26,8 +27,10 @@
 
 #include <unistd.h>
 
+#include <atomic>
 #include <cerrno>
 #include <cstdlib>
+#include <cstring>
 #include <list>
 
 /** Declarations: -----------------------------------------------------------*/
@@ -179,6 +182,11 @@ public:
   void* read_block(const File_Blocks_Basic_Iterator< TIndex >& it) const;
   void* read_block
       (const File_Blocks_Basic_Iterator< TIndex >& it, void* buffer) const;
+  // Like read_block(it, buffer), but for uncompressed blocks of a read-only file
+  // it may return a pointer into the memory mapping instead of copying to buffer.
+  // The returned memory must not be written to.
+  void* read_block_inplace
+      (const File_Blocks_Basic_Iterator< TIndex >& it, void* buffer) const;
 
   uint32 answer_size(const Flat_Iterator& it) const
   {
@@ -192,6 +200,12 @@ public:
 
   uint read_count() const { return read_count_; }
   void reset_read_count() { read_count_ = 0; }
+  void add_read_count(uint count) const { read_count_ += count; }
+
+  // Asks the kernel to read ahead the blocks of the next count positions after it.
+  // Adjacent blocks are merged to a single request.
+  template< typename Iterator >
+  void prefetch(Iterator it, const Iterator& end, uint32 count) const;
 
   Discrete_Iterator insert_block
       (const Discrete_Iterator& it, void* buf, uint32 max_keysize);
@@ -205,16 +219,25 @@ private:
   uint32 compression_factor;
   int compression_method;
   bool writeable;
-  mutable uint read_count_;
+  // Atomic, so that the count stays exact when reads run on several threads
+  mutable std::atomic< uint > read_count_;
 
   Flat_Iterator* flat_end_it;
   Discrete_Iterator* discrete_end_it;
   Range_Iterator* range_end_it;
 
   Raw_File data_file;
+  Mmapped_File data_map;
+  uint64 cache_file_id;
   Void_Pointer< void > buffer;
 
   uint32 allocate_block(uint32 data_size);
+  const uint8* mapped_block(const File_Blocks_Basic_Iterator< TIndex >& it) const;
+  void will_need(uint64 begin, uint64 end) const;
+  void load_block(const File_Blocks_Basic_Iterator< TIndex >& it, const uint8* mapped, void* buffer_) const;
+  bool fetch_cached_block(const File_Blocks_Basic_Iterator< TIndex >& it, void* buffer_) const;
+  void store_cached_block(const File_Blocks_Basic_Iterator< TIndex >& it, const void* buffer_) const;
+  void check_block_index(const File_Blocks_Basic_Iterator< TIndex >& it, const void* block) const;
 };
 
 
@@ -514,6 +537,10 @@ File_Blocks< TIndex, TIterator, TRangeIterator >::File_Blocks
      data_file(index->get_data_file_name(),
 	       writeable ? O_RDWR|O_CREAT : O_RDONLY,
 	       S_666, "File_Blocks::File_Blocks::1"),
+     // Read-only processes share the blocks via the page cache instead of seek and read
+     data_map(writeable ? -1 : data_file.fd(),
+              writeable ? 0 : data_file.size("File_Blocks::File_Blocks::2")),
+     cache_file_id(writeable ? 0 : Shared_Block_Cache::file_id(index->get_data_file_name())),
      buffer(index->get_block_size() * index->get_compression_factor() * 2)      // increased buffer size for lz4
 {
   // cerr<<"  "<<index->get_data_file_name()<<'\n'; //Debug
@@ -563,24 +590,83 @@ File_Blocks< TIndex, TIterator, TRangeIterator >::range_begin(const TRangeIterat
 }
 
 
+template< typename TIndex, typename TIterator, typename TRangeIterator >
+template< typename Iterator >
+void File_Blocks< TIndex, TIterator, TRangeIterator >::prefetch
+    (Iterator it, const Iterator& end, uint32 count) const
+{
+  uint64 range_begin = 0;
+  uint64 range_end = 0;
+  for (uint32 i = 0; i < count && !(it == end); ++i)
+  {
+    ++it;
+    if (it == end || it.block_type() == File_Block_Index_Entry< TIndex >::EMPTY)
+      continue;
+
+    uint64 pos = (uint64)(it.block_it->pos) * block_size;
+    if (pos != range_end)
+    {
+      will_need(range_begin, range_end);
+      range_begin = pos;
+      range_end = pos;
+    }
+    range_end += (uint64)block_size * it.block_it->size;
+  }
+
+  will_need(range_begin, range_end);
+}
+
+
+template< typename TIndex, typename TIterator, typename TRangeIterator >
+void File_Blocks< TIndex, TIterator, TRangeIterator >::will_need(uint64 begin, uint64 end) const
+{
+  if (begin >= end)
+    return;
+  if (data_map.covers(begin, end - begin))
+    data_map.will_need(begin, end - begin);
+  else
+    data_file.will_need(begin, end - begin);
+}
+
+
+template< typename TIndex, typename TIterator, typename TRangeIterator >
+const uint8* File_Blocks< TIndex, TIterator, TRangeIterator >::mapped_block
+    (const File_Blocks_Basic_Iterator< TIndex >& it) const
+{
+  uint64 pos = (uint64)(it.block_it->pos) * block_size;
+  if (data_map.covers(pos, (uint64)block_size * it.block_it->size))
+    return data_map.ptr() + pos;
+  return 0;
+}
+
+
 template< typename TIndex, typename TIterator, typename TRangeIterator >
 void* File_Blocks< TIndex, TIterator, TRangeIterator >::read_block
     (const File_Blocks_Basic_Iterator< TIndex >& it) const
 {
-  data_file.seek((int64)(it.block_it->pos) * block_size, "File_Blocks::read_block::1");
+  const uint8* mapped = mapped_block(it);
+  if (!mapped)
+    data_file.seek((int64)(it.block_it->pos) * block_size, "File_Blocks::read_block::1");
+
   if (compression_method == File_Blocks_Index< TIndex >::NO_COMPRESSION)
-    data_file.read((uint8*)buffer.ptr, block_size * it.block_it->size, "File_Blocks::read_block::2");
-  else if (compression_method == File_Blocks_Index< TIndex >::ZLIB_COMPRESSION)
   {
-    Void_Pointer< void > input(block_size * it.block_it->size);
-    data_file.read((uint8*)input.ptr, block_size * it.block_it->size, "File_Blocks::read_block::2");
-    Zlib_Inflate().decompress(input.ptr, block_size * it.block_it->size, buffer.ptr, block_size * compression_factor);
+    if (mapped)
+      memcpy(buffer.ptr, mapped, block_size * it.block_it->size);
+    else
+      data_file.read((uint8*)buffer.ptr, block_size * it.block_it->size, "File_Blocks::read_block::2");
   }
-  else if (compression_method == File_Blocks_Index< TIndex >::LZ4_COMPRESSION)
+  else if (!fetch_cached_block(it, buffer.ptr))
   {
-    Void_Pointer< void > input(block_size * it.block_it->size);
-    data_file.read((uint8*)input.ptr, block_size * it.block_it->size, "File_Blocks::read_block::2");
-    LZ4_Inflate().decompress(input.ptr, block_size * it.block_it->size, buffer.ptr, block_size * compression_factor);
+    Void_Pointer< void > input(mapped ? 0 : block_size * it.block_it->size);
+    if (!mapped)
+      data_file.read((uint8*)input.ptr, block_size * it.block_it->size, "File_Blocks::read_block::2");
+    const void* source = mapped ? (const void*)mapped : input.ptr;
+
+    if (compression_method == File_Blocks_Index< TIndex >::ZLIB_COMPRESSION)
+      Zlib_Inflate().decompress(source, block_size * it.block_it->size, buffer.ptr, block_size * compression_factor);
+    else if (compression_method == File_Blocks_Index< TIndex >::LZ4_COMPRESSION)
+      LZ4_Inflate().decompress(source, block_size * it.block_it->size, buffer.ptr, block_size * compression_factor);
+    store_cached_block(it, buffer.ptr);
   }
 
   ++read_count_;
@@ -593,28 +679,96 @@ template< typename TIndex, typename TIterator, typename TRangeIterator >
 void* File_Blocks< TIndex, TIterator, TRangeIterator >::read_block
     (const File_Blocks_Basic_Iterator< TIndex >& it, void* buffer_) const
 {
-  data_file.seek((int64)(it.block_it->pos) * block_size, "File_Blocks::read_block::3");
+  const uint8* mapped = mapped_block(it);
+  if (mapped && compression_method == File_Blocks_Index< TIndex >::NO_COMPRESSION)
+    memcpy(buffer_, mapped, block_size * it.block_it->size);
+  else
+    load_block(it, mapped, buffer_);
+
+  check_block_index(it, buffer_);
+  ++read_count_;
+  ++global_read_counter();
+  return buffer_;
+}
+
+
+template< typename TIndex, typename TIterator, typename TRangeIterator >
+void* File_Blocks< TIndex, TIterator, TRangeIterator >::read_block_inplace
+    (const File_Blocks_Basic_Iterator< TIndex >& it, void* buffer_) const
+{
+  void* result = buffer_;
+  const uint8* mapped = mapped_block(it);
+  if (mapped && compression_method == File_Blocks_Index< TIndex >::NO_COMPRESSION)
+    // The mapping is read-only. We hand it out as void* only to fit the buffer interface.
+    result = const_cast< uint8* >(mapped);
+  else
+    load_block(it, mapped, buffer_);
+
+  check_block_index(it, result);
+  ++read_count_;
+  ++global_read_counter();
+  return result;
+}
+
+
+template< typename TIndex, typename TIterator, typename TRangeIterator >
+void File_Blocks< TIndex, TIterator, TRangeIterator >::load_block
+    (const File_Blocks_Basic_Iterator< TIndex >& it, const uint8* mapped, void* buffer_) const
+{
+  if (compression_method != File_Blocks_Index< TIndex >::NO_COMPRESSION
+      && fetch_cached_block(it, buffer_))
+    return;
+
+  if (!mapped)
+    data_file.seek((int64)(it.block_it->pos) * block_size, "File_Blocks::read_block::3");
 
   if (compression_method == File_Blocks_Index< TIndex >::NO_COMPRESSION)
     data_file.read((uint8*)buffer_, block_size * it.block_it->size, "File_Blocks::read_block::4");
-  else if (compression_method == File_Blocks_Index< TIndex >::ZLIB_COMPRESSION)
-  {
-    data_file.read((uint8*)buffer.ptr, block_size * it.block_it->size, "File_Blocks::read_block::4");
-    Zlib_Inflate().decompress(buffer.ptr, block_size * it.block_it->size, buffer_, block_size * compression_factor);
-  }
-  else if (compression_method == File_Blocks_Index< TIndex >::LZ4_COMPRESSION)
+  else
   {
-    data_file.read((uint8*)buffer.ptr, block_size * it.block_it->size, "File_Blocks::read_block::4");
-    LZ4_Inflate().decompress(buffer.ptr, block_size * it.block_it->size, buffer_, block_size * compression_factor);
+    if (!mapped)
+      data_file.read((uint8*)buffer.ptr, block_size * it.block_it->size, "File_Blocks::read_block::4");
+    const void* source = mapped ? (const void*)mapped : buffer.ptr;
+
+    if (compression_method == File_Blocks_Index< TIndex >::ZLIB_COMPRESSION)
+      Zlib_Inflate().decompress(source, block_size * it.block_it->size, buffer_, block_size * compression_factor);
+    else if (compression_method == File_Blocks_Index< TIndex >::LZ4_COMPRESSION)
+      LZ4_Inflate().decompress(source, block_size * it.block_it->size, buffer_, block_size * compression_factor);
+    store_cached_block(it, buffer_);
   }
+}
+
+
+template< typename TIndex, typename TIterator, typename TRangeIterator >
+bool File_Blocks< TIndex, TIterator, TRangeIterator >::fetch_cached_block
+    (const File_Blocks_Basic_Iterator< TIndex >& it, void* buffer_) const
+{
+  Shared_Block_Cache* cache = index->get_block_cache();
+  return (cache && !writeable
+      && cache->get(cache_file_id, it.block_it->pos, buffer_, block_size * compression_factor));
+}
+
 
+template< typename TIndex, typename TIterator, typename TRangeIterator >
+void File_Blocks< TIndex, TIterator, TRangeIterator >::store_cached_block
+    (const File_Blocks_Basic_Iterator< TIndex >& it, const void* buffer_) const
+{
+  Shared_Block_Cache* cache = index->get_block_cache();
+  if (cache && !writeable)
+    // The first word of each block is the number of bytes in use
+    cache->put(cache_file_id, it.block_it->pos, buffer_,
+        std::min(*(const uint32*)buffer_, block_size * compression_factor));
+}
+
+
+template< typename TIndex, typename TIterator, typename TRangeIterator >
+void File_Blocks< TIndex, TIterator, TRangeIterator >::check_block_index
+    (const File_Blocks_Basic_Iterator< TIndex >& it, const void* block) const
+{
   if (!(it.block_it->index ==
-        TIndex(((uint8*)buffer_)+(sizeof(uint32)+sizeof(uint32)))))
+        TIndex(((uint8*)block)+(sizeof(uint32)+sizeof(uint32)))))
     throw File_Error(it.block_it->pos, index->get_data_file_name(),
 		     "File_Blocks::read_block: Index inconsistent");
-  ++read_count_;
-  ++global_read_counter();
-  return buffer_;
 }
 
 
@@ -70,7 +70,7 @@ public:
 
   std::list< File_Block_Index_Entry< TIndex > >& get_blocks()
   {
-    if (index_buf.ptr)
+    if (index_ptr)
       init_blocks();
     return blocks;
   }
@@ -92,6 +92,10 @@ private:
   std::string data_file_name;
   std::string file_name_extension_;
   Void_Pointer< uint8 > index_buf;
+  Mmapped_File* index_map;
+  // The undecoded index in index_buf or index_map, or null once the blocks are decoded.
+  // The index types only read from it, hence it may point to read-only memory.
+  uint8* index_ptr;
   uint64 file_size;
   uint32 index_size;
   std::list< File_Block_Index_Entry< TIndex > > blocks;
@@ -105,6 +109,7 @@ private:
   void init_structure_params();
   void init_blocks();
   void init_void_blocks();
+  void release_index_data();
 
 public:
   uint32 block_count;
@@ -132,7 +137,7 @@ File_Blocks_Index< TIndex >::File_Blocks_Index
      data_file_name(db_dir + file_prop.get_file_name_trunk()
          + file_name_extension + file_prop.get_data_suffix()),
      file_name_extension_(file_name_extension),
-     index_buf(0), file_size(0), index_size(0),
+     index_buf(0), index_map(0), index_ptr(0), file_size(0), index_size(0),
      void_blocks_initialized(false),
      block_size_(file_prop.get_block_size()), // can be overwritten by index file
      compression_factor(file_prop.get_compression_factor()), // can be overwritten by index file
@@ -158,14 +163,26 @@ File_Blocks_Index< TIndex >::File_Blocks_Index
 
     // read index file
     index_size = source_file.size("File_Blocks_Index::File_Blocks_Index::4");
-    index_buf.resize(index_size);
-    source_file.read(index_buf.ptr, index_size, "File_Blocks_Index::File_Blocks_Index::5");
+    if (!writeable)
+    {
+      // A read-only index is only decoded when its blocks are used. Until then the mapping
+      // keeps the file as it was when opened and shares its pages with other processes.
+      index_map = new Mmapped_File(source_file.fd(), index_size);
+      index_ptr = const_cast< uint8* >(index_map->ptr());
+    }
+    if (!index_ptr)
+    {
+      release_index_data();
+      index_buf.resize(index_size);
+      source_file.read(index_buf.ptr, index_size, "File_Blocks_Index::File_Blocks_Index::5");
+      index_ptr = index_buf.ptr;
+    }
   }
   catch (File_Error e)
   {
     if (e.error_number != 2)
       throw e;
-    index_buf.resize(0);
+    release_index_data();
   }
 
   init_structure_params();
@@ -178,15 +195,18 @@ File_Blocks_Index< TIndex >::File_Blocks_Index
 template< class TIndex >
 void File_Blocks_Index< TIndex >::init_structure_params()
 {
-  if (index_buf.ptr)
+  if (index_ptr)
   {
     if (file_name_extension_ != ".legacy")
     {
-      if (*(int32*)index_buf.ptr != FILE_FORMAT_VERSION)
+      if (*(int32*)index_ptr != FILE_FORMAT_VERSION)
+      {
+        release_index_data();
 	throw File_Error(0, index_file_name, "File_Blocks_Index: Unsupported index file format version");
-      block_size_ = 1ull<<*(uint8*)(index_buf.ptr + 4);
-      compression_factor = 1u<<*(uint8*)(index_buf.ptr + 5);
-      compression_method = *(uint16*)(index_buf.ptr + 6);
+      }
+      block_size_ = 1ull<<*(uint8*)(index_ptr + 4);
+      compression_factor = 1u<<*(uint8*)(index_ptr + 5);
+      compression_method = *(uint16*)(index_ptr + 6);
     }
     block_count = file_size / block_size_;
   }
@@ -196,54 +216,74 @@ void File_Blocks_Index< TIndex >::init_structure_params()
 template< class TIndex >
 void File_Blocks_Index< TIndex >::init_blocks()
 {
-  if (index_buf.ptr)
+  if (index_ptr)
   {
-    if (file_name_extension_ == ".legacy")
-      // We support this way the old format although it has no version marker.
+    // A throw must not leave a half filled list behind that a later call would append to
+    try
     {
-      uint32 pos = 0;
-      while (pos < index_size)
+      if (file_name_extension_ == ".legacy")
+        // We support this way the old format although it has no version marker.
       {
-        TIndex index(index_buf.ptr+pos);
-        File_Block_Index_Entry< TIndex >
-            entry(index,
-	    *(uint32*)(index_buf.ptr + (pos + TIndex::size_of(index_buf.ptr+pos))),
-	    1, //block size is always 1 in the legacy format
-	    *(uint32*)(index_buf.ptr + (pos + TIndex::size_of(index_buf.ptr+pos) + 4)));
-        blocks.push_back(entry);
-        if (entry.pos >= block_count)
-	  throw File_Error(0, index_file_name, "File_Blocks_Index: bad pos in index file");
-        pos += TIndex::size_of(index_buf.ptr+pos) + 8;
+        uint32 pos = 0;
+        while (pos < index_size)
+        {
+          TIndex index(index_ptr+pos);
+          File_Block_Index_Entry< TIndex >
+              entry(index,
+	      *(uint32*)(index_ptr + (pos + TIndex::size_of(index_ptr+pos))),
+	      1, //block size is always 1 in the legacy format
+	      *(uint32*)(index_ptr + (pos + TIndex::size_of(index_ptr+pos) + 4)));
+          blocks.push_back(entry);
+          if (entry.pos >= block_count)
+	    throw File_Error(0, index_file_name, "File_Blocks_Index: bad pos in index file");
+          pos += TIndex::size_of(index_ptr+pos) + 8;
+        }
       }
-    }
-    else if (index_size > 0)
-    {
-      uint32 pos = 8;
-      while (pos < index_size)
+      else if (index_size > 0)
       {
-        TIndex index(index_buf.ptr + pos + 12);
-        File_Block_Index_Entry< TIndex >
-            entry(index,
-	    *(uint32*)(index_buf.ptr + pos),
-	    *(uint32*)(index_buf.ptr + pos + 4),
-	    *(uint32*)(index_buf.ptr + pos + 8));
-        blocks.push_back(entry);
-        if (entry.pos >= block_count)
-	  throw File_Error(0, index_file_name, "File_Blocks_Index: bad pos in index file");
-	pos += 12;
-        pos += TIndex::size_of(index_buf.ptr + pos);
+        uint32 pos = 8;
+        while (pos < index_size)
+        {
+          TIndex index(index_ptr + pos + 12);
+          File_Block_Index_Entry< TIndex >
+              entry(index,
+	      *(uint32*)(index_ptr + pos),
+	      *(uint32*)(index_ptr + pos + 4),
+	      *(uint32*)(index_ptr + pos + 8));
+          blocks.push_back(entry);
+          if (entry.pos >= block_count)
+	    throw File_Error(0, index_file_name, "File_Blocks_Index: bad pos in index file");
+	  pos += 12;
+          pos += TIndex::size_of(index_ptr + pos);
+        }
       }
     }
+    catch (...)
+    {
+      blocks.clear();
+      release_index_data();
+      throw;
+    }
 
-    index_buf.resize(0);
+    release_index_data();
   }
 }
 
 
+template< class TIndex >
+void File_Blocks_Index< TIndex >::release_index_data()
+{
+  index_buf.resize(0);
+  delete index_map;
+  index_map = 0;
+  index_ptr = 0;
+}
+
+
 template< class TIndex >
 void File_Blocks_Index< TIndex >::init_void_blocks()
 {
-  if (index_buf.ptr)
+  if (index_ptr)
     init_blocks();
 
   std::vector< bool > is_referred(block_count, false);
@@ -296,6 +336,7 @@ void File_Blocks_Index< TIndex >::init_void_blocks()
 template< class TIndex >
 File_Blocks_Index< TIndex >::~File_Blocks_Index()
 {
+  release_index_data();
   if (empty_index_file_name == "")
     return;
 
@@ -37,6 +37,7 @@ struct Blocking_Client_Socket
   void clear_state();
   void send_data(uint32 result);
   void send_result(uint32 result);
+  int descriptor() const { return socket_descriptor; }
   ~Blocking_Client_Socket();
 private:
   int socket_descriptor;
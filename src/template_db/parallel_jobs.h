@@ -0,0 +1,165 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DE__OSM3S___TEMPLATE_DB__PARALLEL_JOBS_H
+#define DE__OSM3S___TEMPLATE_DB__PARALLEL_JOBS_H
+
+#include "types.h"
+
+#include <pthread.h>
+
+#include <new>
+#include <vector>
+
+
+/* A unit of work for run_parallel_jobs(). A job must not touch state that another job
+ * of the same batch modifies. Lazily initialized shared state, e.g. the indexes of a
+ * Transaction, must be set up before the jobs are started. */
+class Parallel_Job
+{
+public:
+  virtual ~Parallel_Job() {}
+  virtual void run() = 0;
+};
+
+
+/* Runs the jobs on up to max_threads threads, the calling thread included.
+ * Returns after all jobs have finished. Exceptions from jobs are passed to the caller
+ * after all threads have been joined: File_Error and std::bad_alloc are rethrown as such,
+ * any other exception from a worker thread becomes a File_Error. Once a job has failed
+ * the jobs not yet started are skipped. */
+inline void run_parallel_jobs(const std::vector< Parallel_Job* >& jobs, uint max_threads);
+
+
+//-----------------------------------------------------------------------------
+
+
+struct Parallel_Job_Queue
+{
+  Parallel_Job_Queue(const std::vector< Parallel_Job* >& jobs_)
+      : jobs(&jobs_), next(0), failed(false), error_kind(0), error(0, "", "") {}
+
+  const std::vector< Parallel_Job* >* jobs;
+  uint next;
+  bool failed;
+  int error_kind;
+  File_Error error;
+  pthread_mutex_t mutex;
+
+  static const int FILE_ERROR = 1;
+  static const int BAD_ALLOC = 2;
+  static const int OTHER_ERROR = 3;
+
+  Parallel_Job* fetch()
+  {
+    Parallel_Job* result = 0;
+    pthread_mutex_lock(&mutex);
+    if (!failed && next < jobs->size())
+      result = (*jobs)[next++];
+    pthread_mutex_unlock(&mutex);
+    return result;
+  }
+
+  void fail(int kind, const File_Error& e)
+  {
+    pthread_mutex_lock(&mutex);
+    if (!failed)
+    {
+      failed = true;
+      error_kind = kind;
+      error = e;
+    }
+    pthread_mutex_unlock(&mutex);
+  }
+};
+
+
+inline void* run_parallel_job_worker(void* arg)
+{
+  Parallel_Job_Queue* queue = (Parallel_Job_Queue*)arg;
+  try
+  {
+    while (Parallel_Job* job = queue->fetch())
+      job->run();
+  }
+  catch (const File_Error& e)
+  {
+    queue->fail(Parallel_Job_Queue::FILE_ERROR, e);
+  }
+  catch (const std::bad_alloc& e)
+  {
+    queue->fail(Parallel_Job_Queue::BAD_ALLOC, File_Error(0, "", ""));
+  }
+  catch (...)
+  {
+    queue->fail(Parallel_Job_Queue::OTHER_ERROR, File_Error(0, "", "run_parallel_jobs::worker"));
+  }
+  return 0;
+}
+
+
+inline void run_parallel_jobs(const std::vector< Parallel_Job* >& jobs, uint max_threads)
+{
+  if (max_threads > jobs.size())
+    max_threads = jobs.size();
+  if (max_threads <= 1)
+  {
+    for (std::vector< Parallel_Job* >::const_iterator it = jobs.begin(); it != jobs.end(); ++it)
+      (*it)->run();
+    return;
+  }
+
+  Parallel_Job_Queue queue(jobs);
+  pthread_mutex_init(&queue.mutex, 0);
+
+  std::vector< pthread_t > threads;
+  for (uint i = 1; i < max_threads; ++i)
+  {
+    pthread_t thread;
+    if (pthread_create(&thread, 0, &run_parallel_job_worker, &queue) == 0)
+      threads.push_back(thread);
+  }
+
+  // The calling thread works on the queue as well. Its exceptions are passed on unchanged,
+  // but only after the other threads have stopped using the jobs.
+  try
+  {
+    while (Parallel_Job* job = queue.fetch())
+      job->run();
+  }
+  catch (...)
+  {
+    queue.fail(0, File_Error(0, "", ""));
+    for (std::vector< pthread_t >::const_iterator it = threads.begin(); it != threads.end(); ++it)
+      pthread_join(*it, 0);
+    pthread_mutex_destroy(&queue.mutex);
+    throw;
+  }
+
+  for (std::vector< pthread_t >::const_iterator it = threads.begin(); it != threads.end(); ++it)
+    pthread_join(*it, 0);
+  pthread_mutex_destroy(&queue.mutex);
+
+  if (queue.error_kind == Parallel_Job_Queue::BAD_ALLOC)
+    throw std::bad_alloc();
+  else if (queue.error_kind != 0)
+    throw queue.error;
+}
+
+
+#endif
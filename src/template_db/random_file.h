@@ -53,8 +53,10 @@ private:
   uint32 compression_factor;
 
   Raw_File val_file;
+  Mmapped_File val_map;
   Random_File_Index* index;
   Void_Pointer< uint8 > cache;
+  uint8* cache_data;
   uint32 cache_pos;
   uint32 block_size;
 
@@ -75,8 +77,12 @@ Random_File< Key, Value >::Random_File(Random_File_Index* index_)
   val_file(index_->get_map_file_name(),
 	   index_->writeable() ? O_RDWR|O_CREAT : O_RDONLY,
 	   S_666, "Random_File:3"),
+  // Read-only processes share the blocks via the page cache instead of seek and read
+  val_map(index_->writeable() ? -1 : val_file.fd(),
+          index_->writeable() ? 0 : val_file.size("Random_File:4")),
   index(index_),
-  cache(index_->get_block_size() * index_->get_compression_factor()), cache_pos(index->npos),
+  cache(index_->get_block_size() * index_->get_compression_factor()), cache_data(cache.ptr),
+  cache_pos(index->npos),
   block_size(index_->get_block_size()),
   buffer(index_->get_block_size() * index_->get_compression_factor() * 2)  // increased buffer size for lz4
 {}
@@ -94,7 +100,7 @@ template< typename Key, typename Value >
 Value Random_File< Key, Value >::get(Key pos)
 {
   move_cache_window(pos.val() / (block_size*compression_factor /index_size));
-  return Value(cache.ptr + (pos.val() % (block_size*compression_factor/index_size))*index_size);
+  return Value(cache_data + (pos.val() % (block_size*compression_factor/index_size))*index_size);
 }
 
 
@@ -159,28 +165,53 @@ void Random_File< Key, Value >::move_cache_window(uint32 pos)
   if (pos == index->npos)
     return;
 
-  if ((index->get_blocks().size() <= pos) || (index->get_blocks()[pos].pos == index->npos))
+  cache_data = cache.ptr;
+  if ((index->entry_count() <= pos) || (index->entry(pos).pos == index->npos))
   {
     // Reset the whole cache to zero.
     for (uint32 i = 0; i < block_size * compression_factor; ++i)
       *(cache.ptr + i) = 0;
+    cache_pos = pos;
+    return;
+  }
+
+  // The entries of a mapped index have not been checked before
+  const Random_File_Index_Entry& entry = index->entry(pos);
+  if (entry.size > index->get_compression_factor() * 2
+      || entry.pos >= index->block_count)
+    throw File_Error(0, index->get_map_file_name(), "Random_File: bad pos in index file");
+
+  if (val_map.covers((uint64)(entry.pos)*block_size, (uint64)block_size *
+      (index->get_compression_method() == File_Blocks_Index_Base::NO_COMPRESSION ?
+      compression_factor : entry.size)))
+  {
+    const uint8* mapped = val_map.ptr() + (uint64)(entry.pos)*block_size;
+    if (index->get_compression_method() == File_Blocks_Index_Base::NO_COMPRESSION)
+      // The mapping is read-only, but get() is the only reader of cache_data for a read-only file.
+      cache_data = const_cast< uint8* >(mapped);
+    else if (index->get_compression_method() == File_Blocks_Index_Base::ZLIB_COMPRESSION)
+      Zlib_Inflate().decompress
+          (mapped, block_size * entry.size, cache.ptr, block_size * index->get_compression_factor());
+    else if (index->get_compression_method() == File_Blocks_Index_Base::LZ4_COMPRESSION)
+      LZ4_Inflate().decompress
+          (mapped, block_size * entry.size, cache.ptr, block_size * index->get_compression_factor());
   }
   else
   {
-    val_file.seek((int64)(index->get_blocks()[pos].pos)*block_size, "Random_File:23");
+    val_file.seek((int64)(entry.pos)*block_size, "Random_File:23");
     if (index->get_compression_method() == File_Blocks_Index_Base::NO_COMPRESSION)
-      val_file.read(cache.ptr, block_size * index->get_blocks()[pos].size, "Random_File:24");
+      val_file.read(cache.ptr, block_size * entry.size, "Random_File:24");
     else if (index->get_compression_method() == File_Blocks_Index_Base::ZLIB_COMPRESSION)
     {
-      val_file.read(buffer.ptr, block_size * index->get_blocks()[pos].size, "Random_File:25");
+      val_file.read(buffer.ptr, block_size * entry.size, "Random_File:25");
       Zlib_Inflate().decompress
-          (buffer.ptr, block_size * index->get_blocks()[pos].size, cache.ptr, block_size * index->get_compression_factor());
+          (buffer.ptr, block_size * entry.size, cache.ptr, block_size * index->get_compression_factor());
     }
     else if (index->get_compression_method() == File_Blocks_Index_Base::LZ4_COMPRESSION)
     {
-      val_file.read(buffer.ptr, block_size * index->get_blocks()[pos].size, "Random_File:26");
+      val_file.read(buffer.ptr, block_size * entry.size, "Random_File:26");
       LZ4_Inflate().decompress
-          (buffer.ptr, block_size * index->get_blocks()[pos].size, cache.ptr, block_size * index->get_compression_factor());
+          (buffer.ptr, block_size * entry.size, cache.ptr, block_size * index->get_compression_factor());
     }
   }
   cache_pos = pos;
@@ -60,10 +60,17 @@ public:
   uint32 get_compression_factor() const { return compression_factor; }
   uint32 get_compression_method() const { return compression_method; }
 
+  // For modifications. A mapped index is copied to the heap first.
   std::vector< Random_File_Index_Entry >& get_blocks()
   {
+    if (mapped_entries)
+      copy_mapped_entries();
     return blocks;
   }
+  // Read access. The entries of a read-only index are used in place from the mapped index file.
+  uint32 entry_count() const { return mapped_entries ? mapped_count : blocks.size(); }
+  const Random_File_Index_Entry& entry(uint32 i) const
+  { return mapped_entries ? mapped_entries[i] : blocks[i]; }
   std::vector< std::pair< uint32, uint32 > >& get_void_blocks()
   {
     if (!void_blocks_initialized)
@@ -81,6 +88,9 @@ private:
   std::string file_name_extension_;
 
   std::vector< Random_File_Index_Entry > blocks;
+  Mmapped_File* index_map;
+  const Random_File_Index_Entry* mapped_entries;
+  uint32 mapped_count;
   std::vector< std::pair< uint32, uint32 > > void_blocks;
   bool void_blocks_initialized;
 
@@ -88,8 +98,13 @@ private:
   uint32 compression_factor;
   int compression_method;
 
+  bool map_index_file(const Raw_File& source_file, uint32 index_size, uint64 file_size);
+  void copy_mapped_entries();
   void init_void_blocks();
 
+  Random_File_Index(const Random_File_Index&);
+  Random_File_Index& operator=(const Random_File_Index&);
+
 public:
   uint32 block_count;
 };
@@ -119,6 +134,7 @@ inline Random_File_Index::Random_File_Index
     map_file_name(db_dir + file_prop.get_file_name_trunk()
         + file_prop.get_id_suffix()),
     file_name_extension_(file_name_extension),
+    index_map(0), mapped_entries(0), mapped_count(0),
     void_blocks_initialized(false),
     block_size_(file_prop.get_map_block_size()),
     compression_factor(file_prop.get_map_compression_factor()),
@@ -144,8 +160,12 @@ inline Random_File_Index::Random_File_Index
         (index_file_name, writeable ? O_RDONLY|O_CREAT : O_RDONLY, S_666,
 	 "Random_File:6");
 
-    // read index file
     uint32 index_size = source_file.size("Random_File:10");
+    if (!writeable && file_name_extension != ".legacy"
+        && map_index_file(source_file, index_size, file_size))
+      return;
+
+    // read index file
     Void_Pointer< uint8 > index_buf(index_size);
     source_file.read(index_buf.ptr, index_size, "Random_File:14");
 
@@ -230,15 +250,54 @@ inline Random_File_Index::Random_File_Index
 }
 
 
+/* The entries of the current file format are stored exactly as Random_File_Index_Entry.
+ * They are checked only when a block is read. Files with another or an ambiguous version
+ * marker are decoded and checked by the constructor instead. */
+inline bool Random_File_Index::map_index_file
+    (const Raw_File& source_file, uint32 index_size, uint64 file_size)
+{
+  if (index_size < 8)
+    return false;
+
+  index_map = new Mmapped_File(source_file.fd(), index_size);
+  const uint8* ptr = index_map->ptr();
+  if (!ptr || *(int32*)ptr != FILE_FORMAT_VERSION
+      || *(uint8*)(ptr + 4) >= 32 || *(uint8*)(ptr + 5) >= 32 || *(uint16*)(ptr + 6) >= 3)
+  {
+    delete index_map;
+    index_map = 0;
+    return false;
+  }
+
+  block_size_ = 1ull<<*(uint8*)(ptr + 4);
+  compression_factor = 1u<<*(uint8*)(ptr + 5);
+  compression_method = *(uint16*)(ptr + 6);
+  block_count = file_size / block_size_;
+  mapped_entries = (const Random_File_Index_Entry*)(ptr + 8);
+  mapped_count = (index_size - 8) / sizeof(Random_File_Index_Entry);
+  return true;
+}
+
+
+inline void Random_File_Index::copy_mapped_entries()
+{
+  blocks.assign(mapped_entries, mapped_entries + mapped_count);
+  delete index_map;
+  index_map = 0;
+  mapped_entries = 0;
+  mapped_count = 0;
+}
+
+
 inline void Random_File_Index::init_void_blocks()
 {
   std::vector< bool > is_referred(block_count, false);
-  for (std::vector< Random_File_Index_Entry >::const_iterator it = blocks.begin(); it != blocks.end(); ++it)
+  for (uint32 j = 0; j < entry_count(); ++j)
   {
-    if (it->pos != npos)
+    if (entry(j).pos != npos && entry(j).pos < block_count)
     {
-      for (uint32 i = 0; i < it->size; ++i)
-        is_referred[it->pos + i] = true;
+      for (uint32 i = 0; i < entry(j).size && entry(j).pos + i < block_count; ++i)
+        is_referred[entry(j).pos + i] = true;
     }
   }
 
@@ -282,6 +341,7 @@ inline void Random_File_Index::init_void_blocks()
 
 inline Random_File_Index::~Random_File_Index()
 {
+  delete index_map;
   if (empty_index_file_name == "")
     return;
 
@@ -49,6 +49,10 @@ class Nonsynced_Transaction : public Transaction
     void flush();
     std::string get_db_dir() const { return db_dir; }
 
+    /** Lets all data files opened from now on read through the given cache.
+        The cache must outlive the transaction. */
+    void set_block_cache(Shared_Block_Cache* block_cache_) { block_cache = block_cache_; }
+
   private:
     std::map< const File_Properties*, File_Blocks_Index_Base* >
       data_files;
@@ -56,6 +60,7 @@ class Nonsynced_Transaction : public Transaction
       random_files;
     bool writeable, use_shadow;
     std::string file_name_extension, db_dir;
+    Shared_Block_Cache* block_cache;
 };
 
 
@@ -63,7 +68,7 @@ inline Nonsynced_Transaction::Nonsynced_Transaction
     (bool writeable_, bool use_shadow_,
      const std::string& db_dir_, const std::string& file_name_extension_)
   : writeable(writeable_), use_shadow(use_shadow_),
-    file_name_extension(file_name_extension_), db_dir(db_dir_)
+    file_name_extension(file_name_extension_), db_dir(db_dir_), block_cache(0)
 {
   if (!db_dir.empty() && db_dir[db_dir.size()-1] != '/')
     db_dir += "/";
@@ -100,7 +105,10 @@ inline File_Blocks_Index_Base* Nonsynced_Transaction::data_index
   File_Blocks_Index_Base* data_index = fp->new_data_index
       (writeable, use_shadow, db_dir, file_name_extension);
   if (data_index != 0)
+  {
+    data_index->set_block_cache(block_cache);
     data_files[fp] = data_index;
+  }
   return data_index;
 }
 
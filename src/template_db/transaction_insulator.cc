@@ -49,6 +49,16 @@ void Idx_Footprints::register_pid(pid_t pid)
 }
 
 
+void Idx_Footprints::extend_pid(pid_t pid)
+{
+  std::vector< bool >& footprint = footprint_per_pid[pid];
+  // The current footprint is never shorter than a registered one
+  footprint.resize(current_footprint.size(), false);
+  for (std::vector< bool >::size_type i = 0; i < current_footprint.size(); ++i)
+    footprint[i] = footprint[i] | current_footprint[i];
+}
+
+
 void Idx_Footprints::unregister_pid(pid_t pid)
 {
   footprint_per_pid.erase(pid);
@@ -80,8 +90,9 @@ std::vector< bool > Idx_Footprints::total_footprint() const
 
 
 Transaction_Insulator::Transaction_Insulator(
-    const std::string& db_dir, const std::vector< File_Properties* >& controlled_files_)
-    : db_dir_(db_dir), controlled_files(controlled_files_),
+    const std::string& db_dir, const std::vector< File_Properties* >& controlled_files_,
+    const std::string& version_file_)
+    : db_dir_(db_dir), controlled_files(controlled_files_), version_file(version_file_),
     data_footprints(controlled_files_.size()), map_footprints(controlled_files_.size())
 {
   // get the absolute pathname of the current directory
@@ -112,20 +123,58 @@ void Transaction_Insulator::read_finished(pid_t pid)
 }
 
 
-void Transaction_Insulator::copy_shadows_to_mains()
+const char* STAGED_SUFFIX = ".next";
+
+
+void stage_file(const std::string& source, const std::string& dest)
+{
+  remove((dest + STAGED_SUFFIX).c_str());
+  copy_file(source, dest + STAGED_SUFFIX);
+}
+
+
+void publish_file(const std::string& dest)
+{
+  if (!file_exists(dest + STAGED_SUFFIX))
+    return;
+  // rename() replaces the file atomically: a reading process opens either the old or the new file
+  if (rename((dest + STAGED_SUFFIX).c_str(), dest.c_str()) != 0)
+    throw File_Error(errno, dest, "Transaction_Insulator::publish_file");
+}
+
+
+void Transaction_Insulator::stage_shadows_as_mains()
 {
   for (std::vector< File_Properties* >::const_iterator it(controlled_files.begin());
       it != controlled_files.end(); ++it)
   {
-      copy_file(db_dir() + (*it)->get_file_name_trunk() + (*it)->get_data_suffix()
+      stage_file(db_dir() + (*it)->get_file_name_trunk() + (*it)->get_data_suffix()
                 + (*it)->get_index_suffix() + (*it)->get_shadow_suffix(),
 		db_dir() + (*it)->get_file_name_trunk() + (*it)->get_data_suffix()
 		+ (*it)->get_index_suffix());
-      copy_file(db_dir() + (*it)->get_file_name_trunk() + (*it)->get_id_suffix()
+      stage_file(db_dir() + (*it)->get_file_name_trunk() + (*it)->get_id_suffix()
                 + (*it)->get_index_suffix() + (*it)->get_shadow_suffix(),
 		db_dir() + (*it)->get_file_name_trunk() + (*it)->get_id_suffix()
 		+ (*it)->get_index_suffix());
   }
+  // The version must change in the same window as the index files it describes
+  if (!version_file.empty() && file_exists(db_dir() + version_file + ".shadow"))
+    stage_file(db_dir() + version_file + ".shadow", db_dir() + version_file);
+}
+
+
+void Transaction_Insulator::publish_staged_mains()
+{
+  for (std::vector< File_Properties* >::const_iterator it(controlled_files.begin());
+      it != controlled_files.end(); ++it)
+  {
+    publish_file(db_dir() + (*it)->get_file_name_trunk() + (*it)->get_data_suffix()
+        + (*it)->get_index_suffix());
+    publish_file(db_dir() + (*it)->get_file_name_trunk() + (*it)->get_id_suffix()
+        + (*it)->get_index_suffix());
+  }
+  if (!version_file.empty())
+    publish_file(db_dir() + version_file);
 }
 
 
@@ -160,6 +209,8 @@ void Transaction_Insulator::remove_shadows()
     remove((db_dir() + (*it)->get_file_name_trunk() + (*it)->get_id_suffix()
             + (*it)->get_shadow_suffix()).c_str());
   }
+  if (!version_file.empty())
+    remove((db_dir() + version_file + ".shadow").c_str());
 }
 
 
@@ -193,6 +244,17 @@ void Transaction_Insulator::set_current_footprints()
 }
 
 
+void Transaction_Insulator::extend_footprints(pid_t pid)
+{
+  for (std::vector< Idx_Footprints >::iterator it(data_footprints.begin());
+      it != data_footprints.end(); ++it)
+    it->extend_pid(pid);
+  for (std::vector< Idx_Footprints >::iterator it(map_footprints.begin());
+      it != map_footprints.end(); ++it)
+    it->extend_pid(pid);
+}
+
+
 std::set< pid_t > Transaction_Insulator::registered_pids() const
 {
   std::set< pid_t > registered;
@@ -34,6 +34,7 @@ class Idx_Footprints
 
     void set_current_footprint(const std::vector< bool >& footprint);
     void register_pid(pid_t pid);
+    void extend_pid(pid_t pid);
     void unregister_pid(pid_t pid);
     std::vector< pid_t > registered_processes() const;
     std::vector< bool > total_footprint() const;
@@ -47,12 +48,20 @@ class Idx_Footprints
 class Transaction_Insulator
 {
 public:
-  Transaction_Insulator(const std::string& db_dir, const std::vector< File_Properties* >& controlled_files_);
+  // version_file, if not empty, names a file in db_dir that writers put next to it with suffix ".shadow".
+  // It is published together with the index files.
+  Transaction_Insulator(const std::string& db_dir, const std::vector< File_Properties* >& controlled_files_,
+      const std::string& version_file = "");
   void request_read_and_idx(pid_t pid);
   void read_finished(pid_t pid);
+  // Adds the current footprints to those registered for the process
+  void extend_footprints(pid_t pid);
   std::set< pid_t > registered_pids() const;
 
-  void copy_shadows_to_mains();
+  // Copies the shadow index files next to the main index files
+  void stage_shadows_as_mains();
+  // Renames the staged copies onto the main index files
+  void publish_staged_mains();
   void copy_mains_to_shadows();
   void remove_shadows();
   void set_current_footprints();
@@ -63,6 +72,7 @@ public:
 private:
   std::string db_dir_;
   std::vector< File_Properties* > controlled_files;
+  std::string version_file;
   std::vector< Idx_Footprints > data_footprints;
   std::vector< Idx_Footprints > map_footprints;
 };
@@ -42,9 +42,9 @@ void copy_file(const std::string& source, const std::string& dest)
 }
 
 
-int& global_read_counter()
+std::atomic< int >& global_read_counter()
 {
-  static int counter = 0;
+  static std::atomic< int > counter(0);
   return counter;
 }
 
@@ -20,12 +20,16 @@
 #define DE__OSM3S___TEMPLATE_DB__TYPES_H
 
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include <cerrno>
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -71,14 +75,25 @@ struct File_Properties_Exception
 };
 
 
+class Shared_Block_Cache;
+
+
 struct File_Blocks_Index_Base
 {
+  File_Blocks_Index_Base() : block_cache(0) {}
   virtual ~File_Blocks_Index_Base() {}
 
+  // The cache of decompressed blocks of the dispatcher that owns this file, or 0
+  Shared_Block_Cache* get_block_cache() const { return block_cache; }
+  void set_block_cache(Shared_Block_Cache* block_cache_) { block_cache = block_cache_; }
+
   static const int USE_DEFAULT = -1;
   static const int NO_COMPRESSION = 0;
   static const int ZLIB_COMPRESSION = 1;
   static const int LZ4_COMPRESSION = 2;
+
+private:
+  Shared_Block_Cache* block_cache;
 };
 
 
@@ -122,6 +137,7 @@ class Raw_File
     void read(uint8* buf, uint64 size, const std::string& caller_id) const;
     void write(uint8* buf, uint64 size, const std::string& caller_id) const;
     void seek(uint64 pos, const std::string& caller_id) const;
+    void will_need(uint64 pos, uint64 size) const;
 
   private:
     int fd_;
@@ -129,6 +145,26 @@ class Raw_File
 };
 
 
+/** Simple RAII class to keep a read-only shared mapping of a file.
+ *  If the file is empty or cannot be mapped then ptr() is null and the caller should fall back to read(). */
+class Mmapped_File
+{
+  Mmapped_File(const Mmapped_File&);
+  Mmapped_File& operator=(const Mmapped_File&);
+
+  public:
+    Mmapped_File(int fd, uint64 size);
+    ~Mmapped_File() { if (ptr_) munmap(ptr_, size_); }
+    const uint8* ptr() const { return (const uint8*)ptr_; }
+    bool covers(uint64 pos, uint64 size) const { return ptr_ && pos + size <= size_; }
+    void will_need(uint64 pos, uint64 size) const;
+
+  private:
+    void* ptr_;
+    uint64 size_;
+};
+
+
 /** Simple RAII class to keep a pointer to some memory on the heap. */
 template < class T >
 class Void_Pointer
@@ -233,6 +269,39 @@ inline void Raw_File::seek(uint64 pos, const std::string& caller_id) const
     throw File_Error(errno, name, caller_id);
 }
 
+// Only a hint to the kernel to start reading ahead, hence errors are ignored.
+inline void Raw_File::will_need(uint64 pos, uint64 size) const
+{
+#ifdef POSIX_FADV_WILLNEED
+  posix_fadvise(fd_, pos, size, POSIX_FADV_WILLNEED);
+#endif
+}
+
+inline Mmapped_File::Mmapped_File(int fd, uint64 size) : ptr_(0), size_(size)
+{
+  if (fd < 0 || size == 0)
+    return;
+  ptr_ = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+  if (ptr_ == MAP_FAILED)
+    ptr_ = 0;
+}
+
+inline uint64 system_page_size()
+{
+  static const uint64 page_size = sysconf(_SC_PAGESIZE);
+  return page_size;
+}
+
+// Only a hint to the kernel to start reading ahead, hence errors are ignored.
+// madvise requires a page aligned address, and pages are larger than 4 KiB on some systems.
+inline void Mmapped_File::will_need(uint64 pos, uint64 size) const
+{
+  if (!ptr_ || pos >= size_)
+    return;
+  uint64 page_start = pos / system_page_size() * system_page_size();
+  madvise((uint8*)ptr_ + page_start, std::min(pos + size, size_) - page_start, MADV_WILLNEED);
+}
+
 //-----------------------------------------------------------------------------
 
 
@@ -274,10 +343,41 @@ inline void zero_padding(uint8* from, uint32 bytes)
 }
 
 
+/** Compares an index in its on-disk representation with a decoded index.
+ *
+ * Block_Backend uses this to skip the indices that it does not need without decoding them.
+ * The generic version decodes the index on the stack. Index types that allocate memory
+ * when they are decoded should specialize this template. */
+template< typename TIndex >
+struct Index_Data_Comparator
+{
+  // Returns true if the index at data is less than rhs
+  static bool less(void* data, const TIndex& rhs) { return TIndex(data) < rhs; }
+
+  // Returns true if the index at data is greater than rhs
+  static bool greater(void* data, const TIndex& rhs) { return rhs < TIndex(data); }
+
+  static bool equal(void* data, const TIndex& rhs) { return TIndex(data) == rhs; }
+};
+
+
+/** Compares a string of given length at data with rhs in the order of std::string. */
+inline int compare_string_data(const void* data, uint32 length, const std::string& rhs)
+{
+  int result = memcmp(data, rhs.data(), std::min((std::string::size_type)length, rhs.size()));
+  if (result != 0)
+    return result;
+  if (length < rhs.size())
+    return -1;
+  return (length > rhs.size() ? 1 : 0);
+}
+
+
 //-----------------------------------------------------------------------------
 
 
-int& global_read_counter();
+// Counts the blocks read by this process. Parallel reads and writes update it from several threads.
+std::atomic< int >& global_read_counter();
 
 
 void millisleep(uint32 milliseconds);
@@ -80,6 +80,57 @@ if [[ -n $RES || -s run/diff_updater_1/diff_stderr.log ]]; then
 }; fi
 
 
+# Test the index from members to their parents
+date +%T
+mkdir -p run/diff_updater_3/parent run/diff_updater_3/plain run/diff_updater_3/rebuilt
+rm -fR run/diff_updater_3/*/*
+$BASEDIR/test-bin/generate_test_file $DATA_SIZE >run/diff_updater_3/stdin.log
+$BASEDIR/test-bin/generate_test_file $DATA_SIZE diff_do >run/diff_updater_3/do_stdin.log
+$BASEDIR/test-bin/generate_test_file $DATA_SIZE diff_compare >run/diff_updater_3/compare_stdin.log
+cat >run/diff_updater_3/query.ql <<EOF
+node(5);way(bn);out ids;
+node(5);rel(bn);out ids;
+node(51.0,7.0,51.2,7.2);way(bn);out ids;
+node(51.0,7.0,51.2,7.2);rel(bn);out ids;
+way(51.0,7.0,51.2,7.2);rel(bw);out ids;
+node(51.0,7.0,51.2,7.2);rel(bn);rel(br);out ids;
+node(15);<;out ids;
+node(51.0,7.0,51.2,7.2);<<;out ids;
+way(5);<<;out ids;
+EOF
+
+# Apply the same diff to a database with and to one without the index
+for DB in parent plain; do
+{
+  if [[ $DB == "parent" ]]; then
+    PARENT_INDEX="--parent-index"
+  else
+    PARENT_INDEX=
+  fi
+  $BASEDIR/bin/update_database --db-dir=run/diff_updater_3/$DB/ --version=mock-up-init $PARENT_INDEX <run/diff_updater_3/stdin.log
+  $BASEDIR/bin/dispatcher --osm-base --db-dir=run/diff_updater_3/$DB/ &
+  sleep 1
+  $BASEDIR/bin/update_database --version=mock-up-diff <run/diff_updater_3/do_stdin.log
+  $BASEDIR/bin/dispatcher --osm-base --terminate
+  $BASEDIR/bin/osm3s_query --db-dir=run/diff_updater_3/$DB/ <run/diff_updater_3/query.ql >run/diff_updater_3/query_$DB.log
+}; done
+$BASEDIR/test-bin/compare_osm_base_maps --db-dir=run/diff_updater_3/parent/ --parent-index >run/diff_updater_3/parent_do.log 2>run/diff_updater_3/parent_stderr.log
+
+# The maintained index must equal the index of a fresh import of the same data
+$BASEDIR/bin/update_database --db-dir=run/diff_updater_3/rebuilt/ --parent-index <run/diff_updater_3/compare_stdin.log
+$BASEDIR/test-bin/compare_osm_base_maps --db-dir=run/diff_updater_3/rebuilt/ --parent-index >run/diff_updater_3/parent_compare.log 2>>run/diff_updater_3/parent_stderr.log
+
+# bn, bw, br, < and << must not depend on the index
+RES=`diff -q run/diff_updater_3/parent_compare.log run/diff_updater_3/parent_do.log; diff -q run/diff_updater_3/query_plain.log run/diff_updater_3/query_parent.log`
+if [[ -n $RES || -s run/diff_updater_3/parent_stderr.log || ! -s run/diff_updater_3/query_parent.log ]]; then
+{
+  echo `date +%T` "Test diff 3 FAILED."
+}; else
+{
+  echo `date +%T` "Test diff 3 succeeded."
+  rm -R run/diff_updater_3
+}; fi
+
 # Test the augmented diffs
 # turned off. Augmented diffs are now generated from the ordinary database.
 
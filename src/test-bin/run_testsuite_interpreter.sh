@@ -187,6 +187,77 @@ while [[ $II -lt 46 ]]; do
   II=$(($II + 1))
 }; done
 
+# The query server must take the client address only from the header of a trusted proxy
+# and reject requests without a usable client address, on both transports
+query_server_status()
+{
+  curl -s -o /dev/null -w "%{http_code}\n" --data-binary "data=out;" "$@"
+};
+
+start_query_server()
+{
+  $BASEDIR/bin/query_server "$@" &
+  QUERY_SERVER_PID=$!
+  sleep 1
+};
+
+stop_query_server()
+{
+  kill $QUERY_SERVER_PID
+  wait $QUERY_SERVER_PID
+};
+
+perform_test_query_server()
+{
+  EXEC="query_server"
+  I="1"
+  URL="http://127.0.0.1:18031/api/interpreter"
+
+  mkdir -p "run/${EXEC}_$I"
+  pushd "run/${EXEC}_$I/" >/dev/null
+  rm -f *
+  SOCKET="$(pwd)/query_server.socket"
+  {
+    echo "socket without client address header"
+    $BASEDIR/bin/query_server --socket=$SOCKET
+    echo "socket with client address header"
+    start_query_server --socket=$SOCKET --client-address-header=X-Real-IP --trusted-proxy=unix
+    query_server_status --unix-socket $SOCKET -H "X-Real-IP: 10.1.2.3" http://localhost/api/interpreter
+    query_server_status --unix-socket $SOCKET http://localhost/api/interpreter
+    query_server_status --unix-socket $SOCKET -H "X-Real-IP: 10.1.2.3, 10.4.5.6" http://localhost/api/interpreter
+    stop_query_server
+    echo "port without client address header"
+    start_query_server --port=18031
+    query_server_status $URL
+    query_server_status -H "X-Real-IP: forged" $URL
+    stop_query_server
+    echo "port with trusted proxy"
+    start_query_server --port=18031 --client-address-header=X-Real-IP --trusted-proxy=127.0.0.1
+    query_server_status -H "X-Real-IP: 10.1.2.3" $URL
+    query_server_status $URL
+    query_server_status -H "X-Forwarded-For: 10.1.2.3" $URL
+    query_server_status -H "X-Real-IP: 0.0.0.0" $URL
+    stop_query_server
+    echo "port with other proxy"
+    start_query_server --port=18031 --client-address-header=X-Real-IP --trusted-proxy=10.9.9.9
+    query_server_status -H "X-Real-IP: forged" $URL
+    stop_query_server
+  } >stdout.log 2>stderr.log
+  rm -f $SOCKET
+  evaluate_test "${EXEC}_$I"
+  if [[ -n $FAILED ]]; then
+  {
+    echo `date +%T` "Test $EXEC $I FAILED."
+  }; else
+  {
+    echo `date +%T` "Test $EXEC $I succeeded."
+    rm -R *
+  }; fi
+  popd >/dev/null
+};
+
+perform_test_query_server
+
 $BASEDIR/bin/dispatcher --terminate
 
 rm -fR input/update_database/*
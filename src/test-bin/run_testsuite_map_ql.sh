@@ -76,6 +76,12 @@ perform_test_map_ql()
     "$BASEDIR/bin/osm3s_query" "--dump-xml" <"../../input/osm3s_query_$I/stdin.log" >xml.out.log 2>xml.err.log
     "$BASEDIR/bin/osm3s_query" "--dump-pretty-ql" <"../../input/osm3s_query_$I/stdin.log" >pretty.out.log 2>pretty.err.log
     "$BASEDIR/bin/osm3s_query" "--dump-compact-ql" <"../../input/osm3s_query_$I/stdin.log" >compact.out.log 2>compact.err.log
+    if [[ -f "../../expected/osm3s_query_$I/eval.out.log" ]]; then
+    {
+      # Evaluated results make sure that constant folding gives the same as the evaluation per element
+      "$BASEDIR/bin/osm3s_query" "--db-dir=../../input/update_database/" <"../../input/osm3s_query_$I/stdin.log" 2>eval.err.log \
+          | sed 's/Overpass API [^ ]* [a-f0-9]*/Overpass API/g' >eval.out.log
+    }; fi
   }; else
   {
     echo "../../input/osm3s_query_$I/stdin.log missing"
@@ -101,7 +107,7 @@ $BASEDIR/bin/update_database --db-dir=input/update_database/ --version=mock-up-i
 # Test osm3s_query
 date +%T
 II=70
-while [[ $II -lt 134 ]]; do
+while [[ $II -lt 138 ]]; do
 {
   perform_test_map_ql $II
   II=$(($II + 1))
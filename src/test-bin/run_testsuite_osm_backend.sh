@@ -113,3 +113,26 @@ date +%T
 perform_serial_test run_and_compare.sh 3
 
 rm -R input/run_and_compare.sh_3
+
+# A PBF import must yield the same database as the XML import of the same data,
+# regardless of the number of threads that decode the blobs
+date +%T
+mkdir -p run/pbf_import_1
+rm -fR run/pbf_import_1/*
+mkdir -p run/pbf_import_1/xml run/pbf_import_1/pbf_1 run/pbf_import_1/pbf_n
+$BASEDIR/bin/update_database --db-dir=run/pbf_import_1/xml/ --meta <input/pbf_import_1/source.osm >/dev/null
+$BASEDIR/bin/update_database --db-dir=run/pbf_import_1/pbf_1/ --meta --pbf --read-threads=1 <input/pbf_import_1/source.osm.pbf >/dev/null
+$BASEDIR/bin/update_database --db-dir=run/pbf_import_1/pbf_n/ --meta --pbf --read-threads=4 <input/pbf_import_1/source.osm.pbf >/dev/null
+for DB in xml pbf_1 pbf_n; do
+{
+  echo '(node(-90,-180,90,180);<<;);out meta;' | $BASEDIR/bin/osm3s_query --db-dir=run/pbf_import_1/$DB/ >run/pbf_import_1/query_$DB.log 2>/dev/null
+}; done
+RES=`diff -q run/pbf_import_1/query_xml.log run/pbf_import_1/query_pbf_1.log; diff -q run/pbf_import_1/query_xml.log run/pbf_import_1/query_pbf_n.log`
+if [[ -n $RES || `grep -c "<relation" run/pbf_import_1/query_xml.log` -eq 0 ]]; then
+{
+  echo `date +%T` "Test pbf_import 1 FAILED."
+}; else
+{
+  echo `date +%T` "Test pbf_import 1 succeeded."
+  rm -R run/pbf_import_1
+}; fi
@@ -177,6 +177,8 @@ perform_test_loop block_backend 13
 date +%T
 perform_test_loop random_file 8
 date +%T
+perform_test_loop skeleton_format 6
+date +%T
 perform_test_loop test_dispatcher 20
 
 dispatcher_client_server 21
@@ -188,3 +190,5 @@ dispatcher_two_clients 26
 
 # don't use that test because we cannot control the assigned pids
 #dispatcher_two_clients 27
+
+perform_serial_test test_dispatcher 28